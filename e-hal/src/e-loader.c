@@ -35,6 +35,8 @@
 #include <fcntl.h>
 #include <err.h>
 #include <elf.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "e-hal.h"
 #include "epiphany-hal-api-local.h"
@@ -72,14 +74,61 @@ struct loader_cfg {
 	uint32_t __pad2;
 } __attribute__((packed));
 
+static const struct section_info image_sections[SEC_NUM] = {
+	[SEC_WORKGROUP_CFG] = { .name = "workgroup_cfg" },
+	[SEC_EXT_MEM_CFG]   = { .name = "ext_mem_cfg" },
+	[SEC_LOADER_CFG]    = { .name = "loader_cfg" },
+};
+
+enum image_dest {
+	IMAGE_DEST_LOCAL,		/* Core local address, written to every core */
+	IMAGE_DEST_ONCHIP,		/* Absolute address of a core on chip */
+	IMAGE_DEST_EMEM,		/* External memory */
+};
+
+/* Loadable segment of a parsed executable */
+struct image_segment {
+	enum image_dest  dest;
+	Elf32_Addr       vaddr;
+	uint32_t         filesz;
+	uint32_t         bsssz;		/* p_memsz - p_filesz */
+	bool             writable;	/* PF_W */
+	uint8_t         *data;		/* filesz bytes in e_image.data */
+};
+
+/* An executable parsed once, see e_image_open() */
+struct e_image {
+	char                 *path;
+	bool                  is_srec;
+	struct section_info   tbl[SEC_NUM];
+	unsigned              nsegs;
+	struct image_segment *segs;
+	uint8_t              *data;
+	/* Identity of the file the image was read from */
+	dev_t                 st_dev;
+	ino_t                 st_ino;
+	off_t                 st_size;
+	struct timespec       st_mtim;
+	unsigned              refcnt;	/* Protected by image_cache_lock */
+	/* Expected core SRAM contents, see image_prepare_sram() */
+	bool                  sram_prepared;
+	size_t                sram_size;
+	uint8_t              *sram;
+	bool                 *ro_chunk;	/* Chunk may be skipped if unchanged */
+};
+
 static void lookup_sections(const void *file, struct section_info *tbl,
 							size_t tbl_size);
 
 extern void ee_get_coords_from_id(e_epiphany_t *dev, unsigned coreid,
 								  unsigned *row, unsigned *col);
 
-static e_return_stat_t ee_process_elf(const void *file, e_epiphany_t *dev,
-									  e_mem_t *emem, int row, int col);
+static e_return_stat_t ee_process_image(const e_image_t *img, e_epiphany_t *dev,
+										e_mem_t *emem, int row, int col,
+										bool skip_local);
+
+static bool is_local(uint32_t addr);
+static bool is_valid_range(uint32_t from, uint32_t size);
 
 static int _ee_set_core_config(struct section_info *tbl, e_epiphany_t *dev,
 							   e_mem_t *emem, int row, int col);
@@ -116,10 +165,9 @@ int e_load(const char *executable, e_epiphany_t *dev,
 	return e_load_group(executable, dev, row, col, 1, 1, start);
 }
 
-static void clear_sram(e_epiphany_t *dev,
-					   unsigned row, unsigned col,unsigned rows, unsigned cols)
+static int clear_sram(e_epiphany_t *dev,
+					  unsigned row, unsigned col,unsigned rows, unsigned cols)
 {
-	unsigned i, j;
 	size_t sram_size;
 	void *empty;
 
@@ -129,9 +177,10 @@ static void clear_sram(e_epiphany_t *dev,
 	empty = alloca(sram_size);
 	memset(empty, 0, sram_size);
 
-	for (i = row; i < row + rows; i++)
-		for (j = col; j < col + cols; j++)
-			e_write(dev, i, j, 0, empty, sram_size);
+	if (ee_write_broadcast(dev, row, col, rows, cols, 0, empty, sram_size) == E_ERR)
+		return E_ERR;
+
+	return E_OK;
 }
 
 int e_load_group(const char *executable, e_epiphany_t *dev,
@@ -139,148 +188,927 @@ int e_load_group(const char *executable, e_epiphany_t *dev,
 				 unsigned rows, unsigned cols,
 				 e_bool_t start)
 {
-	if (e_platform.target_ops->load_group(executable, dev, row, col, rows, cols))
-		return E_ERR;
+	uint64_t t0;
+	int rc;
 
-	if (start)
-		return e_platform.target_ops->start_group(dev, row, col, rows, cols);
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->load_group(executable, dev, row, col, rows, cols);
+	if (rc == E_OK && start)
+		rc = e_platform.target_ops->start_group(dev, row, col, rows, cols);
+	ee_stats_end(E_OP_LOAD_GROUP, t0, 0, rc != E_OK);
 
-	return E_OK;
+	return (rc == E_OK) ? E_OK : E_ERR;
 }
 
-int _e_default_load_group(const char *executable, e_epiphany_t *dev,
-						  unsigned row, unsigned col,
-						  unsigned rows, unsigned cols)
-{
-	e_mem_t      emem;
-	unsigned int irow, icol, i;
-	int          status;
-	int          fd;
-	struct stat  st;
-	void        *file;
-	bool         is_srec = false;
-	e_return_stat_t retval;
+// Executable images
+//
+// An executable is parsed once into a list of loadable segments and the
+// addresses of the loader config sections. e_load_group() keeps the most
+// recently used images in a small cache keyed on path, inode and mtime, so
+// relaunching the same kernel doesn't touch the ELF file again.
 
-	struct section_info tbl[] = {
-		{ .name = "workgroup_cfg" },
-		{ .name = "ext_mem_cfg" },
-		{ .name = "loader_cfg" },
-	};
+#define IMAGE_CACHE_SIZE 8
 
+/* Most recently used first */
+static e_image_t *image_cache[IMAGE_CACHE_SIZE];
+static pthread_mutex_t image_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 
-#ifndef ESIM_TARGET
-	if (ee_esim_target_p()) {
-		warnx("e_load_group(): " EHAL_TARGET_ENV " environment variable set to esim but target not compiled in.");
-		return E_ERR;
-	}
-#endif
+static void image_free(e_image_t *img)
+{
+	free(img->sram);
+	free(img->ro_chunk);
+	free(img->segs);
+	free(img->data);
+	free(img->path);
+	free(img);
+}
 
-	status = E_OK;
+static int image_parse_elf(e_image_t *img, const void *file, size_t size)
+{
+	Elf32_Ehdr *ehdr;
+	Elf32_Phdr *phdr;
+	const uint8_t *src = (const uint8_t *) file;
+	struct image_segment *seg;
+	size_t      total;
+	uint8_t    *data;
+	int         ihdr;
+	unsigned    i;
 
-	if (!dev) {
-		warnx("ERROR: Can't connect to Epiphany or external memory.\n");
+	ehdr = (Elf32_Ehdr *) &src[0];
+	if (ehdr->e_phoff + (size_t) ehdr->e_phnum * sizeof(Elf32_Phdr) > size)
 		return E_ERR;
+	phdr = (Elf32_Phdr *) &src[ehdr->e_phoff];
+
+	total = 0;
+	for (ihdr = 0; ihdr < ehdr->e_phnum; ihdr++) {
+		/* Nothing to do if section is empty */
+		if (!phdr[ihdr].p_memsz)
+			continue;
+		if ((size_t) phdr[ihdr].p_offset + phdr[ihdr].p_filesz > size
+			|| phdr[ihdr].p_filesz > phdr[ihdr].p_memsz)
+			return E_ERR;
+		total += phdr[ihdr].p_filesz;
+		img->nsegs++;
 	}
 
-	// Allocate External DRAM for the epiphany executable code
-	// TODO: this is barely scalable. Really need to test ext. mem size to load
-	// and possibly split the ext. mem accesses into 1MB chunks.
-	if (e_alloc(&emem, 0, EMEM_SIZE)) {
-		warnx("\nERROR: Can't allocate external memory buffer!\n\n");
+	img->segs = calloc(img->nsegs ? img->nsegs : 1, sizeof(*img->segs));
+	img->data = malloc(total ? total : 1);
+	if (!img->segs || !img->data)
 		return E_ERR;
+
+	data = img->data;
+	for (ihdr = 0, i = 0; ihdr < ehdr->e_phnum; ihdr++) {
+		if (!phdr[ihdr].p_memsz)
+			continue;
+
+		seg = &img->segs[i++];
+		seg->vaddr  = phdr[ihdr].p_vaddr;
+		seg->filesz = phdr[ihdr].p_filesz;
+		seg->bsssz  = phdr[ihdr].p_memsz - phdr[ihdr].p_filesz;
+		seg->writable = !!(phdr[ihdr].p_flags & PF_W);
+		seg->data   = data;
+		memcpy(data, &src[phdr[ihdr].p_offset], seg->filesz);
+		data += seg->filesz;
+
+		if (is_local(seg->vaddr))
+			seg->dest = IMAGE_DEST_LOCAL;
+		/* TODO: Don't cast to void */
+		else if (e_is_addr_on_chip((void *) ((uintptr_t) seg->vaddr)))
+			seg->dest = IMAGE_DEST_ONCHIP;
+		else
+			seg->dest = IMAGE_DEST_EMEM;
+	}
+
+	lookup_sections(file, img->tbl, ARRAY_SIZE(img->tbl));
+
+	return E_OK;
+}
+
+static e_image_t *image_read(const char *executable)
+{
+	e_image_t  *img;
+	int         fd;
+	struct stat st;
+	void       *file;
+	unsigned    i;
+
+	if (e_platform.initialized == E_FALSE) {
+		warnx("e_load_group(): Platform was not initialized. Use e_init().");
+		return NULL;
 	}
 
 	fd = open(executable, O_RDONLY);
 	if (fd == -1) {
 		warnx("ERROR: Can't open executable file \"%s\".\n", executable);
-		e_free(&emem);
-		return E_ERR;
+		return NULL;
 	}
 
 	if (fstat(fd, &st) == -1) {
 		warnx("ERROR: Can't stat file \"%s\".\n", executable);
 		close(fd);
-		e_free(&emem);
-		return E_ERR;
-    }
+		return NULL;
+	}
 
 	file = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 	if (file == MAP_FAILED) {
 		warnx("ERROR: Can't mmap file \"%s\".\n", executable);
 		close(fd);
-		e_free(&emem);
-		return E_ERR;
-    }
+		return NULL;
+	}
+
+	img = calloc(1, sizeof(*img));
+	if (img)
+		img->path = strdup(executable);
+	if (!img || !img->path) {
+		warnx("ERROR: Can't allocate image for \"%s\".\n", executable);
+		free(img);
+		img = NULL;
+		goto out;
+	}
+
+	img->st_dev  = st.st_dev;
+	img->st_ino  = st.st_ino;
+	img->st_size = st.st_size;
+	img->st_mtim = st.st_mtim;
+	memcpy(img->tbl, image_sections, sizeof(img->tbl));
 
 	if (is_epiphany_exec_elf((Elf32_Ehdr *) file)) {
 		diag(L_D1) { fprintf(diag_fd, "e_load_group(): loading ELF file %s ...\n", executable); }
+		if (image_parse_elf(img, file, st.st_size) != E_OK) {
+			warnx("ERROR: Can't load executable file \"%s\".\n", executable);
+			image_free(img);
+			img = NULL;
+			goto out;
+		}
 	} else if (is_srec_file((char *) file)) {
-		is_srec = true;
+		img->is_srec = true;
 		warnx("e_load_group(): WARNING: SREC file support is deprecated and will be removed in the next ESDK release. Use ELF format instead.\n");
+
+		/* No symbol info in SREC files, use hard coded values */
+		img->tbl[SEC_WORKGROUP_CFG].present = true;
+		img->tbl[SEC_WORKGROUP_CFG].sh_addr = 0x28;
+		img->tbl[SEC_EXT_MEM_CFG].present   = true;
+		img->tbl[SEC_EXT_MEM_CFG].sh_addr   = 0x50;
+		img->tbl[SEC_LOADER_CFG].present    = true;
+		img->tbl[SEC_LOADER_CFG].sh_addr    = 0x58;
 	} else {
 		diag(L_D1) { fprintf(diag_fd, "e_load_group(): ERROR: unidentified file format\n"); }
 		warnx("ERROR: Can't load executable file: unidentified format.\n");
-		status = E_ERR;
+		image_free(img);
+		img = NULL;
 		goto out;
 	}
 
-	if (is_srec) {
-		/* No symbol info in SREC files, use hard coded values */
-		tbl[SEC_WORKGROUP_CFG].present = true;
-		tbl[SEC_WORKGROUP_CFG].sh_addr = 0x28;
-		tbl[SEC_EXT_MEM_CFG].present   = true;
-		tbl[SEC_EXT_MEM_CFG].sh_addr   = 0x50;
-		tbl[SEC_LOADER_CFG].present    = true;
-		tbl[SEC_LOADER_CFG].sh_addr    = 0x58;
-	} else {
-		lookup_sections(file, tbl, ARRAY_SIZE(tbl));
-	}
-
 	for (i = 0; i < SEC_NUM; i++) {
-		if (!tbl[i].present) {
+		if (!img->tbl[i].present) {
 			warnx("e_load_group(): WARNING: %s section not in binary.",
-				  tbl[i].name);
+				  img->tbl[i].name);
 		}
 	}
 
-	for (irow=row; irow<(row+rows); irow++) {
-		for (icol=col; icol<(col+cols); icol++) {
-			if (ee_soft_reset_core(dev, irow, icol) != E_OK) {
-				status = E_ERR;
-				goto out;
-			}
+out:
+	munmap(file, st.st_size);
+	close(fd);
+
+	return img;
+}
+
+static bool image_matches(const e_image_t *img, const char *executable,
+						  const struct stat *st)
+{
+	return img->st_dev == st->st_dev
+		&& img->st_ino == st->st_ino
+		&& img->st_size == st->st_size
+		&& img->st_mtim.tv_sec == st->st_mtim.tv_sec
+		&& img->st_mtim.tv_nsec == st->st_mtim.tv_nsec
+		&& strcmp(img->path, executable) == 0;
+}
+
+/* Drop a reference to an image */
+static void image_put(e_image_t *img)
+{
+	bool last;
+
+	pthread_mutex_lock(&image_cache_lock);
+	last = !--img->refcnt;
+	pthread_mutex_unlock(&image_cache_lock);
+
+	if (last)
+		image_free(img);
+}
+
+/* Remove entry i from the cache. Called with image_cache_lock held. Returns
+ * the image if the cache held the last reference. */
+static e_image_t *image_cache_remove(unsigned i)
+{
+	e_image_t *img = image_cache[i];
+
+	memmove(&image_cache[i], &image_cache[i + 1],
+			(IMAGE_CACHE_SIZE - i - 1) * sizeof(image_cache[0]));
+	image_cache[IMAGE_CACHE_SIZE - 1] = NULL;
+
+	return --img->refcnt ? NULL : img;
+}
+
+/* Get a referenced image for executable, reading it if it isn't cached or
+ * the file has changed since. */
+static e_image_t *image_cache_get(const char *executable)
+{
+	e_image_t  *img, *dead[IMAGE_CACHE_SIZE];
+	struct stat st;
+	unsigned    i, ndead = 0;
+
+	if (stat(executable, &st) == -1) {
+		warnx("ERROR: Can't open executable file \"%s\".\n", executable);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&image_cache_lock);
+	for (i = 0; i < IMAGE_CACHE_SIZE && image_cache[i]; i++) {
+		img = image_cache[i];
+		if (!image_matches(img, executable, &st))
+			continue;
+
+		memmove(&image_cache[1], &image_cache[0], i * sizeof(image_cache[0]));
+		image_cache[0] = img;
+		img->refcnt++;
+		pthread_mutex_unlock(&image_cache_lock);
+
+		diag(L_D2) { fprintf(diag_fd, "e_load_group(): using cached image of %s\n", executable); }
+		return img;
+	}
+	pthread_mutex_unlock(&image_cache_lock);
+
+	img = image_read(executable);
+	if (!img)
+		return NULL;
+
+	pthread_mutex_lock(&image_cache_lock);
+	/* Evict stale images of the same file, and the least recently used
+	 * image if the cache is full */
+	for (i = 0; i < IMAGE_CACHE_SIZE && image_cache[i]; ) {
+		if (strcmp(image_cache[i]->path, executable) == 0) {
+			if ((dead[ndead] = image_cache_remove(i)))
+				ndead++;
+		} else {
+			i++;
 		}
 	}
+	if (image_cache[IMAGE_CACHE_SIZE - 1])
+		if ((dead[ndead] = image_cache_remove(IMAGE_CACHE_SIZE - 1)))
+			ndead++;
+
+	memmove(&image_cache[1], &image_cache[0],
+			(IMAGE_CACHE_SIZE - 1) * sizeof(image_cache[0]));
+	image_cache[0] = img;
+	img->refcnt = 2;	/* Cache + caller */
+	pthread_mutex_unlock(&image_cache_lock);
+
+	for (i = 0; i < ndead; i++)
+		image_free(dead[i]);
+
+	return img;
+}
+
+e_image_t *e_image_open(const char *executable)
+{
+	e_image_t *img;
+
+	img = image_read(executable);
+	if (img)
+		img->refcnt = 1;
+
+	return img;
+}
+
+int e_image_close(e_image_t *img)
+{
+	if (!img) {
+		warnx("e_image_close(): Invalid image.");
+		return E_ERR;
+	}
+
+	image_put(img);
+
+	return E_OK;
+}
+
+// Loading is split in phases. Every phase completes on all cores before the
+// next one starts, so all cores are reset before any core is written, and
+// core config is written after all segments (which may target other cores'
+// SRAM or external memory).
+enum load_phase {
+	LOAD_RESET,
+	LOAD_CLEAR,
+	LOAD_SEGMENTS,
+	LOAD_VERIFY,
+	LOAD_CONFIG,
+	LOAD_NUM_PHASES,
+};
+
+static const char *load_phase_name[LOAD_NUM_PHASES] = {
+	"reset", "clear", "segments", "verify", "config",
+};
 
-	clear_sram(dev, row, col, rows, cols);
+#define LOAD_MAX_THREADS EE_ROW_MAX_THREADS
+
+struct load_job {
+	e_image_t           *img;
+	e_epiphany_t        *dev;
+	e_mem_t             *emem;
+	unsigned             row, col, rows, cols;
+	unsigned             first, stride;		/* Rows handled by this job */
+	bool                 diff;				/* EHAL_LOAD_DIFF */
+	enum load_phase      phase;
+	int                  status;
+};
+
+// Number of worker threads for loading, from EHAL_LOAD_THREADS. Zero or
+// unset means load serially in the calling thread.
+static unsigned load_threads()
+{
+	return ee_row_threads();
+}
+
+// Diff loading (EHAL_LOAD_DIFF)
+//
+// Instead of clearing all of SRAM and then writing the segments on top,
+// each core gets a single pass over its expected SRAM image: zeroes plus
+// the core local segments. The loader keeps a host side shadow of what it
+// last wrote to every core and skips chunks of read-only segments that
+// already hold the right bytes. Writable segments, BSS and unused ranges
+// (e.g. the stack) are always rewritten, since a kernel that ran may have
+// changed them. With EHAL_LOAD_VERIFY set, SRAM is read back before the
+// core config is written and compared against the expected image.
+//
+// Once the load of a core is done its shadow is sealed and the HAL starts
+// tracking the SRAM range that e_write() and friends and core resets touch
+// in this process. Chunks overlapping that range are rewritten on the next
+// load; a system reset drops the whole shadow. Opening and closing the
+// workgroup leaves the shadow alone. The loader can't see changes made from
+// outside this process, e.g. another process loading the same cores, or a
+// kernel writing to its own read-only sections. Set EHAL_LOAD_VERIFY, or
+// leave EHAL_LOAD_DIFF unset, when that can happen.
+
+#define DIFF_CHUNK		64
+#define DIFF_MAX_CORES	4096	/* 12-bit core IDs */
+
+struct core_shadow {
+	bool      valid;
+	bool      sealed;			/* load finished, dirty range cleared */
+	unsigned  resets;			/* ee_system_reset_count() when written */
+	size_t    size;
+	uint8_t   sram[];
+};
+
+/* Each core is only ever touched by one loader thread at a time */
+static struct core_shadow *core_shadows[DIFF_MAX_CORES];
+
+static bool load_env_p(const char *name)
+{
+	const char *p = getenv(name);
+
+	return p && p[0] != '\0' && strcmp(p, "0") != 0;
+}
 
-	for (irow=row; irow<(row+rows); irow++) {
-		for (icol=col; icol<(col+cols); icol++) {
-			if (is_srec)
-				retval = ee_process_SREC(executable, dev, &emem, irow, icol);
-			else
-				retval = ee_process_elf(file, dev, &emem, irow, icol);
+static bool load_diff_p()
+{
+	static bool initialized = false;
+	static bool diff = false;
+
+	if (!initialized) {
+		diff = load_env_p("EHAL_LOAD_DIFF");
+		initialized = true;
+	}
+
+	return diff;
+}
+
+static bool load_verify_p()
+{
+	static bool initialized = false;
+	static bool verify = false;
+
+	if (!initialized) {
+		verify = load_env_p("EHAL_LOAD_VERIFY");
+		initialized = true;
+	}
+
+	return verify;
+}
+
+static void chunks_clear(bool *chunk, size_t from, size_t size, size_t limit)
+{
+	size_t i;
+
+	for (i = from / DIFF_CHUNK; i * DIFF_CHUNK < from + size && i * DIFF_CHUNK < limit; i++)
+		chunk[i] = false;
+}
+
+// Build the expected SRAM image of a core. Returns false if the image can't
+// be described per core, e.g. when it writes to other cores' SRAM.
+static bool image_prepare_sram(e_image_t *img)
+{
+	const struct image_segment *seg;
+	size_t   sram_size, i, c, first, last;
+	bool     ok = true;
+
+	pthread_mutex_lock(&image_cache_lock);
+	if (img->sram_prepared)
+		goto out;
+
+	/* Assume one chip type */
+	sram_size = e_platform.chip[0].sram_size;
+
+	if (img->is_srec || sram_size % DIFF_CHUNK)
+		goto out;
+
+	for (i = 0; i < img->nsegs; i++) {
+		seg = &img->segs[i];
+		if (seg->dest == IMAGE_DEST_ONCHIP)
+			goto out;
+		if (seg->dest == IMAGE_DEST_LOCAL
+			&& (size_t) seg->vaddr + seg->filesz + seg->bsssz > sram_size)
+			goto out;
+	}
+
+	img->sram     = calloc(1, sram_size);
+	img->ro_chunk = calloc(sram_size / DIFF_CHUNK, sizeof(bool));
+	if (!img->sram || !img->ro_chunk) {
+		free(img->sram);
+		free(img->ro_chunk);
+		img->sram = NULL;
+		img->ro_chunk = NULL;
+		goto out;
+	}
+	img->sram_size = sram_size;
+
+	for (i = 0; i < img->nsegs; i++) {
+		seg = &img->segs[i];
+		if (seg->dest != IMAGE_DEST_LOCAL)
+			continue;
+
+		memcpy(&img->sram[seg->vaddr], seg->data, seg->filesz);
+
+		/* Only chunks entirely inside a read-only segment may be skipped */
+		if (seg->writable || seg->filesz < DIFF_CHUNK)
+			continue;
+		first = (seg->vaddr + DIFF_CHUNK - 1) / DIFF_CHUNK;
+		last  = (seg->vaddr + seg->filesz) / DIFF_CHUNK;
+		for (c = first; c < last; c++)
+			img->ro_chunk[c] = true;
+	}
+
+	/* ... except where the soft reset payload or the config goes */
+	chunks_clear(img->ro_chunk, 0, ee_soft_reset_payload_size(), sram_size);
+	if (img->tbl[SEC_WORKGROUP_CFG].present)
+		chunks_clear(img->ro_chunk, img->tbl[SEC_WORKGROUP_CFG].sh_addr,
+					 sizeof(e_group_config_t), sram_size);
+	if (img->tbl[SEC_EXT_MEM_CFG].present)
+		chunks_clear(img->ro_chunk, img->tbl[SEC_EXT_MEM_CFG].sh_addr,
+					 sizeof(e_emem_config_t), sram_size);
+	if (img->tbl[SEC_LOADER_CFG].present)
+		chunks_clear(img->ro_chunk, img->tbl[SEC_LOADER_CFG].sh_addr,
+					 sizeof(struct loader_cfg), sram_size);
+
+out:
+	img->sram_prepared = true;
+	ok = img->sram != NULL;
+	pthread_mutex_unlock(&image_cache_lock);
+
+	return ok;
+}
+
+static struct core_shadow *core_shadow(e_epiphany_t *dev, unsigned row, unsigned col)
+{
+	return core_shadows[dev->core[row][col].id % DIFF_MAX_CORES];
+}
+
+static void core_shadow_invalidate(e_epiphany_t *dev, unsigned row, unsigned col)
+{
+	struct core_shadow *shadow = core_shadow(dev, row, col);
 
-			if (retval == E_ERR) {
-				warnx("ERROR: Can't load executable file \"%s\".\n", executable);
-				status = E_ERR;
-				goto out;
+	if (shadow)
+		shadow->valid = false;
+}
+
+static void core_shadow_update(const e_image_t *img, e_epiphany_t *dev,
+							   unsigned row, unsigned col)
+{
+	unsigned id = dev->core[row][col].id % DIFF_MAX_CORES;
+	struct core_shadow *shadow = core_shadows[id];
+
+	if (!shadow || shadow->size != img->sram_size) {
+		free(shadow);
+		shadow = malloc(sizeof(*shadow) + img->sram_size);
+		core_shadows[id] = shadow;
+		if (!shadow)
+			return;
+		shadow->size = img->sram_size;
+	}
+
+	memcpy(shadow->sram, img->sram, img->sram_size);
+	shadow->resets = ee_system_reset_count();
+	shadow->valid  = true;
+	shadow->sealed = false;
+}
+
+// Called when the load of a core is complete, after the loader's own writes
+static void core_shadow_seal(e_epiphany_t *dev, unsigned row, unsigned col)
+{
+	struct core_shadow *shadow = core_shadow(dev, row, col);
+
+	if (!shadow || !shadow->valid)
+		return;
+
+	ee_core_dirty_clear(dev->core[row][col].id);
+	shadow->sealed = true;
+}
+
+// Release the image cache and the load shadows. Called from e_finalize().
+// Images the application still holds from e_image_open() stay valid until
+// it closes them.
+void ee_loader_finalize()
+{
+	e_image_t *dead[IMAGE_CACHE_SIZE];
+	unsigned   i, ndead = 0;
+
+	pthread_mutex_lock(&image_cache_lock);
+	while (image_cache[0])
+		if ((dead[ndead] = image_cache_remove(0)))
+			ndead++;
+	pthread_mutex_unlock(&image_cache_lock);
+
+	for (i = 0; i < ndead; i++)
+		image_free(dead[i]);
+
+	for (i = 0; i < DIFF_MAX_CORES; i++) {
+		free(core_shadows[i]);
+		core_shadows[i] = NULL;
+	}
+}
+
+static bool chunk_resident(const e_image_t *img, const struct core_shadow *shadow,
+						   size_t dirty_lo, size_t dirty_hi, size_t c)
+{
+	return shadow && img->ro_chunk[c]
+		&& ((c + 1) * DIFF_CHUNK <= dirty_lo || c * DIFF_CHUNK >= dirty_hi)
+		&& !memcmp(&shadow->sram[c * DIFF_CHUNK], &img->sram[c * DIFF_CHUNK], DIFF_CHUNK);
+}
+
+// Write the expected SRAM image to a core, skipping resident chunks
+static int diff_load_core(const e_image_t *img, e_epiphany_t *dev,
+						  unsigned row, unsigned col)
+{
+	struct core_shadow *shadow = core_shadow(dev, row, col);
+	size_t nchunks, c, start, lo, hi, written = 0;
+
+	if (shadow && (!shadow->valid || !shadow->sealed
+				   || shadow->size != img->sram_size
+				   || shadow->resets != ee_system_reset_count()))
+		shadow = NULL;
+
+	/* Chunks written since the shadow was sealed are stale */
+	ee_core_dirty_range(dev->core[row][col].id, &lo, &hi);
+
+	nchunks = img->sram_size / DIFF_CHUNK;
+	for (c = 0; c < nchunks; ) {
+		if (chunk_resident(img, shadow, lo, hi, c)) {
+			c++;
+			continue;
+		}
+
+		for (start = c; c < nchunks && !chunk_resident(img, shadow, lo, hi, c); c++)
+			;
+
+		if (e_write(dev, row, col, start * DIFF_CHUNK, &img->sram[start * DIFF_CHUNK],
+					(c - start) * DIFF_CHUNK) == E_ERR) {
+			core_shadow_invalidate(dev, row, col);
+			return E_ERR;
+		}
+		written += (c - start) * DIFF_CHUNK;
+	}
+
+	diag(L_D2) { fprintf(diag_fd, "e_load_group(): core (%d,%d): wrote %u of %u SRAM bytes\n", row, col, (unsigned) written, (unsigned) img->sram_size); }
+
+	core_shadow_update(img, dev, row, col);
+
+	return E_OK;
+}
+
+// Compare core SRAM against the expected image and repair it on mismatch
+static int verify_core(const e_image_t *img, e_epiphany_t *dev,
+					   unsigned row, unsigned col)
+{
+	uint8_t *buf;
+	size_t   i;
+	int      status = E_OK;
+
+	buf = malloc(img->sram_size);
+	if (!buf)
+		return E_ERR;
+
+	if (e_read(dev, row, col, 0, buf, img->sram_size) == E_ERR) {
+		free(buf);
+		return E_ERR;
+	}
+
+	for (i = 0; i < img->sram_size && buf[i] == img->sram[i]; i++)
+		;
+
+	if (i != img->sram_size) {
+		warnx("e_load_group(): core (%d,%d): SRAM differs from image at 0x%04x, rewriting.",
+			  row, col, (unsigned) i);
+		if (e_write(dev, row, col, 0, img->sram, img->sram_size) == E_ERR)
+			status = E_ERR;
+		core_shadow_update(img, dev, row, col);
+	}
+
+	free(buf);
+
+	return status;
+}
+
+// Core local segments that fit in SRAM are broadcast. Anything else keeps
+// going through ee_process_image(), which writes it like it always did.
+static bool seg_broadcast_p(const struct image_segment *seg)
+{
+	/* Assume one chip type */
+	return seg->dest == IMAGE_DEST_LOCAL
+		&& (size_t) seg->vaddr + seg->filesz <= e_platform.chip[0].sram_size;
+}
+
+// Write the core local segments of an image to a rectangle of cores
+static int broadcast_image(const e_image_t *img, e_epiphany_t *dev,
+						   unsigned row, unsigned col,
+						   unsigned rows, unsigned cols)
+{
+	const struct image_segment *seg;
+	unsigned i;
+
+	for (i = 0; i < img->nsegs; i++) {
+		seg = &img->segs[i];
+		if (!seg_broadcast_p(seg) || !seg->filesz)
+			continue;
+
+		diag(L_D3) { fprintf(diag_fd, "broadcast_image(): copying %d bytes to 0x%08x on rows %u-%u\n", seg->filesz, seg->vaddr, row, row + rows - 1); }
+
+		if (ee_write_broadcast(dev, row, col, rows, cols, seg->vaddr,
+							   seg->data, seg->filesz) == E_ERR)
+			return E_ERR;
+	}
+
+	return E_OK;
+}
+
+static int load_rows(struct load_job *job)
+{
+	unsigned irow, icol;
+	e_return_stat_t retval;
+
+	for (irow = job->row + job->first; irow < job->row + job->rows; irow += job->stride) {
+		if (job->phase == LOAD_CLEAR && !job->diff) {
+			if (clear_sram(job->dev, irow, job->col, 1, job->cols) != E_OK)
+				return E_ERR;
+			for (icol = job->col; icol < job->col + job->cols; icol++)
+				core_shadow_invalidate(job->dev, irow, icol);
+			continue;
+		}
+
+		// Core local segments are the same on every core, so they go out
+		// to the whole row at once. Only the remaining segments are
+		// processed per core.
+		if (job->phase == LOAD_SEGMENTS && !job->img->is_srec && !job->diff) {
+			if (broadcast_image(job->img, job->dev, irow, job->col, 1, job->cols) != E_OK) {
+				warnx("ERROR: Can't load executable file \"%s\".\n", job->img->path);
+				return E_ERR;
 			}
+		}
 
-			_ee_set_core_config(tbl, dev, &emem, irow, icol);
+		for (icol = job->col; icol < job->col + job->cols; icol++) {
+			switch (job->phase) {
+			case LOAD_RESET:
+				if (ee_soft_reset_core(job->dev, irow, icol) != E_OK)
+					return E_ERR;
+				break;
+
+			case LOAD_CLEAR:
+				if (diff_load_core(job->img, job->dev, irow, icol) != E_OK)
+					return E_ERR;
+				break;
+
+			case LOAD_SEGMENTS:
+				if (job->img->is_srec)
+					retval = ee_process_SREC(job->img->path, job->dev, job->emem, irow, icol);
+				else
+					retval = ee_process_image(job->img, job->dev, job->emem, irow, icol, true);
+
+				if (retval == E_ERR) {
+					warnx("ERROR: Can't load executable file \"%s\".\n", job->img->path);
+					return E_ERR;
+				}
+				break;
+
+			case LOAD_VERIFY:
+				if (verify_core(job->img, job->dev, irow, icol) != E_OK)
+					return E_ERR;
+				break;
+
+			case LOAD_CONFIG:
+				_ee_set_core_config(job->img->tbl, job->dev, job->emem, irow, icol);
+				if (job->diff)
+					core_shadow_seal(job->dev, irow, icol);
+				break;
+
+			default:
+				return E_ERR;
+			}
 		}
 	}
 
-	diag(L_D1) { fprintf(diag_fd, "%s(): done loading.\n", __func__); }
+	return E_OK;
+}
+
+static void *load_rows_thread(void *arg)
+{
+	struct load_job *job = arg;
+
+	job->status = load_rows(job);
+
+	return NULL;
+}
+
+// Run one phase on all jobs and wait for them to finish.
+static int load_phase(struct load_job *jobs, pthread_t *threads,
+					  unsigned njobs, enum load_phase phase)
+{
+	unsigned i, started;
+	int status = E_OK;
+
+	for (i = 0; i < njobs; i++)
+		jobs[i].phase = phase;
+
+	if (njobs == 1)
+		return load_rows(&jobs[0]);
+
+	for (started = 0; started < njobs; started++) {
+		if (pthread_create(&threads[started], NULL, load_rows_thread, &jobs[started])) {
+			warnx("e_load_group(): Can't create loader thread.");
+			status = E_ERR;
+			break;
+		}
+	}
+
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+		if (jobs[i].status != E_OK)
+			status = E_ERR;
+	}
+
+	return status;
+}
+
+static double elapsed_ms(const struct timespec *from, const struct timespec *to)
+{
+	return (to->tv_sec - from->tv_sec) * 1e3
+		 + (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
+static int ee_load_image_group(e_image_t *img, e_epiphany_t *dev,
+							   unsigned row, unsigned col,
+							   unsigned rows, unsigned cols)
+{
+	e_mem_t      emem;
+	unsigned int i, njobs;
+	int          status;
+	bool         diff, verify;
+	enum load_phase phase;
+	struct timespec t0, t1;
+	struct load_job jobs[LOAD_MAX_THREADS];
+	pthread_t    threads[LOAD_MAX_THREADS];
+
+#ifndef ESIM_TARGET
+	if (ee_esim_target_p()) {
+		warnx("e_load_group(): " EHAL_TARGET_ENV " environment variable set to esim but target not compiled in.");
+		return E_ERR;
+	}
+#endif
+
+	if (!dev) {
+		warnx("ERROR: Can't connect to Epiphany or external memory.\n");
+		return E_ERR;
+	}
+
+	/* Range-check segments */
+	for (i = 0; i < img->nsegs; i++) {
+		if (!is_valid_range(img->segs[i].vaddr, img->segs[i].filesz + img->segs[i].bsssz)) {
+			warnx("ERROR: Can't load executable file \"%s\".\n", img->path);
+			return E_ERR;
+		}
+	}
+
+	// Allocate External DRAM for the epiphany executable code
+	// TODO: this is barely scalable. Really need to test ext. mem size to load
+	// and possibly split the ext. mem accesses into 1MB chunks.
+	if (e_alloc(&emem, 0, EMEM_SIZE)) {
+		warnx("\nERROR: Can't allocate external memory buffer!\n\n");
+		return E_ERR;
+	}
+
+	// Parallel loading spreads the rows over a pool of worker threads. The
+	// simulator and the SREC parser are not thread safe, so they always run
+	// serially.
+	njobs = load_threads();
+	if (njobs > rows)
+		njobs = rows;
+	if (!njobs || img->is_srec || ee_esim_target_p())
+		njobs = 1;
+
+	// Images that write to other cores' SRAM are always loaded the
+	// traditional way.
+	diff   = load_diff_p() && image_prepare_sram(img);
+	verify = load_verify_p() && image_prepare_sram(img);
+
+	for (i = 0; i < njobs; i++) {
+		jobs[i] = (struct load_job) {
+			.img        = img,
+			.dev        = dev,
+			.emem       = &emem,
+			.row = row, .col = col, .rows = rows, .cols = cols,
+			.first      = i,
+			.stride     = njobs,
+			.diff       = diff,
+			.status     = E_OK,
+		};
+	}
+
+	for (phase = 0; phase < LOAD_NUM_PHASES; phase++) {
+		if (phase == LOAD_VERIFY && !verify)
+			continue;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		status = load_phase(jobs, threads, njobs, phase);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		diag(L_D1) { fprintf(diag_fd, "e_load_group(): %s phase took %.3f ms (%u thread%s)\n", load_phase_name[phase], elapsed_ms(&t0, &t1), njobs, njobs == 1 ? "" : "s"); }
+
+		if (status != E_OK)
+			break;
+	}
+
+	if (status == E_OK)
+		diag(L_D1) { fprintf(diag_fd, "e_load_group(): done loading.\n"); }
 
-out:
-	munmap(file, st.st_size);
-	close(fd);
 	e_free(&emem);
 
 	return status;
 }
 
+int _e_default_load_group(const char *executable, e_epiphany_t *dev,
+						  unsigned row, unsigned col,
+						  unsigned rows, unsigned cols)
+{
+	e_image_t *img;
+	int        status;
+
+	img = image_cache_get(executable);
+	if (!img)
+		return E_ERR;
+
+	status = ee_load_image_group(img, dev, row, col, rows, cols);
+
+	image_put(img);
+
+	return status;
+}
+
+int e_image_load_group(e_image_t *img, e_epiphany_t *dev,
+					   unsigned row, unsigned col,
+					   unsigned rows, unsigned cols,
+					   e_bool_t start)
+{
+	int status;
+
+	if (!img) {
+		warnx("e_image_load_group(): Invalid image.");
+		return E_ERR;
+	}
+
+	// Targets with their own loader only get to see the path
+	if (e_platform.target_ops->load_group == _e_default_load_group)
+		status = ee_load_image_group(img, dev, row, col, rows, cols);
+	else
+		status = e_platform.target_ops->load_group(img->path, dev, row, col, rows, cols);
+
+	if (status != E_OK)
+		return E_ERR;
+
+	if (start)
+		return e_platform.target_ops->start_group(dev, row, col, rows, cols);
+
+	return E_OK;
+}
+
 static void lookup_sections(const void *file, struct section_info *tbl,
 							size_t tbl_size)
 {
@@ -432,90 +1260,76 @@ static bool is_valid_range(uint32_t from, uint32_t size)
 
 
 static e_return_stat_t
-ee_process_elf(const void *file, e_epiphany_t *dev, e_mem_t *emem,
-			   int row, int col)
+ee_process_image(const e_image_t *img, e_epiphany_t *dev, e_mem_t *emem,
+				 int row, int col, bool skip_local)
 {
-	Elf32_Ehdr *ehdr;
-	Elf32_Phdr *phdr;
-	bool       islocal, isonchip;
-	int        ihdr;
+	const struct image_segment *seg;
+	unsigned   i;
 	unsigned   globrow, globcol;
 	unsigned   coreid;
 	uintptr_t  dst;
-	/* TODO: Make src const (need fix in esim.h first) */
-	uint8_t   *src = (uint8_t *) file;
-
-	islocal  = false;
-	isonchip = false;
-
-	ehdr = (Elf32_Ehdr *) &src[0];
-	phdr = (Elf32_Phdr *) &src[ehdr->e_phoff];
 
-	/* Range-check sections */
-	for (ihdr = 0; ihdr < ehdr->e_phnum; ihdr++) {
-		if (!is_valid_range(phdr[ihdr].p_vaddr, phdr[ihdr].p_memsz))
-			return E_ERR;
-	}
+	for (i = 0; i < img->nsegs; i++) {
+		seg = &img->segs[i];
 
-	for (ihdr = 0; ihdr < ehdr->e_phnum; ihdr++) {
-		/* Nothing to do if section is empty */
-		if (!phdr[ihdr].p_memsz)
+		/* Already written by broadcast_image() or diff_load_core() */
+		if (skip_local && seg_broadcast_p(seg))
 			continue;
 
-		islocal = is_local(phdr[ihdr].p_vaddr);
-		isonchip = islocal ? true
-						   /* TODO: Don't cast to void */
-						   : e_is_addr_on_chip((void *) ((uintptr_t) phdr[ihdr].p_vaddr));
-
 		diag(L_D3) {
-			fprintf(diag_fd, "ee_process_elf(): copying the data (%d bytes)",
-					phdr[ihdr].p_filesz); }
+			fprintf(diag_fd, "ee_process_image(): copying the data (%d bytes)",
+					seg->filesz); }
 
 		/* Address calculation */
 		if (ee_esim_target_p()) {
-			dst = phdr[ihdr].p_vaddr;
-			dst = islocal ? dst | dev->core[row][col].id << 20 : dst;
+			dst = seg->vaddr;
+			dst = seg->dest == IMAGE_DEST_LOCAL
+				? dst | dev->core[row][col].id << 20 : dst;
 		} else {
-			if (islocal) {
+			switch (seg->dest) {
+			case IMAGE_DEST_LOCAL:
 				diag(L_D3) { fprintf(diag_fd, " to core (%d,%d)\n", row, col); }
 
 				// TODO: should this be p_paddr instead of p_vaddr?
 				dst = ((uintptr_t) dev->core[row][col].mems.base)
-					+ phdr[ihdr].p_vaddr;
-			} else if (isonchip) {
-				coreid = phdr[ihdr].p_vaddr >> 20;
+					+ seg->vaddr;
+				break;
+
+			case IMAGE_DEST_ONCHIP:
+				coreid = seg->vaddr >> 20;
 				ee_get_coords_from_id(dev, coreid, &globrow, &globcol);
 				diag(L_D3) {
 					fprintf(diag_fd, " to core (%d,%d)\n", globrow, globcol); }
 				// TODO: should this be p_paddr instead of p_vaddr?
 				dst = ((uintptr_t) dev->core[globrow][globcol].mems.base)
-					+ (phdr[ihdr].p_vaddr & 0x000fffff);
-			} else {
+					+ (seg->vaddr & 0x000fffff);
+				break;
+
+			default:
 				// If it is not on an eCore, it's in external memory.
 				diag(L_D3) { fprintf(diag_fd, " to external memory.\n"); }
-				dst = phdr[ihdr].p_vaddr - emem->ephy_base
+				dst = seg->vaddr - emem->ephy_base
 					+ (uintptr_t) emem->base;
 				diag(L_D3) {
 					fprintf(diag_fd,
-							"ee_process_elf(): converting virtual (0x%08llx) to physical (0x%08llx)...\n",
-							(ulong64) phdr[ihdr].p_vaddr,
+							"ee_process_image(): converting virtual (0x%08llx) to physical (0x%08llx)...\n",
+							(ulong64) seg->vaddr,
 							(ulong64) dst); }
+				break;
 			}
 		}
 
 		/* Write */
 		if (ee_esim_target_p()) {
 			if (ES_OK != es_ops.mem_store((es_state *) dev->priv, dst,
-										  phdr[ihdr].p_filesz,
-										  &src[phdr[ihdr].p_offset])) {
+										  seg->filesz, seg->data)) {
 				fprintf(diag_fd,
-						"ee_process_elf(): Error: ESIM error writing to 0x%llx",
+						"ee_process_image(): Error: ESIM error writing to 0x%llx",
 						(ulong64) dst);
 				return E_ERR;
 			}
 		} else {
-			memcpy((void *) dst, &src[phdr[ihdr].p_offset],
-				   phdr[ihdr].p_filesz);
+			memcpy((void *) dst, seg->data, seg->filesz);
 		}
 		/* We might want to clear mem in range [p_filesz-p_memsz] here.
 		 * .bss sections have this. For now assume all memory is cleared
@@ -44,6 +44,12 @@ typedef enum {
 int e_load(const char *executable, e_epiphany_t *dev, unsigned row, unsigned col, e_bool_t start);
 int e_load_group(const char *executable, e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols, e_bool_t start);
 
+typedef struct e_image e_image_t;
+
+e_image_t *e_image_open(const char *executable);
+int e_image_load_group(e_image_t *img, e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols, e_bool_t start);
+int e_image_close(e_image_t *img);
+
 e_loader_diag_t e_set_loader_verbosity(e_loader_diag_t verbose);
 
 #ifdef __cplusplus
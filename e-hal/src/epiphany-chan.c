@@ -0,0 +1,275 @@
+/*
+  File: epiphany-chan.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.	 If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Single producer, single consumer channels in shared memory.
+ *
+ * Each end keeps its own counter in its handle and only publishes it to
+ * the shared header, so the producer writes only head and the consumer
+ * only tail. The other end's counter is cached and only re-read when
+ * the cached value says the ring is full (or empty), which keeps reads
+ * of the uncached shared memory off the fast path.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "epiphany-hal.h"
+
+extern int	 e_host_verbose;
+#define diag(vN) if (e_host_verbose >= vN)
+
+/* How long a waiting end polls before it starts to sleep, and its longest
+ * sleep. Time rather than a poll count, since a poll of uncached shared
+ * memory costs very different amounts on different targets. */
+#define CHAN_SPIN_NS		20000
+#define CHAN_MAX_SLEEP_NS	1000000
+
+static inline uint32_t chan_load(const uint32_t *p)
+{
+	uint32_t v = *(volatile const uint32_t *) p;
+
+	__sync_synchronize();
+	return v;
+}
+
+static inline void chan_store(uint32_t *p, uint32_t v)
+{
+	__sync_synchronize();
+	*(volatile uint32_t *) p = v;
+}
+
+static int chan_setup(e_chan_t *chan, const char *name)
+{
+	e_chan_hdr_t *hdr = (e_chan_hdr_t *) chan->mem.base;
+
+	/* 64-bit, so a corrupt header can't wrap the bound on 32-bit hosts */
+	if ( hdr->magic != E_CHAN_MAGIC ||
+		 !hdr->depth || (hdr->depth & (hdr->depth - 1)) ||
+		 sizeof(*hdr) + (uint64_t) hdr->slot_size * hdr->depth
+		 > (uint64_t) chan->mem.emap_size ) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	chan->hdr = hdr;
+	chan->slots = (uint8_t *) hdr + sizeof(*hdr);
+	chan->slot_size = hdr->slot_size;
+	chan->depth = hdr->depth;
+	chan->head = chan_load(&hdr->head);
+	chan->tail = chan_load(&hdr->tail);
+	strncpy(chan->name, name, sizeof(chan->name) - 1);
+	chan->name[sizeof(chan->name) - 1] = '\0';
+
+	return E_OK;
+}
+
+int e_chan_create(e_chan_t *chan, const char *name, size_t slot_size,
+				  unsigned depth)
+{
+	e_chan_hdr_t *hdr;
+
+	slot_size = (slot_size + 7) & ~(size_t) 7;
+	if ( !chan || !name || !slot_size || slot_size > UINT32_MAX ||
+		 !depth || (depth & (depth - 1)) || depth > (1U << 30) ||
+		 slot_size > (SIZE_MAX - sizeof(*hdr)) / depth ) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	if ( E_OK != e_shm_alloc_aligned(&chan->mem, name,
+									 sizeof(*hdr) + slot_size * depth,
+									 E_CHAN_LINE) )
+		return E_ERR;
+
+	hdr = (e_chan_hdr_t *) chan->mem.base;
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->slot_size = slot_size;
+	hdr->depth = depth;
+	chan_store(&hdr->magic, E_CHAN_MAGIC);
+
+	diag(H_D1) { fprintf(stderr, "e_chan_create(): %s: %u slots of %u "
+						 "bytes\n", name, depth, (unsigned) slot_size); }
+
+	return chan_setup(chan, name);
+}
+
+int e_chan_open(e_chan_t *chan, const char *name)
+{
+	if ( !chan || !name ) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	if ( E_OK != e_shm_attach(&chan->mem, name) )
+		return E_ERR;
+
+	if ( E_OK != chan_setup(chan, name) ) {
+		e_shm_release(name);
+		return E_ERR;
+	}
+
+	return E_OK;
+}
+
+int e_chan_close(e_chan_t *chan)
+{
+	if ( !chan || !chan->hdr )
+		return E_ERR;
+
+	chan->hdr = NULL;
+	return e_shm_release(chan->name);
+}
+
+unsigned e_chan_reserve(e_chan_t *chan, void **slots, unsigned n)
+{
+	unsigned idx = chan->head & (chan->depth - 1);
+	unsigned avail = chan->depth - (chan->head - chan->tail);
+
+	if ( avail < n ) {
+		chan->tail = chan_load(&chan->hdr->tail);
+		avail = chan->depth - (chan->head - chan->tail);
+	}
+
+	/* Reserved slots must not wrap */
+	if ( avail > chan->depth - idx )
+		avail = chan->depth - idx;
+	if ( n > avail )
+		n = avail;
+
+	*slots = chan->slots + (size_t) idx * chan->slot_size;
+	return n;
+}
+
+void e_chan_commit(e_chan_t *chan, unsigned n)
+{
+	chan->head += n;
+	chan_store(&chan->hdr->head, chan->head);
+}
+
+unsigned e_chan_peek(e_chan_t *chan, void **slots, unsigned n)
+{
+	unsigned idx = chan->tail & (chan->depth - 1);
+	unsigned avail = chan->head - chan->tail;
+
+	if ( avail < n ) {
+		chan->head = chan_load(&chan->hdr->head);
+		avail = chan->head - chan->tail;
+	}
+
+	if ( avail > chan->depth - idx )
+		avail = chan->depth - idx;
+	if ( n > avail )
+		n = avail;
+
+	*slots = chan->slots + (size_t) idx * chan->slot_size;
+	return n;
+}
+
+void e_chan_consume(e_chan_t *chan, unsigned n)
+{
+	chan->tail += n;
+	chan_store(&chan->hdr->tail, chan->tail);
+}
+
+static int64_t chan_elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) (now.tv_sec - start->tv_sec) * 1000000000LL +
+		(now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Wait for one slot from fn (e_chan_reserve or e_chan_peek), spinning
+ * for CHAN_SPIN_NS and then sleeping with exponential backoff.
+ */
+static int chan_wait(e_chan_t *chan, void **slot, long timeout_us,
+					 unsigned (*fn)(e_chan_t *, void **, unsigned))
+{
+	struct timespec start, nap;
+	long sleep_ns = 1000;
+	int64_t elapsed;
+
+	if ( fn(chan, slot, 1) )
+		return E_OK;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while ( !fn(chan, slot, 1) ) {
+		elapsed = chan_elapsed_ns(&start);
+		if ( E_CHAN_FOREVER != timeout_us &&
+			 elapsed >= (int64_t) timeout_us * 1000 ) {
+			errno = EAGAIN;
+			return E_ERR;
+		}
+
+		if ( elapsed < CHAN_SPIN_NS )
+			continue;
+
+		nap.tv_sec = 0;
+		nap.tv_nsec = sleep_ns;
+		nanosleep(&nap, NULL);
+		if ( sleep_ns < CHAN_MAX_SLEEP_NS )
+			sleep_ns *= 2;
+	}
+
+	return E_OK;
+}
+
+int e_chan_send(e_chan_t *chan, const void *buf, size_t size,
+				long timeout_us)
+{
+	void *slot;
+
+	if ( size > chan->slot_size ) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	if ( E_OK != chan_wait(chan, &slot, timeout_us, e_chan_reserve) )
+		return E_ERR;
+
+	memcpy(slot, buf, size);
+	e_chan_commit(chan, 1);
+
+	return E_OK;
+}
+
+int e_chan_recv(e_chan_t *chan, void *buf, size_t size, long timeout_us)
+{
+	void *slot;
+
+	if ( E_OK != chan_wait(chan, &slot, timeout_us, e_chan_peek) )
+		return E_ERR;
+
+	memcpy(buf, slot, size < chan->slot_size ? size : chan->slot_size);
+	e_chan_consume(chan, 1);
+
+	return E_OK;
+}
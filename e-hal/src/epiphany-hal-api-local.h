@@ -45,6 +45,13 @@ ssize_t  ee_read_buf(e_epiphany_t *dev, unsigned row, unsigned col, const off_t
 ssize_t  ee_write_buf(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size);
 int      ee_read_reg(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr);
 ssize_t  ee_write_reg(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, int data);
+ssize_t  ee_write_broadcast(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols, off_t to_addr, const void *buf, size_t size);
+void     ee_memcpy_to_dev(void *dst, const void *src, size_t size, bool burst);
+void     ee_memcpy_from_dev(void *dst, const void *src, size_t size, bool burst);
+
+// Row parallel work (EHAL_LOAD_THREADS)
+#define EE_ROW_MAX_THREADS 64
+unsigned ee_row_threads();
 //
 // For legacy code support
 ssize_t  ee_read_abs(unsigned address, void *buf, size_t size);
@@ -64,6 +71,10 @@ int      ee_reset_core(e_epiphany_t *dev, unsigned row, unsigned col);
 int      ee_reset_group(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols);
 int      ee_start_group(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols);
 int      ee_soft_reset_core(e_epiphany_t *dev, unsigned row, unsigned col);
+size_t   ee_soft_reset_payload_size();
+unsigned ee_system_reset_count();
+void     ee_core_dirty_range(unsigned coreid, size_t *lo, size_t *hi);
+void     ee_core_dirty_clear(unsigned coreid);
 
 
 ////////////////////
@@ -77,14 +88,39 @@ int      ee_set_chip_params(e_chip_t *dev);
 int      ee_parse_hdf(e_platform_t *dev, char *hdf);
 int      ee_parse_simple_hdf(e_platform_t *dev, char *hdf);
 int      ee_parse_xml_hdf(e_platform_t *dev, char *hdf);
+int      ee_hdf_cache_load(e_platform_t *dev, const char *hdf);
+int      ee_hdf_cache_store(e_platform_t *dev, const char *hdf);
 void     ee_trim_str(char *a);
 unsigned long ee_rndu_page(unsigned long size);
 unsigned long ee_rndl_page(unsigned long size);
 
+// Call instrumentation. The wrappers are cheap enough to stay in the
+// hot paths: with EHAL_STATS unset they only test ee_stats_on.
+extern int ee_stats_on;
+void     ee_stats_init();
+void     ee_stats_finalize();
+uint64_t ee_stats_now();
+void     ee_stats_add(e_op_t op, uint64_t t0, ssize_t bytes, bool err);
+
+static inline uint64_t ee_stats_begin()
+{
+	return ee_stats_on ? ee_stats_now() : 0;
+}
+
+static inline void ee_stats_end(e_op_t op, uint64_t t0, ssize_t bytes, bool err)
+{
+	if (t0)
+		ee_stats_add(op, t0, bytes, err);
+}
+
 // Target detect functions
 bool     ee_native_target_p();
 bool     ee_esim_target_p();
 bool     ee_pal_target_p();
+bool     ee_mem_target_p();
+
+// Loader (libe-loader)
+void     ee_loader_finalize();
 
 #ifdef __cplusplus
 }
@@ -28,6 +28,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "epiphany-shm-manager.h"
 
 #ifdef __cplusplus
@@ -48,11 +49,20 @@ int		e_close(e_epiphany_t *dev);
 // External memory access
 int		e_alloc(e_mem_t *mbuf, off_t base, size_t size);
 int		e_free(e_mem_t *mbuf);
+void	e_get_emem_stats(e_emem_stats_t *stats);
 
 //
 // Data transfer
 ssize_t e_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf, size_t size);
 ssize_t e_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size);
+// Batches may be reordered by object, core and address. Writes that overlap
+// on the same object and core land in submission order.
+ssize_t e_read_v(const e_iovec_t *iov, unsigned count);
+ssize_t e_write_v(const e_iovec_t *iov, unsigned count);
+ssize_t e_write_broadcast(e_epiphany_t *dev, off_t to_addr, const void *buf, size_t size);
+int		e_read_regs(e_epiphany_t *dev, unsigned row, unsigned col, unsigned reg_set, e_core_regs_t *regs);
+int		e_read_regs_group(e_epiphany_t *dev, unsigned reg_set, e_core_regs_t *regs);
+unsigned *e_core_reg(e_core_regs_t *regs, off_t reg);
 
 
 ///////////////////////////
@@ -66,6 +76,17 @@ int		e_start_group(e_epiphany_t *dev);
 int		e_signal(e_epiphany_t *dev, unsigned row, unsigned col);
 int		e_halt(e_epiphany_t *dev, unsigned row, unsigned col);
 int		e_resume(e_epiphany_t *dev, unsigned row, unsigned col);
+int		e_wait_group(e_epiphany_t *dev, off_t flag_addr, unsigned expected, long timeout_us, unsigned flags, e_bool_t *done);
+int		e_wait_core(e_epiphany_t *dev, unsigned row, unsigned col, off_t flag_addr, unsigned expected, long timeout_us, unsigned flags);
+void	e_get_wait_stats(e_wait_stats_t *stats);
+
+
+/////////////////////////////
+// Call instrumentation (EHAL_STATS)
+int		e_get_op_stats(e_target_t target, e_op_t op, e_op_stats_t *stats);
+const char *e_get_op_name(e_op_t op);
+void	e_reset_stats(void);
+int		e_dump_stats(FILE *f, e_bool_t json);
 
 ////////////////////////////////////////////
 // Shared Memory Manager function prototypes
@@ -88,6 +109,19 @@ int		e_resume(e_epiphany_t *dev, unsigned row, unsigned col);
  */
 int e_shm_alloc(e_mem_t *mbuf, const char *name, size_t size);
 
+/**
+ * Allocate a shared region like e_shm_alloc, with the start of the
+ * region aligned to align bytes.
+ *
+ * @param align - the alignment, a power of two. Alignments below 8 bytes
+ * are rounded up to 8.
+ *
+ * @return as for e_shm_alloc. errno is set to EINVAL if align is
+ * not a power of two.
+ */
+int e_shm_alloc_aligned(e_mem_t *mbuf, const char *name, size_t size,
+						size_t align);
+
 /**
  * Attach to a shared region identifiable by name
  *
@@ -117,6 +151,99 @@ int e_shm_release(const char *name);
  */
 e_shmtable_t* e_shm_get_shmtable(void);
 
+/**
+ * Get a snapshot of the shared memory heap statistics
+ *
+ * @param stats - filled with the statistics on success
+ *
+ * @return E_OK on success, E_ERR on failure.
+ */
+int e_shm_get_stats(e_shm_stats_t *stats);
+
+/**
+ * Get a snapshot of the SHM table writer lock statistics
+ *
+ * @param stats - filled with the statistics on success
+ *
+ * @return E_OK on success, E_ERR on failure.
+ */
+int e_shm_get_lock_stats(e_shm_lock_stats_t *stats);
+
+///////////////////////////
+// Shared memory channels
+
+/**
+ * Create a single producer, single consumer channel of depth slots of
+ * slot_size bytes in a new shared region identifiable by name.
+ *
+ * @param chan - filled with the host end of the channel
+ * @param name - the region name, which cores pass to e_chan_attach()
+ * @param slot_size - bytes per slot, rounded up to a multiple of 8
+ * @param depth - number of slots, a power of two
+ *
+ * @return E_OK on success, E_ERR on failure with errno set as for
+ * e_shm_alloc, or to EINVAL for a bad size or depth.
+ */
+int e_chan_create(e_chan_t *chan, const char *name, size_t slot_size,
+				  unsigned depth);
+
+/**
+ * Open a channel created by another host process with e_chan_create.
+ */
+int e_chan_open(e_chan_t *chan, const char *name);
+
+/**
+ * Close the host end of a channel, freeing the region with the last
+ * reference to it.
+ */
+int e_chan_close(e_chan_t *chan);
+
+/**
+ * Reserve up to n slots for writing without blocking.
+ *
+ * @param slots - set to the first reserved slot. Reserved slots are
+ * contiguous, so fewer than n may be returned at the end of the ring.
+ *
+ * @return the number of slots reserved, which stay reserved until the
+ * next call to e_chan_commit.
+ */
+unsigned e_chan_reserve(e_chan_t *chan, void **slots, unsigned n);
+
+/**
+ * Publish the first n reserved slots to the consumer.
+ */
+void e_chan_commit(e_chan_t *chan, unsigned n);
+
+/**
+ * Get up to n contiguous filled slots for reading without blocking.
+ *
+ * @return the number of slots available at *slots.
+ */
+unsigned e_chan_peek(e_chan_t *chan, void **slots, unsigned n);
+
+/**
+ * Hand the first n peeked slots back to the producer.
+ */
+void e_chan_consume(e_chan_t *chan, unsigned n);
+
+/**
+ * Copy size bytes from buf into the next slot and commit it, waiting up
+ * to timeout_us microseconds for a free slot. The wait spins briefly and
+ * then sleeps. A timeout of 0 does not wait and E_CHAN_FOREVER waits
+ * until a slot is free.
+ *
+ * @return E_OK on success, E_ERR with errno set to EAGAIN if no slot
+ * became free or EINVAL if size is larger than a slot.
+ */
+int e_chan_send(e_chan_t *chan, const void *buf, size_t size,
+				long timeout_us);
+
+/**
+ * Copy up to size bytes of the next slot into buf and consume it,
+ * waiting as for e_chan_send.
+ */
+int e_chan_recv(e_chan_t *chan, void *buf, size_t size, long timeout_us);
+
 ////////////////////
 // Utility functions
 unsigned e_get_num_from_coords(e_epiphany_t *dev, unsigned row, unsigned col);
@@ -200,6 +200,7 @@ extern e_chip_db_t e_chip_params_table[E_CHIP_DB_NUM_CHIP_VERSIONS];
 
 typedef struct e_epiphany_t e_epiphany_t;
 typedef struct e_mem_t e_mem_t;
+typedef struct e_iovec_t e_iovec_t;
 
 struct e_target_ops {
 	int (*ee_read_word) (e_epiphany_t *, unsigned, unsigned, const off_t);
@@ -224,6 +225,13 @@ struct e_target_ops {
 	int (*alloc) (e_mem_t *);
 	int (*shm_alloc) (e_mem_t *);
 	int (*free) (e_mem_t *);
+	/* Optional. Called with a validated, sorted batch */
+	ssize_t (*ee_read_v) (const e_iovec_t * const *, unsigned);
+	ssize_t (*ee_write_v) (const e_iovec_t * const *, unsigned);
+	/* Optional. Write one block to a validated rectangle of cores */
+	ssize_t (*ee_write_broadcast) (e_epiphany_t *, unsigned, unsigned, unsigned, unsigned, off_t, const void *, size_t);
+	/* Optional. Read a contiguous, validated range of core registers */
+	ssize_t (*ee_read_regs) (e_epiphany_t *, unsigned, unsigned, off_t, unsigned *, unsigned);
 };
 
 #ifdef __cplusplus
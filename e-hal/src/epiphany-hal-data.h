@@ -231,9 +231,147 @@ typedef struct e_mem_t {
 	void			*priv;		  // Target private
 } e_mem_t;
 
+
+// Scatter-gather transfer descriptor for e_read_v() / e_write_v()
+typedef struct e_iovec_t {
+	void			*dev;		  // e_epiphany_t or e_mem_t object
+	unsigned int	 row;		  // core row in group (ignored for e_mem_t)
+	unsigned int	 col;		  // core col in group (ignored for e_mem_t)
+	off_t			 addr;		  // offset in core / buffer address space
+	void			*buf;		  // host buffer
+	size_t			 size;		  // transfer size in bytes
+} e_iovec_t;
+
+// Register blocks for e_read_regs() / e_read_regs_group()
+typedef enum {
+	E_REGS_GPR		= 0x01,		  // R0 - R63
+	E_REGS_CTRL		= 0x02,		  // CONFIG - DEBUGCMD
+	E_REGS_DMA		= 0x04,		  // DMA0CONFIG - DMA1STATUS
+	E_REGS_MEMPROT	= 0x08,		  // MEMSTATUS - MEMPROTECT
+	E_REGS_MESH		= 0x10,		  // MESHCONFIG - RMESHROUTE
+	E_REGS_SCR		= 0x1e,		  // all special core registers
+	E_REGS_ALL		= 0x1f,
+} e_reg_set_t;
+
+// Register file snapshot. Each block mirrors a contiguous register range,
+// so a register is at (E_REG_xxx - first register of its block) / 4. Use
+// e_core_reg() to look one up by address.
+typedef struct e_core_regs_t {
+	unsigned		 gpr[64];	  // from E_REG_R0
+	unsigned		 ctrl[19];	  // from E_REG_CONFIG
+	unsigned		 dma[16];	  // from E_REG_DMA0CONFIG
+	unsigned		 memprot[2];  // from E_REG_MEMSTATUS
+	unsigned		 mesh[7];	  // from E_REG_MESHCONFIG
+} e_core_regs_t;
+
+// Completion wait flags for e_wait_group() / e_wait_core()
+#define E_WAIT_IDLE		0x1		  // also count a core whose STATUS is idle as done
+
+// Timeout for e_wait_group() / e_wait_core() that never expires
+#define E_WAIT_FOREVER	(-1L)
+
+// Completion wait statistics, see e_get_wait_stats()
+typedef struct e_wait_stats_t {
+	uint64_t		 waits;		  // completed calls to the wait functions
+	uint64_t		 timeouts;	  // waits that timed out
+	uint64_t		 sweeps;	  // polls over all pending cores
+	uint64_t		 completions; // cores seen to complete
+	uint64_t		 wait_ns;	  // total time spent waiting
+	uint64_t		 last_wait_ns;// duration of the last wait
+	uint64_t		 slack_ns;	  // total time between a completion's last two sweeps
+	uint64_t		 max_slack_ns;// longest such time
+} e_wait_stats_t;
+
+// External memory mapping statistics, see e_get_emem_stats()
+typedef struct e_emem_stats_t {
+	uint64_t		 maps;		  // segment mappings created
+	uint64_t		 unmaps;	  // segment mappings removed
+	uint64_t		 views;		  // buffers served from a segment mapping
+	uint64_t		 reuses;	  // of those, served from an existing mapping
+	uint64_t		 live_views;  // views not yet freed
+	uint64_t		 private_maps;// buffers that needed their own mapping
+	uint64_t		 mapped_bytes;// size of the current segment mappings
+	uint64_t		 page_size;	  // MMU page size backing them, 0 if unknown
+	uint64_t		 tlb_entries; // TLB entries needed to cover them
+} e_emem_stats_t;
+
+// Instrumented operations, see e_get_op_stats()
+typedef enum {
+	// Public API
+	E_OP_OPEN,
+	E_OP_CLOSE,
+	E_OP_READ,
+	E_OP_WRITE,
+	E_OP_READ_V,
+	E_OP_WRITE_V,
+	E_OP_WRITE_BROADCAST,
+	E_OP_READ_REGS,
+	E_OP_ALLOC,
+	E_OP_FREE,
+	E_OP_LOAD_GROUP,
+	E_OP_START_GROUP,
+	E_OP_RESET_SYSTEM,
+	E_OP_RESET_GROUP,
+	E_OP_START,
+	E_OP_SIGNAL,
+	E_OP_HALT,
+	E_OP_RESUME,
+	E_OP_WAIT,
+	E_OP_SHM_ALLOC,
+	E_OP_SHM_ATTACH,
+	E_OP_SHM_RELEASE,
+	// Target operators
+	E_OP_T_READ_WORD,
+	E_OP_T_WRITE_WORD,
+	E_OP_T_READ_BUF,
+	E_OP_T_WRITE_BUF,
+	E_OP_T_READ_REG,
+	E_OP_T_WRITE_REG,
+	E_OP_T_MREAD_WORD,
+	E_OP_T_MWRITE_WORD,
+	E_OP_T_MREAD_BUF,
+	E_OP_T_MWRITE_BUF,
+	E_OP_T_READ_V,
+	E_OP_T_WRITE_V,
+	E_OP_T_READ_REGS,
+	E_OP_T_WRITE_BROADCAST,
+	E_OP_NUM
+} e_op_t;
+
+// Targets the operation statistics are kept for
+typedef enum {
+	E_TARGET_NATIVE,
+	E_TARGET_MEM,
+	E_TARGET_ESIM,
+	E_TARGET_PAL,
+	E_TARGET_NUM
+} e_target_t;
+
+// Latency histogram buckets. Bucket i counts calls that took less than
+// 2^i ns and at least 2^(i-1) ns, the last one everything slower.
+#define E_STATS_BUCKETS	32
+
+// Per operation statistics
+typedef struct e_op_stats_t {
+	uint64_t		 calls;		  // completed calls
+	uint64_t		 errors;	  // calls that returned E_ERR
+	uint64_t		 bytes;		  // bytes transferred
+	uint64_t		 total_ns;	  // total time spent in the calls
+	uint64_t		 max_ns;	  // longest call
+	uint64_t		 hist[E_STATS_BUCKETS]; // latency histogram
+} e_op_stats_t;
+
 #define ALIGN(x)	__attribute__ ((aligned (x)))
 
-#define MAX_SHM_REGIONS				   64
+#define MAX_SHM_REGIONS				   256
+
+/* Layout version of e_shmtable_t, bumped whenever it changes */
+#define SHM_VERSION					   4
+
+/* Size of the region name index, a power of two */
+#define SHM_INDEX_SIZE				   512
+#define SHM_INDEX_EMPTY				   0
+#define SHM_INDEX_DELETED			   0xffffffff
 
 /*
 ** Type definitions
@@ -269,9 +407,48 @@ typedef struct ALIGN(8) e_shmseg_pvt	{
 	uint32_t	valid;	  /* 1 if the region is in use, 0 otherwise */
 } e_shmseg_pvt_t;
 
+/** Shared memory heap statistics, in bytes unless noted */
+typedef struct ALIGN(8) e_shm_stats {
+	uint64_t	size;		   /* Heap size */
+	uint64_t	used;		   /* Bytes in allocated blocks */
+	uint64_t	free;		   /* Bytes in free blocks */
+	uint64_t	high_water;	   /* Highest value of used */
+	uint64_t	largest_free;  /* Largest allocation that would succeed */
+	uint64_t	free_blocks;   /* Number of free blocks */
+	uint64_t	allocs;		   /* Successful allocations */
+	uint64_t	frees;		   /* Blocks freed */
+	uint64_t	failed;		   /* Failed allocations */
+	uint64_t	fragmentation; /* Percentage of free space not in the largest block */
+} e_shm_stats_t;
+
+/**
+ * Region name index entry. Entries are found by open addressing with
+ * linear probing from e_shm_hash(name) & (SHM_INDEX_SIZE - 1). slot is
+ * SHM_INDEX_EMPTY, SHM_INDEX_DELETED or the region number plus one.
+ */
+typedef struct ALIGN(8) e_shm_index {
+	uint32_t	hash;		  /* Hash of the region name */
+	uint32_t	slot;		  /* Region number + 1 */
+} e_shm_index_t;
+
+/** SHM table writer lock statistics, times in nanoseconds */
+typedef struct ALIGN(8) e_shm_lock_stats {
+	uint64_t	acquired;	   /* Writer lock acquisitions */
+	uint64_t	contended;	   /* Acquisitions that had to wait */
+	uint64_t	wait_ns;	   /* Total time spent waiting */
+	uint64_t	max_wait_ns;   /* Longest wait */
+	uint64_t	hold_ns;	   /* Total time held */
+	uint64_t	max_hold_ns;   /* Longest hold */
+	uint64_t	owner_died;	   /* Recoveries from a holder that died */
+	uint64_t	read_retries;  /* Lock-free lookups that had to retry */
+} e_shm_lock_stats_t;
+
 typedef struct ALIGN(8) e_shmtable {
 	uint32_t		magic;
 	uint32_t		initialized;
+	uint32_t		version;	/* SHM_VERSION */
+	uint32_t		index_deleted;	/* Number of deleted index entries */
+	e_shm_index_t	index[SHM_INDEX_SIZE];
 	e_shmseg_pvt_t	regions[MAX_SHM_REGIONS];
 	uint64_t		free_space;
 	uint64_t		next_free_offset;
@@ -285,10 +462,70 @@ typedef struct ALIGN(8) e_shmtable {
 		void		*lock;		/* User-space semaphore (sem_t* on e-hal side) */
 		uint64_t	__fill2;
 	};
+	e_shm_stats_t	heap_stats;	/* Heap statistics, updated on every alloc and free */
+	uint32_t		seq;		/* Odd while a writer is updating regions */
+	uint32_t		writer;		/* Pid of the writer lock holder, 0 if none */
+	e_shm_lock_stats_t lock_stats;
 } e_shmtable_t;
 
+#define E_CHAN_MAGIC				   0x6e616863	/* "chan" */
+#define E_CHAN_LINE					   64			/* Index spacing */
+
+/**
+ * Single producer, single consumer channel header, at the start of the
+ * channel's shared memory region and followed by depth slots of
+ * slot_size bytes. head and tail are free running counts of slots
+ * committed and consumed, each on its own line so the producer and
+ * consumer never write to the same one.
+ *
+ * NOTE: Must match e_chan_hdr_t in e-lib.
+ */
+typedef struct ALIGN(8) e_chan_hdr {
+	uint32_t	magic;
+	uint32_t	slot_size;	  /* Bytes per slot, a multiple of 8 */
+	uint32_t	depth;		  /* Number of slots, a power of two */
+	uint32_t	__pad0[E_CHAN_LINE / 4 - 3];
+	uint32_t	head;		  /* Written by the producer only */
+	uint32_t	__pad1[E_CHAN_LINE / 4 - 1];
+	uint32_t	tail;		  /* Written by the consumer only */
+	uint32_t	__pad2[E_CHAN_LINE / 4 - 1];
+} e_chan_hdr_t;
+
 #pragma pack(pop)
 
+/** Host end of a channel. The producer and consumer each need their own. */
+typedef struct e_chan {
+	e_mem_t			 mem;		  // the channel's shared memory region
+	e_chan_hdr_t	*hdr;		  // shared header
+	uint8_t			*slots;		  // first slot
+	unsigned		 slot_size;	  // bytes per slot
+	unsigned		 depth;		  // number of slots
+	uint32_t		 head;		  // producer: next head, consumer: last head seen
+	uint32_t		 tail;		  // consumer: next tail, producer: last tail seen
+	char			 name[256];	  // region name, for e_chan_close()
+} e_chan_t;
+
+/* Timeout for e_chan_send() and e_chan_recv() that never expires */
+#define E_CHAN_FOREVER				   (-1L)
+
+/**
+ * Hash of a region name for the name index (32-bit FNV-1a over at most
+ * the stored name length). The FNV prime multiply is spelled out as
+ * shifts, which is cheaper on the Epiphany than a library multiply.
+ */
+static inline uint32_t e_shm_hash(const char *name)
+{
+	uint32_t h = 2166136261u;
+	unsigned i;
+
+	for (i = 0; i < sizeof(((e_shmseg_t *) 0)->name) && name[i]; i++) {
+		h ^= (uint8_t) name[i];
+		h += (h << 1) + (h << 4) + (h << 7) + (h << 8) + (h << 24);
+	}
+
+	return h;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,7 +34,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
 #include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
 
 /* Redesigned driver API */
 #include "epiphany2.h"
@@ -51,6 +56,8 @@ typedef unsigned long ulong;
 
 #define diag(vN) if (e_host_verbose >= vN)
 
+#define EHAL_CACHE_LINE 64
+
 //static int e_host_verbose = 0;
 int	  e_host_verbose; //__attribute__ ((visibility ("hidden"))) = 0;
 FILE *diag_fd			  __attribute__ ((visibility ("hidden")));
@@ -66,6 +73,7 @@ extern const struct e_target_ops esim_target_ops;
 #ifdef PAL_TARGET
 extern const struct e_target_ops pal_target_ops;
 #endif
+extern const struct e_target_ops mem_target_ops;
 const struct e_target_ops native_target_ops;
 
 e_platform_t e_platform = {
@@ -73,6 +81,46 @@ e_platform_t e_platform = {
 	.target_ops = &native_target_ops,
 };
 
+static void ee_emem_finalize();
+
+// SRAM range of each core this process wrote to since the loader last
+// cleared it, by core ID. The start is kept in the upper and the end in the
+// lower half of the word, so both are updated together; the range is empty
+// when the end is not past the start.
+#define EE_CORE_DIRTY_IDS 4096	/* 12-bit core IDs */
+static uint64_t core_dirty[EE_CORE_DIRTY_IDS];
+
+static void ee_core_dirty(e_epiphany_t *dev, unsigned row, unsigned col,
+						  unsigned rows, unsigned cols, off_t addr, size_t size)
+{
+	uint64_t  old, new, lo, hi, end;
+	unsigned  i, j;
+	uint64_t *p;
+
+	if (addr < 0 || !size || addr >= dev->core[row][col].mems.map_size)
+		return;
+	end = (uint64_t) addr + size;
+
+	for (i=row; i<row+rows; i++)
+		for (j=col; j<col+cols; j++)
+		{
+			p = &core_dirty[dev->core[i][j].id % EE_CORE_DIRTY_IDS];
+			do {
+				old = *p;
+				lo = old >> 32;
+				hi = old & 0xffffffff;
+				if (hi <= lo) {
+					lo = addr;
+					hi = end;
+				} else {
+					lo = (lo < (uint64_t) addr) ? lo : (uint64_t) addr;
+					hi = (hi > end) ? hi : end;
+				}
+				new = (lo << 32) | hi;
+			} while (__sync_val_compare_and_swap(p, old, new) != old);
+		}
+}
+
 /////////////////////////////////
 // Device communication functions
 //
@@ -117,6 +165,11 @@ int e_init(char *hdf)
 		e_platform.target_ops = &pal_target_ops;
 #endif
 
+	if (ee_mem_target_p())
+		e_platform.target_ops = &mem_target_ops;
+
+	ee_stats_init();
+
 	if (E_OK != e_platform.target_ops->init())
 		return E_ERR;
 
@@ -177,6 +230,12 @@ int e_finalize(void)
 
 	e_shm_finalize();
 
+	ee_loader_finalize();
+
+	ee_emem_finalize();
+
+	ee_stats_finalize();
+
 	e_platform.target_ops->finalize();
 
 	e_platform.initialized = E_FALSE;
@@ -218,13 +277,93 @@ static int ee_open_native(e_epiphany_t *dev, unsigned row, unsigned col,
 		return E_ERR;
 	}
 
+	dev->priv = NULL;
+
 	return E_OK;
 }
 
-int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols)
+// With EHAL_MAP_CHIP set, the native target maps the full 1MB core window
+// of every core in a group row with a single mmap() instead of mapping the
+// SRAM and register pages of each core separately. The holes in between are
+// never touched, so they cost address space only.
+struct ee_rowmap {
+	unsigned  rows;		  // number of row mappings
+	size_t	  size;		  // size of each row mapping
+	void	 *base[];	  // mapped base address of each group row
+};
+
+static bool chip_map_p()
 {
-	int irow, icol;
-	e_core_t *curr_core;
+	static bool initialized = false;
+	static bool chip_map = false;
+	const char *p;
+
+	if (!initialized) {
+		p = getenv("EHAL_MAP_CHIP");
+		chip_map = (p && p[0] != '\0');
+		initialized = true;
+	}
+
+	return chip_map;
+}
+
+static void ee_unmap_rows_native(e_epiphany_t *dev)
+{
+	struct ee_rowmap *map = dev->priv;
+	unsigned irow;
+
+	if (!map)
+		return;
+
+	for (irow=0; irow<map->rows; irow++)
+		if (map->base[irow] != MAP_FAILED)
+			munmap(map->base[irow], map->size);
+
+	free(map);
+	dev->priv = NULL;
+}
+
+static int ee_map_rows_native(e_epiphany_t *dev)
+{
+	struct ee_rowmap *map;
+	off_t row_base;
+	unsigned irow;
+
+	map = malloc(sizeof(*map) + dev->rows * sizeof(void *));
+	if (!map)
+	{
+		warnx("e_open(): Error while allocating row mappings.");
+		return E_ERR;
+	}
+
+	map->rows = dev->rows;
+	map->size = dev->cols << 20;
+	for (irow=0; irow<map->rows; irow++)
+		map->base[irow] = MAP_FAILED;
+	dev->priv = map;
+
+	for (irow=0; irow<map->rows; irow++)
+	{
+		row_base = (off_t) ee_get_id_from_coords(dev, irow, 0) << 20;
+		map->base[irow] = mmap(NULL, map->size, PROT_READ|PROT_WRITE, MAP_SHARED, dev->memfd, row_base);
+		if (map->base[irow] == MAP_FAILED)
+		{
+			warnx("e_open(): group row %d mmap failure.", irow);
+			ee_unmap_rows_native(dev);
+			return E_ERR;
+		}
+
+		diag(H_D2) { fprintf(diag_fd, "e_open(): row %d phy_base = 0x%08x, base = 0x%08x, size = 0x%08x\n", irow, (uint) row_base, (uint) map->base[irow], (uint) map->size); }
+	}
+
+	return E_OK;
+}
+
+static int ee_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols)
+{
+	int irow, icol, i, nmapped = 0;
+	e_core_t *curr_core, *cores;
+	struct ee_rowmap *rowmap = NULL;
 
 	if (e_platform.initialized == E_FALSE)
 	{
@@ -252,22 +391,30 @@ int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigne
 	if (e_platform.target_ops->open(dev, row, col, rows, cols) != E_OK)
 		return E_ERR;
 
-	// Map individual cores to virtual memory space
+	if (ee_native_target_p() && chip_map_p())
+		if (ee_map_rows_native(dev) != E_OK)
+			goto err_close;
+	if (ee_native_target_p())
+		rowmap = dev->priv;
+
+	// Map individual cores to virtual memory space. The descriptors live in
+	// one flat, cache line aligned array; dev->core[] points at its rows.
 	dev->core = (e_core_t **) malloc(dev->rows * sizeof(e_core_t *));
 	if (!dev->core)
 	{
 		warnx("e_open(): Error while allocating eCore descriptors.");
-		return E_ERR;
+		goto err_close;
+	}
+
+	if (posix_memalign((void **) &cores, EHAL_CACHE_LINE, dev->num_cores * sizeof(e_core_t)))
+	{
+		warnx("e_open(): Error while allocating eCore descriptors.");
+		goto err_core;
 	}
 
 	for (irow=0; irow<dev->rows; irow++)
 	{
-		dev->core[irow] = (e_core_t *) malloc(dev->cols * sizeof(e_core_t));
-		if (!dev->core[irow])
-		{
-			warnx("e_open(): Error while allocating eCore descriptors.");
-			return E_ERR;
-		}
+		dev->core[irow] = &cores[irow * dev->cols];
 
 		for (icol=0; icol<dev->cols; icol++)
 		{
@@ -290,7 +437,10 @@ int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigne
 			curr_core->mems.page_offset = curr_core->mems.phy_base - curr_core->mems.page_base;
 			curr_core->mems.map_size = e_platform.chip[0].sram_size + curr_core->mems.page_offset;
 
-			if (ee_native_target_p()) {
+			if (rowmap) {
+				curr_core->mems.mapped_base = rowmap->base[irow] + (icol << 20) + curr_core->mems.page_base - (curr_core->id << 20);
+				curr_core->mems.base = curr_core->mems.mapped_base + curr_core->mems.page_offset;
+			} else if (ee_native_target_p()) {
 				curr_core->mems.mapped_base = mmap(NULL, curr_core->mems.map_size, PROT_READ|PROT_WRITE, MAP_SHARED, dev->memfd, curr_core->mems.page_base);
 				curr_core->mems.base = curr_core->mems.mapped_base + curr_core->mems.page_offset;
 
@@ -303,22 +453,39 @@ int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigne
 			curr_core->regs.page_offset = curr_core->regs.phy_base - curr_core->regs.page_base;
 			curr_core->regs.map_size = e_platform.chip[0].regs_size + curr_core->regs.page_offset;
 
-			if (ee_native_target_p()) {
+			if (rowmap) {
+				curr_core->regs.mapped_base = rowmap->base[irow] + (icol << 20) + curr_core->regs.page_base - (curr_core->id << 20);
+				curr_core->regs.base = curr_core->regs.mapped_base + curr_core->regs.page_offset;
+
+				diag(H_D2) { fprintf(diag_fd, "e_open(): mems.base = 0x%08x, regs.base = 0x%08x\n", (uint) curr_core->mems.base, (uint) curr_core->regs.base); }
+			} else if (ee_native_target_p()) {
 				curr_core->regs.mapped_base = mmap(NULL, curr_core->regs.map_size, PROT_READ|PROT_WRITE, MAP_SHARED, dev->memfd, curr_core->regs.page_base);
 				curr_core->regs.base = curr_core->regs.mapped_base + curr_core->regs.page_offset;
+				nmapped++;
 
 				diag(H_D2) { fprintf(diag_fd, "e_open(): regs.phy_base = 0x%08x, regs.base = 0x%08x, regs.size = 0x%08x\n", (uint) curr_core->regs.phy_base, (uint) curr_core->regs.base, (uint) curr_core->regs.map_size); }
 
 				if (curr_core->mems.mapped_base == MAP_FAILED)
 				{
 					warnx("e_open(): ECORE[%d,%d] MEM mmap failure.", curr_core->row, curr_core->col);
-					return E_ERR;
+					goto err_cores;
 				}
 
 				if (curr_core->regs.mapped_base == MAP_FAILED)
 				{
 					warnx("e_open(): ECORE[%d,%d] REG mmap failure.", curr_core->row, curr_core->col);
-					return E_ERR;
+					goto err_cores;
+				}
+			} else if (ee_mem_target_p()) {
+				curr_core->mems.mapped_base = e_platform.target_ops->get_raw_pointer(curr_core->mems.page_base, curr_core->mems.map_size);
+				curr_core->mems.base = curr_core->mems.mapped_base + curr_core->mems.page_offset;
+				curr_core->regs.mapped_base = e_platform.target_ops->get_raw_pointer(curr_core->regs.page_base, curr_core->regs.map_size);
+				curr_core->regs.base = curr_core->regs.mapped_base + curr_core->regs.page_offset;
+
+				if (!curr_core->mems.mapped_base || !curr_core->regs.mapped_base)
+				{
+					warnx("e_open(): ECORE[%d,%d] is not backed by memory.", curr_core->row, curr_core->col);
+					goto err_cores;
 				}
 			}
 #if 0
@@ -330,11 +497,45 @@ int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigne
 	}
 
 	return E_OK;
+
+	// Undo whatever was set up before the failure, so a failed e_open()
+	// leaves no mappings or descriptors behind
+ err_cores:
+	for (i=0; i<nmapped; i++)
+	{
+		if (cores[i].mems.mapped_base != MAP_FAILED)
+			munmap(cores[i].mems.mapped_base, cores[i].mems.map_size);
+		if (cores[i].regs.mapped_base != MAP_FAILED)
+			munmap(cores[i].regs.mapped_base, cores[i].regs.map_size);
+	}
+	free(cores);
+ err_core:
+	free(dev->core);
+	dev->core = NULL;
+ err_close:
+	if (ee_native_target_p())
+	{
+		ee_unmap_rows_native(dev);
+		close(dev->memfd);
+	}
+
+	return E_ERR;
 }
 
+int e_open(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols)
+{
+	uint64_t t0;
+	int rc;
 
-// Close an e-core workgroup
-int e_close(e_epiphany_t *dev)
+	t0 = ee_stats_begin();
+	rc = ee_open(dev, row, col, rows, cols);
+	ee_stats_end(E_OP_OPEN, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+
+static int ee_close(e_epiphany_t *dev)
 {
 	int irow, icol;
 	e_core_t *curr_core;
@@ -348,9 +549,14 @@ int e_close(e_epiphany_t *dev)
 	if (ee_pal_target_p())
 		return e_platform.target_ops->close(dev);
 
-	for (irow=0; irow<dev->rows; irow++)
+	if (ee_native_target_p() && dev->priv)
+	{
+		ee_unmap_rows_native(dev);
+	}
+	else if (ee_native_target_p())
 	{
-		if (ee_native_target_p()) {
+		for (irow=0; irow<dev->rows; irow++)
+		{
 			for (icol=0; icol<dev->cols; icol++)
 			{
 #if 0
@@ -365,10 +571,9 @@ int e_close(e_epiphany_t *dev)
 				munmap(curr_core->regs.mapped_base, curr_core->regs.map_size);
 			}
 		}
-
-		free(dev->core[irow]);
 	}
 
+	free(dev->core[0]);
 	free(dev->core);
 
 	if (ee_native_target_p())
@@ -377,11 +582,24 @@ int e_close(e_epiphany_t *dev)
 	return E_OK;
 }
 
+// Close an e-core workgroup
+int e_close(e_epiphany_t *dev)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_close(dev);
+	ee_stats_end(E_OP_CLOSE, t0, 0, rc == E_ERR);
 
-// Read a memory block from a core in a group
-ssize_t e_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf, size_t size)
+	return rc;
+}
+
+
+static ssize_t ee_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf, size_t size)
 {
 	ssize_t		  rcount;
+	unsigned int  reg;
 	e_epiphany_t *edev;
 	e_mem_t		 *mdev;
 
@@ -393,7 +611,8 @@ ssize_t e_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf
 		if (from_addr < edev->core[row][col].mems.map_size)
 			rcount = ee_read_buf(edev, row, col, from_addr, buf, size);
 		else {
-			*((unsigned *) (buf)) = ee_read_reg(dev, row, col, from_addr);
+			reg = ee_read_reg(dev, row, col, from_addr);
+			memcpy(buf, &reg, sizeof(reg));
 			rcount = 4;
 		}
 		break;
@@ -414,9 +633,21 @@ ssize_t e_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf
 	return rcount;
 }
 
+// Read a memory block from a core in a group
+ssize_t e_read(void *dev, unsigned row, unsigned col, off_t from_addr, void *buf, size_t size)
+{
+	uint64_t t0;
+	ssize_t rc;
 
-// Write a memory block to a core in a group
-ssize_t e_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size)
+	t0 = ee_stats_begin();
+	rc = ee_read(dev, row, col, from_addr, buf, size);
+	ee_stats_end(E_OP_READ, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+
+static ssize_t ee_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size)
 {
 	ssize_t		  wcount;
 	unsigned int  reg;
@@ -428,10 +659,11 @@ ssize_t e_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void
 	case E_EPI_GROUP:
 		diag(H_D2) { fprintf(diag_fd, "e_write(): detected EPI_GROUP object.\n"); }
 		edev = (e_epiphany_t *) dev;
-		if (to_addr < edev->core[row][col].mems.map_size)
+		if (to_addr < edev->core[row][col].mems.map_size) {
+			ee_core_dirty(edev, row, col, 1, 1, to_addr, size);
 			wcount = ee_write_buf(edev, row, col, to_addr, buf, size);
-		else {
-			reg = *((unsigned *) (buf));
+		} else {
+			memcpy(&reg, buf, sizeof(reg));
 			ee_write_reg(edev, row, col, to_addr, reg);
 			wcount = 4;
 		}
@@ -453,6 +685,19 @@ ssize_t e_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void
 	return wcount;
 }
 
+// Write a memory block to a core in a group
+ssize_t e_write(void *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_write(dev, row, col, to_addr, buf, size);
+	ee_stats_end(E_OP_WRITE, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
 
 static int ee_read_word_native(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
 {
@@ -478,7 +723,14 @@ static int ee_read_word_native(e_epiphany_t *dev, unsigned row, unsigned col, co
 // Read a word from SRAM of a core in a group
 int ee_read_word(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
 {
-	return e_platform.target_ops->ee_read_word(dev, row, col, from_addr);
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_read_word(dev, row, col, from_addr);
+	ee_stats_end(E_OP_T_READ_WORD, t0, sizeof(int), false);
+
+	return rc;
 }
 
 
@@ -505,90 +757,120 @@ static ssize_t ee_write_word_native(e_epiphany_t *dev, unsigned row, unsigned co
 // Write a word to SRAM of a core in a group
 ssize_t ee_write_word(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, int data)
 {
-	return e_platform.target_ops->ee_write_word(dev, row, col, to_addr, data);
-}
-
+	uint64_t t0;
+	ssize_t rc;
 
-static inline void *aligned_memcpy(void *__restrict__ dst,
-		const void *__restrict__ src, size_t size)
-{
-	size_t n, aligned_n;
-	uint8_t *d;
-	const uint8_t *s;
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_write_word(dev, row, col, to_addr, data);
+	ee_stats_end(E_OP_T_WRITE_WORD, t0, rc, rc == E_ERR);
 
-	n = size;
-	d = (uint8_t *) dst;
-	s = (const uint8_t *) src;
+	return rc;
+}
 
-	if (!(((uintptr_t) d ^ (uintptr_t) s) & 3)) {
-		/* dst and src are evenly WORD (un-)aligned */
 
-		/* Align by WORD */
-		if (n && (((uintptr_t) d) & 1)) {
-			*d++ = *s++; n--;
-		}
-		if (((uintptr_t) d) & 2) {
-			if (n > 1) {
-				*((uint16_t *) d) = *((const uint16_t *) s);
-				d+=2; s+=2; n-=2;
-			} else if (n==1) {
-				*d++ = *s++; n--;
-			}
-		}
+// Host <-> mesh copy engine. The transaction width is decided by the mesh
+// side pointer alone: an unaligned head is copied with the widest access its
+// alignment allows, the body with doubleword accesses and the tail narrows
+// back down. The host side goes through memcpy() on a scalar, so a host
+// buffer that is misaligned relative to the mesh address no longer forces
+// byte or half-word transactions on the mesh.
+//
+// With 'burst' set and both sides evenly doubleword (un-)aligned, the body
+// is handed to the C library memcpy(), which is already vectorized for the
+// host (NEON / SSE / AVX).
+//
+// The memory target copies through here too, so e-copy-check can exercise
+// every alignment without hardware.
+
+#define EE_COPY_TO_DEV(type, d, s, n) do {			\
+		type _v;										\
+		memcpy(&_v, (s), sizeof(type));					\
+		*((volatile type *) (d)) = _v;					\
+		(d) += sizeof(type); (s) += sizeof(type); (n) -= sizeof(type); \
+	} while (0)
+
+#define EE_COPY_FROM_DEV(type, d, s, n) do {		\
+		type _v;										\
+		_v = *((volatile const type *) (s));			\
+		memcpy((d), &_v, sizeof(type));					\
+		(d) += sizeof(type); (s) += sizeof(type); (n) -= sizeof(type); \
+	} while (0)
+
+void ee_memcpy_to_dev(void *dst, const void *src, size_t size, bool burst)
+{
+	uint8_t		  *d = (uint8_t *) dst;
+	const uint8_t *s = (const uint8_t *) src;
+	size_t		   n = size, body;
+
+	/* Head: bring the mesh address up to doubleword alignment */
+	if (n >= 1 && ((uintptr_t) d & 1))
+		EE_COPY_TO_DEV(uint8_t, d, s, n);
+	if (n >= 2 && ((uintptr_t) d & 2))
+		EE_COPY_TO_DEV(uint16_t, d, s, n);
+	if (n >= 4 && ((uintptr_t) d & 4))
+		EE_COPY_TO_DEV(uint32_t, d, s, n);
+
+	/* Body */
+	if (burst && !((uintptr_t) s & 7)) {
+		body = n & ~((size_t) 7);
+		memcpy(d, s, body);
+		d += body; s += body; n -= body;
+	}
+	while (n >= 8)
+		EE_COPY_TO_DEV(uint64_t, d, s, n);
 
-		aligned_n = n & (~3);
-		memcpy((void *) d, (void *) s, aligned_n);
-		d += aligned_n; s += aligned_n; n -= aligned_n;
+	/* Tail */
+	if (n >= 4)
+		EE_COPY_TO_DEV(uint32_t, d, s, n);
+	if (n >= 2)
+		EE_COPY_TO_DEV(uint16_t, d, s, n);
+	if (n >= 1)
+		EE_COPY_TO_DEV(uint8_t, d, s, n);
 
-		/* Copy remainder in largest possible chunks */
-		switch (n) {
-		case 2:
-			*((uint16_t *) d) = *((const uint16_t *) s);
-			d+=2; s+=2; n-=2;
-			break;
-		case 3:
-			*((uint16_t *) d) = *((const uint16_t *) s);
-			d+=2; s+=2; n-=2;
-		case 1:
-			*d++ = *s++; n--;
-		}
-	} else if (!(((uintptr_t) d ^ (uintptr_t) s) & 1)) {
-		/* dst and src are evenly half-WORD (un-)aligned */
+	assert(n == 0);
+	assert((uintptr_t) dst + size == (uintptr_t) d);
+}
 
-		/* Align by half-WORD */
-		if (n && ((uintptr_t) d) & 1) {
-			*d++ = *s++; n--;
-		}
+void ee_memcpy_from_dev(void *dst, const void *src, size_t size, bool burst)
+{
+	uint8_t		  *d = (uint8_t *) dst;
+	const uint8_t *s = (const uint8_t *) src;
+	size_t		   n = size, body;
 
-		while (n > 1) {
-			*((uint16_t *) d) = *((const uint16_t *) s);
-			d+=2; s+=2; n-=2;
-		}
+	/* Head: bring the mesh address up to doubleword alignment */
+	if (n >= 1 && ((uintptr_t) s & 1))
+		EE_COPY_FROM_DEV(uint8_t, d, s, n);
+	if (n >= 2 && ((uintptr_t) s & 2))
+		EE_COPY_FROM_DEV(uint16_t, d, s, n);
+	if (n >= 4 && ((uintptr_t) s & 4))
+		EE_COPY_FROM_DEV(uint32_t, d, s, n);
 
-		/* Copy remaining byte */
-		if (n) {
-			*d++ = *s++; n--;
-		}
-	} else {
-		/* Resort to single byte copying */
-		while (n) {
-			*d++ = *s++; n--;
-		}
+	/* Body */
+	if (burst && !((uintptr_t) d & 7)) {
+		body = n & ~((size_t) 7);
+		memcpy(d, s, body);
+		d += body; s += body; n -= body;
 	}
+	while (n >= 8)
+		EE_COPY_FROM_DEV(uint64_t, d, s, n);
+
+	/* Tail */
+	if (n >= 4)
+		EE_COPY_FROM_DEV(uint32_t, d, s, n);
+	if (n >= 2)
+		EE_COPY_FROM_DEV(uint16_t, d, s, n);
+	if (n >= 1)
+		EE_COPY_FROM_DEV(uint8_t, d, s, n);
 
 	assert(n == 0);
-	assert((uintptr_t) dst + size == (uintptr_t) d);
 	assert((uintptr_t) src + size == (uintptr_t) s);
-
-	return dst;
 }
 
 
 static ssize_t ee_read_buf_native(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr, void *buf, size_t size)
 {
 	const void	 *pfrom;
-	unsigned int  addr_from, addr_to, align;
-	int			  i;
+	bool		  burst;
 
 	if (((from_addr + size) > dev->core[row][col].mems.map_size) || (from_addr < 0))
 	{
@@ -600,39 +882,10 @@ static ssize_t ee_read_buf_native(e_epiphany_t *dev, unsigned row, unsigned col,
 	pfrom = dev->core[row][col].mems.base + from_addr;
 	diag(H_D2) { fprintf(diag_fd, "ee_read_buf(): reading from from_addr=0x%08x, pfrom=0x%08x, size=%d\n", (uint) from_addr, (uint) pfrom, (int) size); }
 
-	if ((dev->type == E_E64G401) && ((row >= 1) && (row <= 2)))
-	{
-		// The following code is a fix for the E64G401 anomaly of bursting reads from eCore
-		// internal memory back to host, from rows #1 and #2.
-		addr_from = (unsigned int) pfrom;
-		addr_to	  = (unsigned int) buf;
-		align	  = (addr_from | addr_to | size) & 0x7;
-
-		switch (align) {
-		case 0x0:
-			for (i=0; i<size; i+=sizeof(int64_t))
-				*((int64_t *) (buf + i)) = *((int64_t *) (pfrom + i));
-			break;
-		case 0x1:
-		case 0x3:
-		case 0x5:
-		case 0x7:
-			for (i=0; i<size; i+=sizeof(int8_t))
-				*((int8_t  *) (buf + i)) = *((int8_t  *) (pfrom + i));
-			break;
-		case 0x2:
-		case 0x6:
-			for (i=0; i<size; i+=sizeof(int16_t))
-				*((int16_t *) (buf + i)) = *((int16_t *) (pfrom + i));
-			break;
-		case 0x4:
-			for (i=0; i<size; i+=sizeof(int32_t))
-				*((int32_t *) (buf + i)) = *((int32_t *) (pfrom + i));
-			break;
-		}
-	}
-	else
-		memcpy(buf, pfrom, size);
+	// The E64G401 has an anomaly of bursting reads from eCore internal memory
+	// back to host, from rows #1 and #2. Never burst from those.
+	burst = !((dev->type == E_E64G401) && ((row >= 1) && (row <= 2)));
+	ee_memcpy_from_dev(buf, pfrom, size, burst);
 
 	return size;
 }
@@ -640,7 +893,14 @@ static ssize_t ee_read_buf_native(e_epiphany_t *dev, unsigned row, unsigned col,
 // Read a memory block from SRAM of a core in a group
 ssize_t ee_read_buf(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr, void *buf, size_t size)
 {
-	return e_platform.target_ops->ee_read_buf(dev, row, col, from_addr, buf, size);
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_read_buf(dev, row, col, from_addr, buf, size);
+	ee_stats_end(E_OP_T_READ_BUF, t0, rc, rc == E_ERR);
+
+	return rc;
 }
 
 
@@ -658,7 +918,7 @@ static ssize_t ee_write_buf_native(e_epiphany_t *dev, unsigned row, unsigned col
 	pto = dev->core[row][col].mems.base + to_addr;
 	diag(H_D2) { fprintf(diag_fd, "ee_write_buf(): writing to to_addr=0x%08x, pto=0x%08x, size=%d\n", (uint) to_addr, (uint) pto, (uint) size); }
 
-	aligned_memcpy(pto, buf, size);
+	ee_memcpy_to_dev(pto, buf, size, true);
 
 	return size;
 }
@@ -666,7 +926,14 @@ static ssize_t ee_write_buf_native(e_epiphany_t *dev, unsigned row, unsigned col
 // Write a memory block to SRAM of a core in a group
 ssize_t ee_write_buf(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size)
 {
-	return e_platform.target_ops->ee_write_buf(dev, row, col, to_addr, buf, size);
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_write_buf(dev, row, col, to_addr, buf, size);
+	ee_stats_end(E_OP_T_WRITE_BUF, t0, rc, rc == E_ERR);
+
+	return rc;
 }
 
 static int ee_read_reg_native(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
@@ -698,7 +965,14 @@ static int ee_read_reg_native(e_epiphany_t *dev, unsigned row, unsigned col, con
 // Read a core register from a core in a group
 int ee_read_reg(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
 {
-	return e_platform.target_ops->ee_read_reg(dev, row, col, from_addr);
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_read_reg(dev, row, col, from_addr);
+	ee_stats_end(E_OP_T_READ_REG, t0, sizeof(int), false);
+
+	return rc;
 }
 
 
@@ -728,7 +1002,14 @@ static ssize_t ee_write_reg_native(e_epiphany_t *dev, unsigned row, unsigned col
 // Write to a core register of a core in a group
 ssize_t ee_write_reg(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, int data)
 {
-	return e_platform.target_ops->ee_write_reg(dev, row, col, to_addr, data);
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_write_reg(dev, row, col, to_addr, data);
+	ee_stats_end(E_OP_T_WRITE_REG, t0, rc, rc == E_ERR);
+
+	return rc;
 }
 
 // External Memory access
@@ -739,214 +1020,1235 @@ static int shm_alloc_native(e_mem_t *mbuf)
 	return E_OK;
 }
 
-// Allocate a buffer in external memory
+// Persistent external memory mappings
+//
+// On the native target every external memory segment is mapped once, by
+// the first e_alloc() that falls inside it, and stays mapped until
+// e_finalize(). Buffers are views into that mapping, so e_alloc() and
+// e_free() make no system calls and the page tables are only built once.
+// The mapping is aligned to EE_EMEM_MAP_ALIGN so that a driver which can
+// insert large page mappings gets to use them. Set EHAL_EMEM_MAP=0 to map
+// every buffer separately instead.
+
+#define EE_EMEM_MAP_ALIGN (2UL << 20)
+
+struct ee_emem_map {
+	int		  fd;
+	off_t	  page_base;	  // physical base of the mapping
+	size_t	  size;			  // size of the mapping
+	void	 *base;			  // mapped base address
+	size_t	  page_size;	  // MMU page size backing it, 0 if unknown
+	unsigned  views;		  // buffers currently using it
+	bool	  orphan;		  // unmap when the last view goes away
+};
 
-static int alloc_native(e_mem_t *mbuf)
+static pthread_mutex_t	   ee_emem_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ee_emem_map **ee_emem_maps;
+static int				   ee_emem_num_maps;
+static e_emem_stats_t	   ee_emem_stats;
+
+static bool emem_map_p()
 {
-	mbuf->memfd = open(EPIPHANY_DEV, O_RDWR | O_SYNC);
-	if (mbuf->memfd == -1)
+	static bool initialized = false;
+	static bool emem_map = true;
+	const char *p;
+
+	if (!initialized) {
+		p = getenv("EHAL_EMEM_MAP");
+		emem_map = !(p && !strcmp(p, "0"));
+		initialized = true;
+	}
+
+	return emem_map;
+}
+
+// Look up the MMU page size of the mapping at addr in /proc/self/smaps
+static size_t ee_emem_page_size(void *addr)
+{
+	FILE		  *f;
+	char		   line[256];
+	unsigned long  start, end, kb;
+	bool		   found = false;
+	size_t		   page_size = 0;
+
+	f = fopen("/proc/self/smaps", "r");
+	if (!f)
+		return 0;
+
+	while (fgets(line, sizeof(line), f))
 	{
-		warnx("e_alloc(): EPIPHANY_DEV file open failure.");
+		if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+		{
+			if (found)
+				break;
+			found = ((uintptr_t) addr >= start) && ((uintptr_t) addr < end);
+		}
+		else if (found && sscanf(line, "MMUPageSize: %lu kB", &kb) == 1)
+		{
+			page_size = kb << 10;
+			break;
+		}
+	}
+
+	fclose(f);
+
+	return page_size;
+}
+
+static void ee_emem_update_stats()
+{
+	int i;
+
+	ee_emem_stats.mapped_bytes = 0;
+	ee_emem_stats.tlb_entries = 0;
+	ee_emem_stats.page_size = 0;
+	for (i=0; i<ee_emem_num_maps; i++)
+	{
+		if (!ee_emem_maps[i])
+			continue;
+		ee_emem_stats.mapped_bytes += ee_emem_maps[i]->size;
+		if (ee_emem_maps[i]->page_size)
+		{
+			ee_emem_stats.page_size = ee_emem_maps[i]->page_size;
+			ee_emem_stats.tlb_entries += (ee_emem_maps[i]->size + ee_emem_maps[i]->page_size - 1) / ee_emem_maps[i]->page_size;
+		}
+	}
+}
+
+static void ee_emem_unmap(struct ee_emem_map *map)
+{
+	munmap(map->base, map->size);
+	close(map->fd);
+	free(map);
+	ee_emem_stats.unmaps++;
+}
+
+// Map a whole external memory segment, aligned to EE_EMEM_MAP_ALIGN
+static struct ee_emem_map *ee_emem_map_segment(e_memseg_t *emem)
+{
+	struct ee_emem_map *map;
+	void			   *area, *aligned;
+	size_t				area_size;
+
+	map = calloc(1, sizeof(*map));
+	if (!map)
+		return NULL;
+
+	map->page_base = ee_rndl_page(emem->phy_base);
+	map->size = emem->size + (emem->phy_base - map->page_base);
+
+	map->fd = open(EPIPHANY_DEV, O_RDWR | O_SYNC);
+	if (map->fd == -1)
+	{
+		free(map);
+		return NULL;
+	}
+
+	// Reserve enough address space to align the mapping and put the
+	// segment on top of it
+	area_size = map->size + EE_EMEM_MAP_ALIGN;
+	area = mmap(NULL, area_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (area == MAP_FAILED)
+	{
+		close(map->fd);
+		free(map);
+		return NULL;
+	}
+	aligned = (void *) (((uintptr_t) area + EE_EMEM_MAP_ALIGN - 1) & ~(EE_EMEM_MAP_ALIGN - 1));
+
+	map->base = mmap(aligned, map->size, PROT_READ|PROT_WRITE, MAP_SHARED | MAP_FIXED | MAP_POPULATE, map->fd, map->page_base);
+	if (map->base == MAP_FAILED)
+	{
+		munmap(area, area_size);
+		close(map->fd);
+		free(map);
+		return NULL;
+	}
+
+	if (aligned != area)
+		munmap(area, (char *) aligned - (char *) area);
+	if ((char *) aligned + map->size < (char *) area + area_size)
+		munmap((char *) aligned + map->size, ((char *) area + area_size) - ((char *) aligned + map->size));
+
+	map->page_size = ee_emem_page_size(map->base);
+	ee_emem_stats.maps++;
+
+	diag(H_D1) { fprintf(diag_fd, "e_alloc(): mapped segment phy_base = 0x%08x, base = %p, size = 0x%08x, page size = 0x%x\n", (uint) map->page_base, map->base, (uint) map->size, (uint) map->page_size); }
+
+	return map;
+}
+
+// Make mbuf a view into the persistent mapping of its segment. Fails if
+// the buffer does not fit a segment or the segment can't be mapped.
+static int ee_emem_view(e_mem_t *mbuf)
+{
+	struct ee_emem_map	*map, **maps;
+	e_memseg_t			*emem;
+	int					 i;
+
+	if (!emem_map_p())
+		return E_ERR;
+
+	for (i=0; i<e_platform.num_emems; i++)
+	{
+		emem = &e_platform.emem[i];
+		if ((mbuf->phy_base >= emem->phy_base) &&
+			(mbuf->phy_base + mbuf->emap_size <= emem->phy_base + emem->size))
+			break;
+	}
+	if (i == e_platform.num_emems)
 		return E_ERR;
+	emem = &e_platform.emem[i];
+
+	pthread_mutex_lock(&ee_emem_lock);
+
+	if (ee_emem_num_maps < e_platform.num_emems)
+	{
+		maps = realloc(ee_emem_maps, e_platform.num_emems * sizeof(*maps));
+		if (!maps)
+		{
+			pthread_mutex_unlock(&ee_emem_lock);
+			return E_ERR;
+		}
+		ee_emem_maps = maps;
+		memset(&ee_emem_maps[ee_emem_num_maps], 0, (e_platform.num_emems - ee_emem_num_maps) * sizeof(*ee_emem_maps));
+		ee_emem_num_maps = e_platform.num_emems;
 	}
 
-	diag(H_D2) { fprintf(diag_fd, "e_alloc(): mbuf.phy_base = 0x%08x, mbuf.ephy_base = 0x%08x, mbuf.base = 0x%08x, mbuf.size = 0x%08x\n", (uint) mbuf->phy_base, (uint) mbuf->ephy_base, (uint) mbuf->base, (uint) mbuf->map_size); }
+	map = ee_emem_maps[i];
+	if (!map)
+	{
+		map = ee_emem_map_segment(emem);
+		if (!map)
+		{
+			pthread_mutex_unlock(&ee_emem_lock);
+			diag(H_D1) { fprintf(diag_fd, "e_alloc(): can't map segment %d, using a private mapping.\n", i); }
+			return E_ERR;
+		}
+		ee_emem_maps[i] = map;
+		ee_emem_update_stats();
+	}
+	else
+		ee_emem_stats.reuses++;
+
+	map->views++;
+	ee_emem_stats.views++;
+	ee_emem_stats.live_views++;
+
+	pthread_mutex_unlock(&ee_emem_lock);
+
+	mbuf->memfd = map->fd;
+	mbuf->mapped_base = (char *) map->base + (mbuf->page_base - map->page_base);
+	mbuf->base = (char *) mbuf->mapped_base + mbuf->page_offset;
+	mbuf->priv = map;
+
+	return E_OK;
+}
+
+static void ee_emem_unview(e_mem_t *mbuf)
+{
+	struct ee_emem_map *map = mbuf->priv;
+
+	pthread_mutex_lock(&ee_emem_lock);
+
+	map->views--;
+	ee_emem_stats.live_views--;
+	if (map->orphan && !map->views)
+		ee_emem_unmap(map);
+
+	pthread_mutex_unlock(&ee_emem_lock);
+
+	mbuf->priv = NULL;
+}
+
+// Drop the persistent mappings. Segments which still have views are
+// unmapped when the last one is freed.
+static void ee_emem_finalize()
+{
+	int i;
+
+	pthread_mutex_lock(&ee_emem_lock);
+
+	for (i=0; i<ee_emem_num_maps; i++)
+	{
+		if (!ee_emem_maps[i])
+			continue;
+		if (ee_emem_maps[i]->views)
+			ee_emem_maps[i]->orphan = true;
+		else
+			ee_emem_unmap(ee_emem_maps[i]);
+	}
+
+	free(ee_emem_maps);
+	ee_emem_maps = NULL;
+	ee_emem_num_maps = 0;
+	ee_emem_update_stats();
+
+	pthread_mutex_unlock(&ee_emem_lock);
+}
+
+// Get the external memory mapping statistics
+void e_get_emem_stats(e_emem_stats_t *stats)
+{
+	pthread_mutex_lock(&ee_emem_lock);
+	*stats = ee_emem_stats;
+	pthread_mutex_unlock(&ee_emem_lock);
+}
+
+// Allocate a buffer in external memory
+
+static int alloc_native(e_mem_t *mbuf)
+{
+	if (ee_emem_view(mbuf) == E_OK)
+	{
+		diag(H_D2) { fprintf(diag_fd, "e_alloc(): mbuf.phy_base = 0x%08x, mbuf.ephy_base = 0x%08x, mbuf.base = 0x%08x, mbuf.size = 0x%08x (view)\n", (uint) mbuf->phy_base, (uint) mbuf->ephy_base, (uint) mbuf->base, (uint) mbuf->map_size); }
+		return E_OK;
+	}
+
+	pthread_mutex_lock(&ee_emem_lock);
+	ee_emem_stats.private_maps++;
+	pthread_mutex_unlock(&ee_emem_lock);
+
+	mbuf->memfd = open(EPIPHANY_DEV, O_RDWR | O_SYNC);
+	if (mbuf->memfd == -1)
+	{
+		warnx("e_alloc(): EPIPHANY_DEV file open failure.");
+		return E_ERR;
+	}
+
+	diag(H_D2) { fprintf(diag_fd, "e_alloc(): mbuf.phy_base = 0x%08x, mbuf.ephy_base = 0x%08x, mbuf.base = 0x%08x, mbuf.size = 0x%08x\n", (uint) mbuf->phy_base, (uint) mbuf->ephy_base, (uint) mbuf->base, (uint) mbuf->map_size); }
+
+	mbuf->mapped_base = mmap(NULL, mbuf->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, mbuf->memfd, mbuf->page_base);
+	mbuf->base = (void*)(((char*)mbuf->mapped_base) + mbuf->page_offset);
+
+	if (mbuf->mapped_base == MAP_FAILED)
+	{
+		warnx("e_alloc(): mmap failure.");
+		return E_ERR;
+	}
+
+	return E_OK;
+}
+
+static int ee_alloc(e_mem_t *mbuf, off_t offset, size_t size)
+{
+	if (e_platform.initialized == E_FALSE)
+	{
+		warnx("e_alloc(): Platform was not initialized. Use e_init().");
+		return E_ERR;
+	}
+
+	mbuf->objtype = E_EXT_MEM;
+	mbuf->priv = NULL;
+
+	diag(H_D2) { fprintf(diag_fd, "e_alloc(): allocating EMEM buffer at offset 0x%08x\n", (uint) offset); }
+
+	mbuf->phy_base = (e_platform.emem[0].phy_base + offset); // TODO: this takes only the 1st segment into account
+	mbuf->page_base = ee_rndl_page(mbuf->phy_base);
+	mbuf->page_offset = mbuf->phy_base - mbuf->page_base;
+	mbuf->map_size = size + mbuf->page_offset;
+
+	mbuf->ephy_base = (e_platform.emem[0].ephy_base + offset); // TODO: this takes only the 1st segment into account
+	mbuf->emap_size = size;
+
+	return e_platform.target_ops->alloc(mbuf);
+}
+
+int e_alloc(e_mem_t *mbuf, off_t offset, size_t size)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_alloc(mbuf, offset, size);
+	ee_stats_end(E_OP_ALLOC, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+// Free a memory buffer in external memory
+
+static int free_native(e_mem_t *mbuf)
+{
+	if (mbuf->priv)
+	{
+		ee_emem_unview(mbuf);
+		return E_OK;
+	}
+
+	munmap(mbuf->mapped_base, mbuf->map_size);
+	close(mbuf->memfd);
+
+	return E_OK;
+}
+
+static int ee_free(e_mem_t *mbuf)
+{
+	if (!mbuf)
+		return E_ERR;
+
+	if (E_SHARED_MEM == mbuf->objtype) {
+		// The shared memory mapping is persistent - don't unmap
+		return E_OK;
+	}
+
+	return e_platform.target_ops->free(mbuf);
+}
+
+int e_free(e_mem_t *mbuf)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_free(mbuf);
+	ee_stats_end(E_OP_FREE, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+
+// Read a block from an external memory buffer
+ssize_t ee_mread(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+{
+	ssize_t rcount;
+
+	rcount = ee_mread_buf(mbuf, from_addr, buf, size);
+
+	return rcount;
+}
+
+
+// Write a block to an external memory buffer
+ssize_t ee_mwrite(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
+{
+	ssize_t wcount;
+
+	wcount = ee_mwrite_buf(mbuf, to_addr, buf, size);
+
+	return wcount;
+}
+
+
+static int ee_mread_word_native(e_mem_t *mbuf, const off_t from_addr)
+{
+	volatile int *pfrom;
+	int			  data;
+	ssize_t		  size;
+
+	size = sizeof(int);
+	if (((from_addr + size) > mbuf->map_size) || (from_addr < 0))
+	{
+		diag(H_D2) { fprintf(diag_fd, "ee_mread_word(): writing to from_addr=0x%08x, size=%d, map_size=0x%x\n", (uint) from_addr, (uint) size, (uint) mbuf->map_size); }
+		warnx("ee_mread_word(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	pfrom = (int *) (mbuf->base + from_addr);
+	diag(H_D2) { fprintf(diag_fd, "ee_mread_word(): reading from from_addr=0x%08x, pfrom=0x%08x\n", (uint) from_addr, (uint) pfrom); }
+	data  = *pfrom;
+
+	return data;
+}
+
+// Read a word from an external memory buffer
+int ee_mread_word(e_mem_t *mbuf, const off_t from_addr)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_mread_word(mbuf, from_addr);
+	ee_stats_end(E_OP_T_MREAD_WORD, t0, sizeof(int), false);
+
+	return rc;
+}
+
+
+static ssize_t ee_mwrite_word_native(e_mem_t *mbuf, off_t to_addr, int data)
+{
+	int		*pto;
+	ssize_t	 size;
+
+	size = sizeof(int);
+	if (((to_addr + size) > mbuf->map_size) || (to_addr < 0))
+	{
+		diag(H_D2) { fprintf(diag_fd, "ee_mwrite_word(): writing to to_addr=0x%08x, size=%d, map_size=0x%x\n", (uint) to_addr, (uint) size, (uint) mbuf->map_size); }
+		warnx("ee_mwrite_word(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	pto = (int *) (mbuf->base + to_addr);
+	diag(H_D2) { fprintf(diag_fd, "ee_mwrite_word(): writing to to_addr=0x%08x, pto=0x%08x\n", (uint) to_addr, (uint) pto); }
+	*pto = data;
+
+	return sizeof(int);
+}
+
+// Write a word to an external memory buffer
+ssize_t ee_mwrite_word(e_mem_t *mbuf, off_t to_addr, int data)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_mwrite_word(mbuf, to_addr, data);
+	ee_stats_end(E_OP_T_MWRITE_WORD, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+
+static ssize_t ee_mread_buf_native(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+{
+	const void *pfrom;
+
+	if (((from_addr + size) > mbuf->map_size) || (from_addr < 0))
+	{
+		warnx("ee_mread_buf(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	pfrom = mbuf->base + from_addr;
+
+	diag(H_D1) {
+		fprintf(diag_fd, "ee_mread_buf(): reading from from_addr=0x%08x, "
+				"offset=0x%08x, size=%d, map_size=0x%x\n", (uint) pfrom,
+				(uint)from_addr, (uint) size, (uint) mbuf->map_size);
+	}
+
+	ee_memcpy_from_dev(buf, pfrom, size, true);
+
+	return size;
+}
+
+// Read a block from an external memory buffer
+ssize_t ee_mread_buf(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_mread_buf(mbuf, from_addr, buf, size);
+	ee_stats_end(E_OP_T_MREAD_BUF, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+
+static ssize_t ee_mwrite_buf_native(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
+{
+	void *pto;
+
+	if (((to_addr + size) > mbuf->map_size) || (to_addr < 0))
+	{
+		warnx("ee_mwrite_buf(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	pto = mbuf->base + to_addr;
+
+	if ( E_SHARED_MEM == mbuf->objtype ) {
+		diag(H_D1) {
+		  fprintf(diag_fd, "ee_mwrite_buf(): writing to to_addr=0x%08x, "
+				  "offset=0x%08x, size=%d, map_size=0x%x\n", (uint) pto,
+				  (uint)to_addr, (uint) size, (uint) mbuf->map_size);
+		}
+	}
+	ee_memcpy_to_dev(pto, buf, size, true);
+
+	return size;
+}
+
+// Write a block to an external memory buffer
+ssize_t ee_mwrite_buf(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->ee_mwrite_buf(mbuf, to_addr, buf, size);
+	ee_stats_end(E_OP_T_MWRITE_BUF, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+
+// Scatter-gather transfers
+//
+// A batch is validated once, sorted by object, core and address and then
+// handed to the target's ee_read_v / ee_write_v hook. Targets without a hook
+// get one call per descriptor into their regular buffer operators. A write
+// batch in which two descriptors overlap on the same object and core is not
+// sorted, so later descriptors land on top of earlier ones. Overlaps through
+// different objects mapping the same memory are not detected.
+
+#define EE_IOV_STACK 64
+
+static bool ee_iov_reg_p(const e_iovec_t *iov)
+{
+	e_epiphany_t *edev = (e_epiphany_t *) iov->dev;
+
+	return (*((e_objtype_t *) iov->dev) == E_EPI_GROUP) &&
+		   (iov->addr >= edev->core[iov->row][iov->col].mems.map_size);
+}
+
+static int ee_iov_check(const char *fn, const e_iovec_t *iov)
+{
+	e_epiphany_t *edev;
+	e_mem_t		 *mdev;
+
+	if (!iov->dev || (!iov->buf && iov->size))
+	{
+		warnx("%s: Invalid descriptor.", fn);
+		return E_ERR;
+	}
+
+	switch (*((e_objtype_t *) iov->dev))
+	{
+	case E_EPI_GROUP:
+		edev = (e_epiphany_t *) iov->dev;
+		if ((iov->row >= edev->rows) || (iov->col >= edev->cols) || (iov->addr < 0))
+		{
+			warnx("%s: Core (%d,%d) is out of bounds.", fn, iov->row, iov->col);
+			return E_ERR;
+		}
+		if (ee_iov_reg_p(iov))
+		{
+			if (iov->size != sizeof(unsigned))
+			{
+				warnx("%s: Register accesses must be one word.", fn);
+				return E_ERR;
+			}
+		}
+		else if ((iov->addr + iov->size) > edev->core[iov->row][iov->col].mems.map_size)
+		{
+			warnx("%s: Buffer range is out of bounds.", fn);
+			return E_ERR;
+		}
+		break;
+
+	case E_SHARED_MEM:	// Fall-through
+	case E_EXT_MEM:
+		mdev = (e_mem_t *) iov->dev;
+		if (((iov->addr + iov->size) > mdev->map_size) || (iov->addr < 0))
+		{
+			warnx("%s: Address is out of bounds.", fn);
+			return E_ERR;
+		}
+		break;
+
+	default:
+		warnx("%s: Invalid object type.", fn);
+		return E_ERR;
+	}
+
+	return E_OK;
+}
+
+static int ee_iov_cmp(const e_iovec_t *a, const e_iovec_t *b)
+{
+	if (a->dev != b->dev)
+		return ((uintptr_t) a->dev < (uintptr_t) b->dev) ? -1 : 1;
+	if (*((e_objtype_t *) a->dev) == E_EPI_GROUP)
+	{
+		if (a->row != b->row)
+			return (a->row < b->row) ? -1 : 1;
+		if (a->col != b->col)
+			return (a->col < b->col) ? -1 : 1;
+	}
+	if (a->addr != b->addr)
+		return (a->addr < b->addr) ? -1 : 1;
+
+	return 0;
+}
+
+static int ee_iov_qsort_cmp(const void *a, const void *b)
+{
+	const e_iovec_t *va = *((const e_iovec_t * const *) a);
+	const e_iovec_t *vb = *((const e_iovec_t * const *) b);
+	int				 rc;
+
+	// Keep descriptors for the same address in submission order
+	rc = ee_iov_cmp(va, vb);
+	if (!rc)
+		rc = (va < vb) ? -1 : (va > vb);
+
+	return rc;
+}
+
+// Whether b, sorted after a, overlaps it
+static bool ee_iov_overlap_p(const e_iovec_t *a, const e_iovec_t *b)
+{
+	if (a->dev != b->dev)
+		return false;
+	if (*((e_objtype_t *) a->dev) == E_EPI_GROUP
+		&& (a->row != b->row || a->col != b->col))
+		return false;
+
+	return a->addr + (off_t) a->size > b->addr;
+}
+
+static ssize_t ee_xfer_v(const e_iovec_t * const *iov, unsigned count, bool write)
+{
+	const e_iovec_t *v;
+	e_epiphany_t	*edev;
+	ssize_t			 rc;
+	unsigned		 i, reg;
+
+	for (i=0; i<count; i++)
+	{
+		v = iov[i];
+		edev = (e_epiphany_t *) v->dev;
+
+		// The host buffer need not be word aligned
+		if (ee_iov_reg_p(v))
+		{
+			if (write)
+			{
+				memcpy(&reg, v->buf, sizeof(reg));
+				rc = ee_write_reg(edev, v->row, v->col, v->addr, reg);
+			}
+			else
+			{
+				reg = ee_read_reg(edev, v->row, v->col, v->addr);
+				memcpy(v->buf, &reg, sizeof(reg));
+				rc = E_OK;
+			}
+		}
+		else if (*((e_objtype_t *) v->dev) == E_EPI_GROUP)
+			rc = write ? ee_write_buf(edev, v->row, v->col, v->addr, v->buf, v->size)
+					   : ee_read_buf(edev, v->row, v->col, v->addr, v->buf, v->size);
+		else
+			rc = write ? ee_mwrite_buf((e_mem_t *) v->dev, v->addr, v->buf, v->size)
+					   : ee_mread_buf((e_mem_t *) v->dev, v->addr, v->buf, v->size);
+
+		if (rc == E_ERR)
+			return E_ERR;
+	}
+
+	return E_OK;
+}
+
+// Default batch hook for targets whose core and buffer descriptors point at
+// host accessible memory. The batch is already validated, so the copies go
+// straight to the copy engine.
+static ssize_t ee_xfer_v_direct(const e_iovec_t * const *iov, unsigned count, bool write)
+{
+	const e_iovec_t *v;
+	e_epiphany_t	*edev;
+	void			*p;
+	bool			 burst;
+	unsigned		 i;
+
+	for (i=0; i<count; i++)
+	{
+		v = iov[i];
+
+		if (ee_iov_reg_p(v))
+		{
+			if (ee_xfer_v(&iov[i], 1, write) == E_ERR)
+				return E_ERR;
+			continue;
+		}
+
+		if (*((e_objtype_t *) v->dev) == E_EPI_GROUP)
+		{
+			edev = (e_epiphany_t *) v->dev;
+			p = edev->core[v->row][v->col].mems.base + v->addr;
+			// See ee_read_buf_native()
+			burst = !((edev->type == E_E64G401) && ((v->row >= 1) && (v->row <= 2)));
+		}
+		else
+		{
+			p = ((e_mem_t *) v->dev)->base + v->addr;
+			burst = true;
+		}
+
+		if (write)
+			ee_memcpy_to_dev(p, v->buf, v->size, true);
+		else
+			ee_memcpy_from_dev(v->buf, p, v->size, burst);
+	}
+
+	return E_OK;
+}
+
+ssize_t _e_default_read_v(const e_iovec_t * const *iov, unsigned count)
+{
+	return ee_xfer_v_direct(iov, count, false);
+}
+
+ssize_t _e_default_write_v(const e_iovec_t * const *iov, unsigned count)
+{
+	return ee_xfer_v_direct(iov, count, true);
+}
+
+static ssize_t ee_rw_v(const char *fn, const e_iovec_t *iov, unsigned count, bool write)
+{
+	const e_iovec_t	 *stack[EE_IOV_STACK];
+	const e_iovec_t **sorted;
+	ssize_t			  total, rc;
+	bool			  in_order;
+	unsigned		  i;
+	uint64_t		  t0;
+
+	if (!iov && count)
+	{
+		warnx("%s: Invalid descriptor array.", fn);
+		return E_ERR;
+	}
+
+	total = 0;
+	in_order = true;
+	for (i=0; i<count; i++)
+	{
+		if (ee_iov_check(fn, &iov[i]) != E_OK)
+			return E_ERR;
+		if (write && *((e_objtype_t *) iov[i].dev) == E_EPI_GROUP)
+			ee_core_dirty(iov[i].dev, iov[i].row, iov[i].col, 1, 1, iov[i].addr, iov[i].size);
+		if (i && ee_iov_cmp(&iov[i-1], &iov[i]) > 0)
+			in_order = false;
+		total += iov[i].size;
+	}
+
+	if (count <= EE_IOV_STACK)
+		sorted = stack;
+	else
+	{
+		sorted = malloc(count * sizeof(*sorted));
+		if (!sorted)
+		{
+			warnx("%s: Error while allocating descriptors.", fn);
+			return E_ERR;
+		}
+	}
+
+	for (i=0; i<count; i++)
+		sorted[i] = &iov[i];
+	if (!in_order)
+	{
+		qsort(sorted, count, sizeof(*sorted), ee_iov_qsort_cmp);
+
+		// Any overlap shows up between neighbours once sorted. Overlapping
+		// writes keep their submission order.
+		for (i=1; write && !in_order && i<count; i++)
+			if (ee_iov_overlap_p(sorted[i-1], sorted[i]))
+				in_order = true;
+		if (in_order)
+			for (i=0; i<count; i++)
+				sorted[i] = &iov[i];
+	}
+
+	diag(H_D2) { fprintf(diag_fd, "%s: %u descriptors, %d bytes%s\n", fn, count, (int) total, in_order ? "" : ", sorted"); }
+
+	t0 = ee_stats_begin();
+	if (write && e_platform.target_ops->ee_write_v)
+		rc = e_platform.target_ops->ee_write_v(sorted, count);
+	else if (!write && e_platform.target_ops->ee_read_v)
+		rc = e_platform.target_ops->ee_read_v(sorted, count);
+	else
+		rc = ee_xfer_v(sorted, count, write);
+	ee_stats_end(write ? E_OP_T_WRITE_V : E_OP_T_READ_V, t0, total, rc == E_ERR);
+
+	if (sorted != stack)
+		free(sorted);
+
+	return (rc == E_ERR) ? E_ERR : total;
+}
+
+// Read a batch of memory blocks from cores and external memory buffers
+ssize_t e_read_v(const e_iovec_t *iov, unsigned count)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_rw_v("e_read_v()", iov, count, false);
+	ee_stats_end(E_OP_READ_V, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+// Write a batch of memory blocks to cores and external memory buffers
+ssize_t e_write_v(const e_iovec_t *iov, unsigned count)
+{
+	uint64_t t0;
+	ssize_t rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_rw_v("e_write_v()", iov, count, true);
+	ee_stats_end(E_OP_WRITE_V, t0, rc, rc == E_ERR);
+
+	return rc;
+}
+
+
+// Broadcast writes
+//
+// The same block is written to every core in a rectangle of the group. A
+// target that can drive the mesh multicast path provides ee_write_broadcast.
+// Everyone else gets one descriptor per core through the batch path, in
+// row-major order. With EHAL_LOAD_THREADS set, large broadcasts spread the
+// rows over as many threads, the same as the loader does, so the rows are
+// written in parallel; the calling thread takes the first share. Smaller
+// ones, and all of them on the simulator, are written serially.
+// Addresses are taken like e_write() takes them: past SRAM is a register,
+// which gets the first word of the buffer.
+
+// Broadcasts of fewer bytes in total don't pay for the threads
+#define EE_BROADCAST_FANOUT_MIN 65536
+
+// Number of worker threads row parallel work is spread over, from
+// EHAL_LOAD_THREADS. Zero or unset means the calling thread does it all.
+unsigned ee_row_threads()
+{
+	static bool initialized = false;
+	static unsigned threads = 0;
+	const char *p;
+
+	if (!initialized) {
+		p = getenv("EHAL_LOAD_THREADS");
+		threads = p ? strtoul(p, NULL, 0) : 0;
+		if (threads > EE_ROW_MAX_THREADS)
+			threads = EE_ROW_MAX_THREADS;
+		initialized = true;
+	}
+
+	return threads;
+}
+
+struct ee_broadcast_job {
+	const e_iovec_t *iov;
+	unsigned		 count;
+	ssize_t			 rc;
+};
+
+static void *ee_broadcast_rows(void *arg)
+{
+	struct ee_broadcast_job *job = arg;
+
+	job->rc = ee_rw_v("e_write_broadcast()", job->iov, job->count, true);
+
+	return NULL;
+}
+
+// Write the row-major descriptors of a broadcast, spreading the rows over
+// the worker threads
+static ssize_t ee_broadcast_fanout(const e_iovec_t *iov, unsigned rows,
+								   unsigned cols, size_t count)
+{
+	struct ee_broadcast_job jobs[EE_ROW_MAX_THREADS];
+	pthread_t	 threads[EE_ROW_MAX_THREADS];
+	unsigned	 i, njobs, started, first;
+	ssize_t		 rc = 0;
+
+	njobs = ee_row_threads();
+	if (njobs > rows)
+		njobs = rows;
+	if (njobs < 2 || ee_esim_target_p()
+		|| (uint64_t) count * rows * cols < EE_BROADCAST_FANOUT_MIN)
+		return ee_rw_v("e_write_broadcast()", iov, rows * cols, true);
+
+	// Job i gets rows [i * rows / njobs, (i + 1) * rows / njobs)
+	for (i = 0; i < njobs; i++)
+	{
+		first = i * rows / njobs;
+		jobs[i].iov   = &iov[first * cols];
+		jobs[i].count = ((i + 1) * rows / njobs - first) * cols;
+		jobs[i].rc    = E_ERR;
+	}
+
+	for (started = 1; started < njobs; started++)
+		if (pthread_create(&threads[started], NULL, ee_broadcast_rows, &jobs[started]))
+		{
+			diag(H_D1) { fprintf(diag_fd, "e_write_broadcast(): can't create thread, writing %u rows serially\n", njobs - started); }
+			break;
+		}
+
+	ee_broadcast_rows(&jobs[0]);
+	for (i = started; i < njobs; i++)
+		ee_broadcast_rows(&jobs[i]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	diag(H_D2) { fprintf(diag_fd, "e_write_broadcast(): %u rows over %u threads\n", rows, started); }
+
+	for (i = 0; i < njobs; i++)
+		if (jobs[i].rc == E_ERR)
+			rc = E_ERR;
 
-	mbuf->mapped_base = mmap(NULL, mbuf->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, mbuf->memfd, mbuf->page_base);
-	mbuf->base = (void*)(((char*)mbuf->mapped_base) + mbuf->page_offset);
+	return rc;
+}
 
-	if (mbuf->mapped_base == MAP_FAILED)
+ssize_t ee_write_broadcast(e_epiphany_t *dev, unsigned row, unsigned col,
+						   unsigned rows, unsigned cols, off_t to_addr,
+						   const void *buf, size_t size)
+{
+	e_iovec_t	 stack[EE_IOV_STACK];
+	e_iovec_t	*iov;
+	ssize_t		 rc;
+	unsigned	 i, j, n;
+	uint64_t	 t0;
+	size_t		 count;
+
+	if (!dev || (*((e_objtype_t *) dev) != E_EPI_GROUP))
 	{
-		warnx("e_alloc(): mmap failure.");
+		warnx("e_write_broadcast(): Invalid object type.");
 		return E_ERR;
 	}
 
-	return E_OK;
-}
-
-int e_alloc(e_mem_t *mbuf, off_t offset, size_t size)
-{
-	if (e_platform.initialized == E_FALSE)
+	if (!rows || !cols || ((row + rows) > dev->rows) || ((col + cols) > dev->cols))
 	{
-		warnx("e_alloc(): Platform was not initialized. Use e_init().");
+		warnx("e_write_broadcast(): Cores are out of bounds.");
 		return E_ERR;
 	}
 
-	mbuf->objtype = E_EXT_MEM;
-	mbuf->priv = NULL;
+	if (e_platform.target_ops->ee_write_broadcast)
+	{
+		ee_core_dirty(dev, row, col, rows, cols, to_addr, size);
+		t0 = ee_stats_begin();
+		rc = e_platform.target_ops->ee_write_broadcast(dev, row, col, rows, cols, to_addr, buf, size);
+		ee_stats_end(E_OP_T_WRITE_BROADCAST, t0, rc, rc == E_ERR);
+		return rc;
+	}
 
-	diag(H_D2) { fprintf(diag_fd, "e_alloc(): allocating EMEM buffer at offset 0x%08x\n", (uint) offset); }
+	// See ee_write()
+	count = size;
+	if (to_addr >= dev->core[row][col].mems.map_size)
+		count = sizeof(unsigned);
 
-	mbuf->phy_base = (e_platform.emem[0].phy_base + offset); // TODO: this takes only the 1st segment into account
-	mbuf->page_base = ee_rndl_page(mbuf->phy_base);
-	mbuf->page_offset = mbuf->phy_base - mbuf->page_base;
-	mbuf->map_size = size + mbuf->page_offset;
+	n = rows * cols;
+	if (n <= EE_IOV_STACK)
+		iov = stack;
+	else
+	{
+		iov = malloc(n * sizeof(*iov));
+		if (!iov)
+		{
+			warnx("e_write_broadcast(): Error while allocating descriptors.");
+			return E_ERR;
+		}
+	}
 
-	mbuf->ephy_base = (e_platform.emem[0].ephy_base + offset); // TODO: this takes only the 1st segment into account
-	mbuf->emap_size = size;
+	n = 0;
+	for (i=row; i<row+rows; i++)
+		for (j=col; j<col+cols; j++)
+			iov[n++] = (e_iovec_t) {
+				.dev  = dev,
+				.row  = i,
+				.col  = j,
+				.addr = to_addr,
+				.buf  = (void *) buf,
+				.size = count,
+			};
 
-	return e_platform.target_ops->alloc(mbuf);
-}
+	diag(H_D2) { fprintf(diag_fd, "e_write_broadcast(): %u cores, %d bytes at 0x%08x\n", n, (int) count, (uint) to_addr); }
 
-// Free a memory buffer in external memory
+	rc = ee_broadcast_fanout(iov, rows, cols, count);
 
-static int free_native(e_mem_t *mbuf)
-{
-	munmap(mbuf->mapped_base, mbuf->map_size);
-	close(mbuf->memfd);
+	if (iov != stack)
+		free(iov);
 
-	return E_OK;
+	return (rc == E_ERR) ? E_ERR : (ssize_t) count;
 }
 
-int e_free(e_mem_t *mbuf)
+static ssize_t ee_write_broadcast_group(e_epiphany_t *dev, off_t to_addr, const void *buf, size_t size)
 {
-	if (!mbuf)
+	if (!dev)
+	{
+		warnx("e_write_broadcast(): Invalid object type.");
 		return E_ERR;
-
-	if (E_SHARED_MEM == mbuf->objtype) {
-		// The shared memory mapping is persistent - don't unmap
-		return E_OK;
 	}
 
-	return e_platform.target_ops->free(mbuf);
+	return ee_write_broadcast(dev, 0, 0, dev->rows, dev->cols, to_addr, buf, size);
 }
 
-
-// Read a block from an external memory buffer
-ssize_t ee_mread(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+// Write the same memory block to all cores in a group. Unless the target
+// can multicast, the rows are written from EHAL_LOAD_THREADS threads, see
+// ee_write_broadcast().
+ssize_t e_write_broadcast(e_epiphany_t *dev, off_t to_addr, const void *buf, size_t size)
 {
-	ssize_t rcount;
+	uint64_t t0;
+	ssize_t rc;
 
-	rcount = ee_mread_buf(mbuf, from_addr, buf, size);
+	t0 = ee_stats_begin();
+	rc = ee_write_broadcast_group(dev, to_addr, buf, size);
+	ee_stats_end(E_OP_WRITE_BROADCAST, t0, rc, rc == E_ERR);
 
-	return rcount;
+	return rc;
 }
 
 
-// Write a block to an external memory buffer
-ssize_t ee_mwrite(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
-{
-	ssize_t wcount;
-
-	wcount = ee_mwrite_buf(mbuf, to_addr, buf, size);
-
-	return wcount;
-}
+// Register file snapshots
+//
+// A snapshot is read one contiguous register block at a time through the
+// target's ee_read_regs hook. Targets without a hook get one ee_read_reg
+// call per register.
+
+#define EE_REG_BLOCK(_set, _first, _field) \
+	{ _set, _first, sizeof(((e_core_regs_t *) 0)->_field) / sizeof(unsigned), \
+	  offsetof(e_core_regs_t, _field) }
+
+static const struct {
+	unsigned	set;
+	off_t		first;
+	unsigned	count;
+	size_t		offset;
+} ee_reg_blocks[] = {
+	EE_REG_BLOCK(E_REGS_GPR,	 E_REG_R0,		   gpr),
+	EE_REG_BLOCK(E_REGS_CTRL,	 E_REG_CONFIG,	   ctrl),
+	EE_REG_BLOCK(E_REGS_DMA,	 E_REG_DMA0CONFIG, dma),
+	EE_REG_BLOCK(E_REGS_MEMPROT, E_REG_MEMSTATUS,  memprot),
+	EE_REG_BLOCK(E_REGS_MESH,	 E_REG_MESHCONFIG, mesh),
+};
 
+#define EE_REG_BLOCKS (sizeof(ee_reg_blocks) / sizeof(ee_reg_blocks[0]))
 
-static int ee_mread_word_native(e_mem_t *mbuf, const off_t from_addr)
+// Default hook for targets whose register files are mapped into the host.
+// The register space only takes single word accesses, so this is a loop of
+// word loads without the per-register dispatch and range checks.
+ssize_t _e_default_read_regs(e_epiphany_t *dev, unsigned row, unsigned col, off_t from_addr, unsigned *buf, unsigned count)
 {
-	volatile int *pfrom;
-	int			  data;
-	ssize_t		  size;
+	volatile unsigned *pfrom;
+	off_t			   addr;
+	unsigned		   i;
 
-	size = sizeof(int);
-	if (((from_addr + size) > mbuf->map_size) || (from_addr < 0))
+	addr = from_addr - E_REG_R0;
+	if ((addr < 0) || ((addr + count * sizeof(unsigned)) > dev->core[row][col].regs.map_size))
 	{
-		diag(H_D2) { fprintf(diag_fd, "ee_mread_word(): writing to from_addr=0x%08x, size=%d, map_size=0x%x\n", (uint) from_addr, (uint) size, (uint) mbuf->map_size); }
-		warnx("ee_mread_word(): Address is out of bounds.");
+		warnx("ee_read_regs(): Address is out of bounds.");
 		return E_ERR;
 	}
 
-	pfrom = (int *) (mbuf->base + from_addr);
-	diag(H_D2) { fprintf(diag_fd, "ee_mread_word(): reading from from_addr=0x%08x, pfrom=0x%08x\n", (uint) from_addr, (uint) pfrom); }
-	data  = *pfrom;
+	pfrom = (volatile unsigned *) (dev->core[row][col].regs.base + addr);
+	for (i=0; i<count; i++)
+		buf[i] = pfrom[i];
 
-	return data;
+	return count * sizeof(unsigned);
 }
 
-// Read a word from an external memory buffer
-int ee_mread_word(e_mem_t *mbuf, const off_t from_addr)
+static int ee_read_regs(e_epiphany_t *dev, unsigned row, unsigned col, unsigned reg_set, e_core_regs_t *regs)
 {
-	return e_platform.target_ops->ee_mread_word(mbuf, from_addr);
-}
+	unsigned *p;
+	unsigned  i, j;
+	ssize_t	  rc;
+	uint64_t  t0;
 
+	for (i=0; i<EE_REG_BLOCKS; i++)
+	{
+		if (!(reg_set & ee_reg_blocks[i].set))
+			continue;
 
-static ssize_t ee_mwrite_word_native(e_mem_t *mbuf, off_t to_addr, int data)
-{
-	int		*pto;
-	ssize_t	 size;
+		p = (unsigned *) ((char *) regs + ee_reg_blocks[i].offset);
 
-	size = sizeof(int);
-	if (((to_addr + size) > mbuf->map_size) || (to_addr < 0))
-	{
-		diag(H_D2) { fprintf(diag_fd, "ee_mwrite_word(): writing to to_addr=0x%08x, size=%d, map_size=0x%x\n", (uint) to_addr, (uint) size, (uint) mbuf->map_size); }
-		warnx("ee_mwrite_word(): Address is out of bounds.");
-		return E_ERR;
+		if (e_platform.target_ops->ee_read_regs)
+		{
+			t0 = ee_stats_begin();
+			rc = e_platform.target_ops->ee_read_regs(dev, row, col, ee_reg_blocks[i].first, p, ee_reg_blocks[i].count);
+			ee_stats_end(E_OP_T_READ_REGS, t0, rc, rc == E_ERR);
+			if (rc == E_ERR)
+				return E_ERR;
+		}
+		else
+		{
+			for (j=0; j<ee_reg_blocks[i].count; j++)
+				p[j] = ee_read_reg(dev, row, col, ee_reg_blocks[i].first + j * sizeof(unsigned));
+		}
 	}
 
-	pto = (int *) (mbuf->base + to_addr);
-	diag(H_D2) { fprintf(diag_fd, "ee_mwrite_word(): writing to to_addr=0x%08x, pto=0x%08x\n", (uint) to_addr, (uint) pto); }
-	*pto = data;
-
-	return sizeof(int);
+	return E_OK;
 }
 
-// Write a word to an external memory buffer
-ssize_t ee_mwrite_word(e_mem_t *mbuf, off_t to_addr, int data)
+static int ee_read_regs_check(const char *fn, e_epiphany_t *dev, unsigned reg_set, e_core_regs_t *regs)
 {
-	return e_platform.target_ops->ee_mwrite_word(mbuf, to_addr, data);
-}
+	if (!dev || (*((e_objtype_t *) dev) != E_EPI_GROUP))
+	{
+		warnx("%s: Invalid object type.", fn);
+		return E_ERR;
+	}
+
+	if (!regs || !reg_set || (reg_set & ~E_REGS_ALL))
+	{
+		warnx("%s: Invalid register set.", fn);
+		return E_ERR;
+	}
 
+	return E_OK;
+}
 
-static ssize_t ee_mread_buf_native(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+static int ee_read_regs_core(e_epiphany_t *dev, unsigned row, unsigned col, unsigned reg_set, e_core_regs_t *regs)
 {
-	const void *pfrom;
+	if (ee_read_regs_check("e_read_regs()", dev, reg_set, regs) != E_OK)
+		return E_ERR;
 
-	if (((from_addr + size) > mbuf->map_size) || (from_addr < 0))
+	if ((row >= dev->rows) || (col >= dev->cols))
 	{
-		warnx("ee_mread_buf(): Address is out of bounds.");
+		warnx("e_read_regs(): Core (%d,%d) is out of bounds.", row, col);
 		return E_ERR;
 	}
 
-	pfrom = mbuf->base + from_addr;
+	return ee_read_regs(dev, row, col, reg_set, regs);
+}
 
-	diag(H_D1) {
-		fprintf(diag_fd, "ee_mread_buf(): reading from from_addr=0x%08x, "
-				"offset=0x%08x, size=%d, map_size=0x%x\n", (uint) pfrom,
-				(uint)from_addr, (uint) size, (uint) mbuf->map_size);
-	}
+// Read a snapshot of the register file of a core in a group
+int e_read_regs(e_epiphany_t *dev, unsigned row, unsigned col, unsigned reg_set, e_core_regs_t *regs)
+{
+	uint64_t t0;
+	int rc;
 
-	memcpy(buf, pfrom, size);
+	t0 = ee_stats_begin();
+	rc = ee_read_regs_core(dev, row, col, reg_set, regs);
+	ee_stats_end(E_OP_READ_REGS, t0, 0, rc == E_ERR);
 
-	return size;
+	return rc;
 }
 
-// Read a block from an external memory buffer
-ssize_t ee_mread_buf(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+static int ee_read_regs_group(e_epiphany_t *dev, unsigned reg_set, e_core_regs_t *regs)
 {
-	return e_platform.target_ops->ee_mread_buf(mbuf, from_addr, buf, size);
-}
+	unsigned row, col;
 
+	if (ee_read_regs_check("e_read_regs_group()", dev, reg_set, regs) != E_OK)
+		return E_ERR;
 
-static ssize_t ee_mwrite_buf_native(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
-{
-	void *pto;
+	for (row=0; row<dev->rows; row++)
+		for (col=0; col<dev->cols; col++)
+			if (ee_read_regs(dev, row, col, reg_set, &regs[row * dev->cols + col]) != E_OK)
+				return E_ERR;
 
-	if (((to_addr + size) > mbuf->map_size) || (to_addr < 0))
-	{
-		warnx("ee_mwrite_buf(): Address is out of bounds.");
-		return E_ERR;
-	}
+	return E_OK;
+}
 
-	pto = mbuf->base + to_addr;
+// Read register file snapshots of all cores in a group, in row-major order
+int e_read_regs_group(e_epiphany_t *dev, unsigned reg_set, e_core_regs_t *regs)
+{
+	uint64_t t0;
+	int rc;
 
-	if ( E_SHARED_MEM == mbuf->objtype ) {
-		diag(H_D1) {
-		  fprintf(diag_fd, "ee_mwrite_buf(): writing to to_addr=0x%08x, "
-				  "offset=0x%08x, size=%d, map_size=0x%x\n", (uint) pto,
-				  (uint)to_addr, (uint) size, (uint) mbuf->map_size);
-		}
-	}
-	memcpy(pto, buf, size);
+	t0 = ee_stats_begin();
+	rc = ee_read_regs_group(dev, reg_set, regs);
+	ee_stats_end(E_OP_READ_REGS, t0, 0, rc == E_ERR);
 
-	return size;
+	return rc;
 }
 
-// Write a block to an external memory buffer
-ssize_t ee_mwrite_buf(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
+// Look up a register in a snapshot. Returns NULL if it is not part of one.
+unsigned *e_core_reg(e_core_regs_t *regs, off_t reg)
 {
-	return e_platform.target_ops->ee_mwrite_buf(mbuf, to_addr, buf, size);
+	unsigned i;
+	off_t	 offset;
+
+	if (reg & (sizeof(unsigned) - 1))
+		return NULL;
+
+	for (i=0; i<EE_REG_BLOCKS; i++)
+	{
+		offset = reg - ee_reg_blocks[i].first;
+		if ((offset >= 0) && (offset < ee_reg_blocks[i].count * sizeof(unsigned)))
+			return (unsigned *) ((char *) regs + ee_reg_blocks[i].offset) + offset / sizeof(unsigned);
+	}
+
+	return NULL;
 }
 
 
@@ -979,9 +2281,46 @@ int e_reset_system_native(void)
 
 
 // Reset the Epiphany platform
+static unsigned system_resets;
+
 int e_reset_system(void)
 {
-	return e_platform.target_ops->e_reset_system();
+	uint64_t t0;
+	int rc;
+
+	system_resets++;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->e_reset_system();
+	ee_stats_end(E_OP_RESET_SYSTEM, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+// Number of system resets so far. Host side copies of core memory are stale
+// once this changes.
+unsigned ee_system_reset_count()
+{
+	return system_resets;
+}
+
+// SRAM range [*lo, *hi) of a core, by core ID, that this process reset or
+// wrote to since ee_core_dirty_clear(). Register writes don't count. A host
+// side copy of core memory is stale where it overlaps the range.
+void ee_core_dirty_range(unsigned coreid, size_t *lo, size_t *hi)
+{
+	uint64_t v;
+
+	v = __sync_fetch_and_add(&core_dirty[coreid % EE_CORE_DIRTY_IDS], 0);
+	*lo = v >> 32;
+	*hi = v & 0xffffffff;
+	if (*hi < *lo)
+		*hi = *lo;
+}
+
+void ee_core_dirty_clear(unsigned coreid)
+{
+	__sync_lock_test_and_set(&core_dirty[coreid % EE_CORE_DIRTY_IDS], 0);
 }
 
 
@@ -1112,6 +2451,12 @@ uint8_t soft_reset_payload[] = {
  *  3c:              b       1b
  */
 
+// Number of bytes at the start of core SRAM clobbered by ee_soft_reset_core()
+size_t ee_soft_reset_payload_size()
+{
+	return sizeof(soft_reset_payload);
+}
+
 int ee_soft_reset_core(e_epiphany_t *dev, unsigned row, unsigned col)
 {
 	int i;
@@ -1196,6 +2541,8 @@ int ee_reset_group(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows,
 	int CONFIG = 0x01000000;
 	int i, j;
 
+	ee_core_dirty(dev, row, col, rows, cols, 0, dev->core[row][col].mems.map_size);
+
 	diag(H_D1) { fprintf(diag_fd, "ee_reset_group(): halting cores...\n"); }
 	for (i = row; i < row + rows; i++)
 		for (j = col; j < col + cols; j++)
@@ -1249,7 +2596,14 @@ int ee_reset_core(e_epiphany_t *dev, unsigned row, unsigned col)
 // Reset a workgroup
 int e_reset_group(e_epiphany_t *dev)
 {
-	return ee_reset_group(dev, 0, 0, dev->rows, dev->cols);
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_reset_group(dev, 0, 0, dev->rows, dev->cols);
+	ee_stats_end(E_OP_RESET_GROUP, t0, 0, rc == E_ERR);
+
+	return rc;
 }
 
 static bool gdbserver_attached_p()
@@ -1300,14 +2654,28 @@ int _e_default_start_group(e_epiphany_t *dev,
 // Start a program loaded on an e-core in a group
 int e_start(e_epiphany_t *dev, unsigned row, unsigned col)
 {
-	return e_platform.target_ops->start_group(dev, row, col, 1, 1);
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->start_group(dev, row, col, 1, 1);
+	ee_stats_end(E_OP_START, t0, 0, rc == E_ERR);
+
+	return rc;
 }
 
 
 // Start all programs loaded on a workgroup
 int e_start_group(e_epiphany_t *dev)
 {
-	return e_platform.target_ops->start_group(dev, 0, 0, dev->rows, dev->cols);
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = e_platform.target_ops->start_group(dev, 0, 0, dev->rows, dev->cols);
+	ee_stats_end(E_OP_START_GROUP, t0, 0, rc == E_ERR);
+
+	return rc;
 }
 
 
@@ -1315,11 +2683,15 @@ int e_start_group(e_epiphany_t *dev)
 int e_signal(e_epiphany_t *dev, unsigned row, unsigned col)
 {
 	int SWI = (1 << E_USER_INT);
+	uint64_t t0;
 
+	t0 = ee_stats_begin();
 	diag(H_D1) { fprintf(diag_fd, "e_signal(): SWI (0x%x) to core (%d,%d)...\n", E_REG_ILATST, row, col); }
 	ee_write_reg(dev, row, col, E_REG_ILATST, SWI);
 	diag(H_D1) { fprintf(diag_fd, "e_signal(): done.\n"); }
 
+	ee_stats_end(E_OP_SIGNAL, t0, 0, false);
+
 	return E_OK;
 }
 
@@ -1327,10 +2699,13 @@ int e_signal(e_epiphany_t *dev, unsigned row, unsigned col)
 // Halt a core
 int e_halt(e_epiphany_t *dev, unsigned row, unsigned col)
 {
+	uint64_t t0;
 	int cmd;
 
+	t0 = ee_stats_begin();
 	cmd = 0x1;
 	e_write(dev, row, col, E_REG_DEBUGCMD, &cmd, sizeof(int));
+	ee_stats_end(E_OP_HALT, t0, 0, false);
 
 	return E_OK;
 }
@@ -1346,15 +2721,230 @@ static int e_halt_group(e_epiphany_t *dev, unsigned row, unsigned col,
 // Resume a core after halt
 int e_resume(e_epiphany_t *dev, unsigned row, unsigned col)
 {
+	uint64_t t0;
 	int cmd;
 
+	t0 = ee_stats_begin();
 	cmd = 0x0;
 	e_write(dev, row, col, E_REG_DEBUGCMD, &cmd, sizeof(int));
+	ee_stats_end(E_OP_RESUME, t0, 0, false);
 
 	return E_OK;
 }
 
 
+// Completion waits
+//
+// All cores still pending are polled in one e_read_v() sweep. Sweeps run
+// back to back for a while, then yield the CPU between them and finally
+// sleep with exponential backoff, so short jobs are seen within
+// microseconds while long ones do not burn a host core.
+
+#define EE_WAIT_SPIN_SWEEPS	 64
+#define EE_WAIT_YIELD_SWEEPS 256
+#define EE_WAIT_MIN_SLEEP_NS 1000
+#define EE_WAIT_MAX_SLEEP_NS 1000000
+
+// Waits from several threads fold their counts in under ee_wait_stats_lock
+static e_wait_stats_t  ee_wait_stats;
+static pthread_mutex_t ee_wait_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t ee_wait_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Wait for cores [row, row+rows) x [col, col+cols) of a group
+static int ee_wait_cores(e_epiphany_t *dev, unsigned row, unsigned col,
+						 unsigned rows, unsigned cols, off_t flag_addr,
+						 unsigned expected, long timeout_us, unsigned flags,
+						 e_bool_t *done)
+{
+	unsigned	 ncores = rows * cols, npending, nregs, i, r, c, k;
+	e_iovec_t	*iov;
+	unsigned	*pending;
+	uint32_t	*vals;
+	uint64_t	 start, now, last, deadline, slack;
+	uint64_t	 completions = 0, slack_ns = 0, max_slack_ns = 0;
+	unsigned long sweeps = 0;
+	long		 sleep_ns = EE_WAIT_MIN_SLEEP_NS;
+	struct timespec nap;
+	int			 rc = E_OK;
+
+	if (!dev || !ncores || row + rows > dev->rows || col + cols > dev->cols) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	nregs = (flags & E_WAIT_IDLE) ? 2 : 1;
+	iov = malloc(ncores * nregs * sizeof(*iov));
+	vals = malloc(ncores * nregs * sizeof(*vals));
+	pending = malloc(ncores * sizeof(*pending));
+	if (!iov || !vals || !pending) {
+		rc = E_ERR;
+		goto out;
+	}
+
+	npending = 0;
+	for (r = row; r < row + rows; r++)
+		for (c = col; c < col + cols; c++)
+			pending[npending++] = e_get_num_from_coords(dev, r, c);
+
+	if (done)
+		for (i = 0; i < dev->num_cores; i++)
+			done[i] = E_FALSE;
+
+	start = last = ee_wait_now_ns();
+	deadline = (timeout_us < 0) ? UINT64_MAX : start + timeout_us * 1000ULL;
+
+	for (;;) {
+		// One sweep over the flags, and STATUS if asked, of pending cores
+		for (i = 0, k = 0; i < npending; i++) {
+			e_get_coords_from_num(dev, pending[i], &r, &c);
+			iov[k].dev = dev; iov[k].row = r; iov[k].col = c;
+			iov[k].addr = flag_addr; iov[k].buf = &vals[k]; iov[k].size = 4;
+			k++;
+			if (nregs == 2) {
+				iov[k].dev = dev; iov[k].row = r; iov[k].col = c;
+				iov[k].addr = E_REG_STATUS; iov[k].buf = &vals[k]; iov[k].size = 4;
+				k++;
+			}
+		}
+		if (e_read_v(iov, k) == E_ERR) {
+			rc = E_ERR;
+			goto out;
+		}
+		now = ee_wait_now_ns();
+		sweeps++;
+
+		// Drop completed cores from the pending list
+		for (i = 0, k = 0; i < npending; i++) {
+			uint32_t *v = &vals[i * nregs];
+
+			if (v[0] == expected || (nregs == 2 && !(v[1] & 1))) {
+				if (done)
+					done[pending[i]] = E_TRUE;
+				continue;
+			}
+			pending[k++] = pending[i];
+		}
+
+		// A core completed somewhere between the previous sweep and this one
+		if (k < npending) {
+			slack = now - last;
+			completions += npending - k;
+			slack_ns += slack * (npending - k);
+			if (slack > max_slack_ns)
+				max_slack_ns = slack;
+		}
+		npending = k;
+		last = now;
+
+		if (!npending)
+			break;
+
+		if (now >= deadline) {
+			errno = ETIMEDOUT;
+			rc = E_ERR;
+			break;
+		}
+
+		if (sweeps < EE_WAIT_SPIN_SWEEPS)
+			continue;
+
+		if (sweeps < EE_WAIT_YIELD_SWEEPS) {
+			sched_yield();
+			continue;
+		}
+
+		if (sleep_ns > deadline - now)
+			sleep_ns = deadline - now;
+		nap.tv_sec = sleep_ns / 1000000000L;
+		nap.tv_nsec = sleep_ns % 1000000000L;
+		nanosleep(&nap, NULL);
+		if (sleep_ns < EE_WAIT_MAX_SLEEP_NS)
+			sleep_ns *= 2;
+	}
+
+	pthread_mutex_lock(&ee_wait_stats_lock);
+	ee_wait_stats.waits++;
+	if (rc == E_ERR)
+		ee_wait_stats.timeouts++;
+	ee_wait_stats.sweeps += sweeps;
+	ee_wait_stats.completions += completions;
+	ee_wait_stats.slack_ns += slack_ns;
+	if (max_slack_ns > ee_wait_stats.max_slack_ns)
+		ee_wait_stats.max_slack_ns = max_slack_ns;
+	ee_wait_stats.last_wait_ns = last - start;
+	ee_wait_stats.wait_ns += last - start;
+	pthread_mutex_unlock(&ee_wait_stats_lock);
+
+	diag(H_D2) { fprintf(diag_fd, "ee_wait_cores(): %u cores, %u pending after "
+						 "%lu sweeps in %llu ns\n", ncores, npending, sweeps,
+						 (unsigned long long) (last - start)); }
+
+ out:
+	free(iov);
+	free(vals);
+	free(pending);
+
+	return rc;
+}
+
+static int ee_wait_group(e_epiphany_t *dev, off_t flag_addr, unsigned expected,
+						 long timeout_us, unsigned flags, e_bool_t *done)
+{
+	if (!dev) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	return ee_wait_cores(dev, 0, 0, dev->rows, dev->cols, flag_addr,
+						 expected, timeout_us, flags, done);
+}
+
+// Wait for every core of a group to write expected to flag_addr
+int e_wait_group(e_epiphany_t *dev, off_t flag_addr, unsigned expected,
+				 long timeout_us, unsigned flags, e_bool_t *done)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_wait_group(dev, flag_addr, expected, timeout_us, flags, done);
+	ee_stats_end(E_OP_WAIT, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+// Wait for one core of a group to write expected to flag_addr
+int e_wait_core(e_epiphany_t *dev, unsigned row, unsigned col,
+				off_t flag_addr, unsigned expected, long timeout_us,
+				unsigned flags)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_wait_cores(dev, row, col, 1, 1, flag_addr, expected,
+					   timeout_us, flags, NULL);
+	ee_stats_end(E_OP_WAIT, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+// Get the completion wait statistics of this process
+void e_get_wait_stats(e_wait_stats_t *stats)
+{
+	pthread_mutex_lock(&ee_wait_stats_lock);
+	*stats = ee_wait_stats;
+	pthread_mutex_unlock(&ee_wait_stats_lock);
+}
+
+
 ////////////////////
 // Utility functions
 
@@ -1505,6 +3095,9 @@ int ee_parse_hdf(e_platform_t *dev, char *hdf)
 	int	  ret = E_ERR;
 	char *ext;
 
+	if (ee_hdf_cache_load(dev, hdf) == E_OK)
+		return E_OK;
+
 	if (strlen(hdf) >= 4)
 	{
 		ext = hdf + strlen(hdf) - 4;
@@ -1518,6 +3111,9 @@ int ee_parse_hdf(e_platform_t *dev, char *hdf)
 		ret = E_ERR;
 	}
 
+	if (ret == E_OK)
+		ee_hdf_cache_store(dev, hdf);
+
 	return ret;
 }
 
@@ -1808,7 +3404,8 @@ bool ee_native_target_p()
 	static bool native = false;
 
 	if (!initialized)
-		native = (!ee_esim_target_p() && !ee_pal_target_p());
+		native = (!ee_esim_target_p() && !ee_pal_target_p() &&
+				  !ee_mem_target_p());
 
 	return native;
 }
@@ -1844,8 +3441,23 @@ bool ee_pal_target_p()
 	return pal;
 }
 
+bool ee_mem_target_p()
+{
+	static bool initialized = false;
+	static bool mem = false;
+	const char *p;
+
+	if (!initialized) {
+		p = getenv(EHAL_TARGET_ENV);
+		mem = (p && strncmp(p, "mem", sizeof("mem")) == 0);
+		initialized = true;
+	}
+
+	return mem;
+}
+
 
-static int populate_platform_native(e_platform_t *platform, char *hdf)
+int _e_default_populate_platform(e_platform_t *platform, char *hdf)
 {
 	char *hdf_env, *esdk_env, hdf_dfl[1024];
 	int i;
@@ -1875,6 +3487,8 @@ static int populate_platform_native(e_platform_t *platform, char *hdf)
 		warnx("e_init(): Error parsing Hardware Definition File (HDF).");
 		return E_ERR;
 	}
+
+	return E_OK;
 }
 
 static int init_native()
@@ -1905,12 +3519,15 @@ const struct e_target_ops native_target_ops = {
 	.ee_mread_buf = ee_mread_buf_native,
 	.ee_mwrite_buf = ee_mwrite_buf_native,
 	.e_reset_system = e_reset_system_native,
-	.populate_platform = populate_platform_native,
+	.populate_platform = _e_default_populate_platform,
 	.init = init_native,
 	.finalize = finalize_native,
 	.open = ee_open_native,
 	.load_group = _e_default_load_group,
 	.start_group = _e_default_start_group,
+	.ee_read_v = _e_default_read_v,
+	.ee_write_v = _e_default_write_v,
+	.ee_read_regs = _e_default_read_regs,
 };
 
 #pragma GCC diagnostic pop
@@ -0,0 +1,399 @@
+/*
+  File: epiphany-hdf-cache.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.	 If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Compiled platform description cache.
+ *
+ * A successfully parsed HDF is stored as a binary image of the platform
+ * version string and the chip and external memory arrays, so the next
+ * e_init() only has to read the image, check it and copy the arrays out.
+ *
+ * An image is only used if its format version and record sizes match this
+ * library, its payload checksum is right, and the device, inode, size and
+ * modification time of the HDF it was made from are unchanged. Anything
+ * else is a miss and the HDF is parsed and the image written again.
+ *
+ * Images are looked for in this order:
+ *
+ *   $EHAL_HDF_CACHE/hdf-<dev>-<ino>.cache   if EHAL_HDF_CACHE is a directory
+ *   $XDG_CACHE_HOME/epiphany/hdf-<dev>-<ino>.cache, or ~/.cache/epiphany/...
+ *   <hdf>.cache                             next to the HDF
+ *
+ * where <dev> and <ino> identify the HDF file. New images are only written
+ * to the first two, never next to the HDF, which usually lives in the
+ * installed or checked out BSP tree; an image there has to be put in place
+ * by hand. Setting EHAL_HDF_CACHE to 0 disables the cache.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "epiphany-hal.h"
+#include "epiphany-hal-api-local.h"
+
+#define diag(vN) if (e_host_verbose >= vN)
+
+extern int	 e_host_verbose;
+extern FILE *diag_fd;
+
+#define EE_HDF_CACHE_MAGIC	 0x43464448 // "HDFC"
+#define EE_HDF_CACHE_VERSION 1
+#define EE_HDF_CACHE_PATHS	 3
+#define EE_HDF_CACHE_MAX	 65536
+
+struct ee_hdf_cache_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chip_size;		// sizeof(e_chip_t)
+	uint32_t emem_size;		// sizeof(e_memseg_t)
+	uint64_t src_dev;		// Identity of the HDF the image was made from
+	uint64_t src_ino;
+	uint64_t src_size;
+	int64_t	 src_mtime_sec;
+	int64_t	 src_mtime_nsec;
+	uint32_t num_chips;
+	uint32_t num_emems;
+	char	 platform_version[32];
+	uint64_t checksum;		// FNV-1a of the fields above from num_chips on
+							// and of the chip and emem records
+};
+
+static uint64_t ee_fnv1a(uint64_t h, const void *buf, size_t size)
+{
+	const uint8_t *p = buf;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+#define EE_FNV_INIT 0xcbf29ce484222325ULL
+
+static bool hdf_cache_p()
+{
+	const char *p;
+
+	p = getenv("EHAL_HDF_CACHE");
+
+	return !(p && !strcmp(p, "0"));
+}
+
+// Build the candidate image paths for an HDF. Returns their number. Paths
+// next to the HDF are only included for reading.
+static int ee_hdf_cache_paths(const char *hdf,
+							  const struct ee_hdf_cache_hdr *ident,
+							  char paths[EE_HDF_CACHE_PATHS][PATH_MAX],
+							  bool store)
+{
+	const char *env, *home;
+	char name[64];
+	int n = 0;
+
+	snprintf(name, sizeof(name), "hdf-%llx-%llx.cache",
+			 (unsigned long long) ident->src_dev,
+			 (unsigned long long) ident->src_ino);
+
+	env = getenv("EHAL_HDF_CACHE");
+	if (env && env[0] != '\0')
+		if (snprintf(paths[n], PATH_MAX, "%s/%s", env, name) < PATH_MAX)
+			n++;
+
+	env = getenv("XDG_CACHE_HOME");
+	home = getenv("HOME");
+	if (env && env[0] != '\0') {
+		if (snprintf(paths[n], PATH_MAX, "%s/epiphany/%s", env, name) < PATH_MAX)
+			n++;
+	} else if (home && home[0] != '\0') {
+		if (snprintf(paths[n], PATH_MAX, "%s/.cache/epiphany/%s", home, name) < PATH_MAX)
+			n++;
+	}
+
+	if (!store)
+		if (snprintf(paths[n], PATH_MAX, "%s.cache", hdf) < PATH_MAX)
+			n++;
+
+	return n;
+}
+
+static uint64_t ee_hdf_cache_checksum(const struct ee_hdf_cache_hdr *hdr)
+{
+	uint64_t h;
+
+	h = ee_fnv1a(EE_FNV_INIT, &hdr->num_chips,
+				 offsetof(struct ee_hdf_cache_hdr, checksum) -
+				 offsetof(struct ee_hdf_cache_hdr, num_chips));
+
+	return ee_fnv1a(h, hdr + 1,
+					hdr->num_chips * hdr->chip_size +
+					hdr->num_emems * hdr->emem_size);
+}
+
+// Fill in the fields identifying the source HDF
+static int ee_hdf_cache_ident(const char *hdf, struct ee_hdf_cache_hdr *hdr)
+{
+	struct stat st;
+
+	if (stat(hdf, &st))
+		return E_ERR;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic			= EE_HDF_CACHE_MAGIC;
+	hdr->version		= EE_HDF_CACHE_VERSION;
+	hdr->chip_size		= sizeof(e_chip_t);
+	hdr->emem_size		= sizeof(e_memseg_t);
+	hdr->src_dev		= st.st_dev;
+	hdr->src_ino		= st.st_ino;
+	hdr->src_size		= st.st_size;
+	hdr->src_mtime_sec	= st.st_mtim.tv_sec;
+	hdr->src_mtime_nsec = st.st_mtim.tv_nsec;
+
+	return E_OK;
+}
+
+// Check an image against the source HDF. Returns the image size or 0.
+static size_t ee_hdf_cache_valid(const struct ee_hdf_cache_hdr *hdr,
+								 size_t size,
+								 const struct ee_hdf_cache_hdr *ident)
+{
+	size_t need;
+
+	if (size < sizeof(*hdr))
+		return 0;
+
+	/* Everything up to the platform version identifies the source */
+	if (memcmp(hdr, ident, offsetof(struct ee_hdf_cache_hdr, num_chips)))
+		return 0;
+
+	need = sizeof(*hdr) + (size_t) hdr->num_chips * hdr->chip_size +
+		(size_t) hdr->num_emems * hdr->emem_size;
+	if (size != need)
+		return 0;
+
+	if (memchr(hdr->platform_version, '\0',
+			   sizeof(hdr->platform_version)) == NULL)
+		return 0;
+
+	if (ee_hdf_cache_checksum(hdr) != hdr->checksum)
+		return 0;
+
+	return need;
+}
+
+static int ee_hdf_cache_load_one(e_platform_t *dev, const char *path,
+								 const struct ee_hdf_cache_hdr *ident)
+{
+	const struct ee_hdf_cache_hdr *hdr;
+	e_chip_t   *chip = NULL;
+	e_memseg_t *emem = NULL;
+	char	   *buf;
+	ssize_t		size;
+	int fd, ret = E_ERR;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return E_ERR;
+
+	/* Images are small, so one read of a bounded buffer is cheaper than
+	 * fstat() and a mapping. A short read means the whole image is in. */
+	buf = malloc(EE_HDF_CACHE_MAX);
+	if (!buf) {
+		close(fd);
+		return E_ERR;
+	}
+
+	size = read(fd, buf, EE_HDF_CACHE_MAX);
+	close(fd);
+
+	hdr = (struct ee_hdf_cache_hdr *) buf;
+	if (size <= 0 || size == EE_HDF_CACHE_MAX ||
+		!ee_hdf_cache_valid(hdr, size, ident))
+		goto out;
+
+	chip = calloc(hdr->num_chips, sizeof(*chip));
+	emem = calloc(hdr->num_emems, sizeof(*emem));
+	if ((hdr->num_chips && !chip) || (hdr->num_emems && !emem)) {
+		free(chip);
+		free(emem);
+		goto out;
+	}
+
+	memcpy(chip, hdr + 1, hdr->num_chips * sizeof(*chip));
+	memcpy(emem, (char *) (hdr + 1) + hdr->num_chips * sizeof(*chip),
+		   hdr->num_emems * sizeof(*emem));
+
+	strcpy(dev->version, hdr->platform_version);
+	dev->num_chips = hdr->num_chips;
+	dev->chip	   = chip;
+	dev->num_emems = hdr->num_emems;
+	dev->emem	   = emem;
+
+	ret = E_OK;
+
+out:
+	free(buf);
+
+	return ret;
+}
+
+// Fill in the platform from a cached image of hdf. Returns E_ERR on a miss.
+int ee_hdf_cache_load(e_platform_t *dev, const char *hdf)
+{
+	char paths[EE_HDF_CACHE_PATHS][PATH_MAX];
+	struct ee_hdf_cache_hdr ident;
+	int i, n;
+
+	if (!hdf_cache_p())
+		return E_ERR;
+
+	if (ee_hdf_cache_ident(hdf, &ident) != E_OK)
+		return E_ERR;
+
+	n = ee_hdf_cache_paths(hdf, &ident, paths, false);
+	for (i = 0; i < n; i++) {
+		if (ee_hdf_cache_load_one(dev, paths[i], &ident) == E_OK) {
+			diag(H_D2) { fprintf(diag_fd, "ee_hdf_cache_load(): using %s\n", paths[i]); }
+			return E_OK;
+		}
+	}
+
+	diag(H_D2) { fprintf(diag_fd, "ee_hdf_cache_load(): no valid image for %s\n", hdf); }
+
+	return E_ERR;
+}
+
+// Create the missing parent directories of a cache image
+static void ee_hdf_cache_mkdir(const char *path)
+{
+	char dir[PATH_MAX], *p;
+
+	strcpy(dir, path);
+	for (p = strchr(dir + 1, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		mkdir(dir, 0755);
+		*p = '/';
+	}
+}
+
+static int ee_hdf_cache_store_one(const char *path, const void *buf,
+								  size_t size)
+{
+	char tmp[PATH_MAX + 8];
+	size_t len;
+	int fd;
+
+	/* paths[] entries are shorter than PATH_MAX, so the suffix fits */
+	len = strlen(path);
+	if (len >= PATH_MAX)
+		return E_ERR;
+	memcpy(tmp, path, len);
+	strcpy(tmp + len, ".XXXXXX");
+
+	fd = mkstemp(tmp);
+	if (fd == -1 && errno == ENOENT) {
+		ee_hdf_cache_mkdir(path);
+		/* mkstemp() leaves the template clobbered on failure */
+		strcpy(tmp + len, ".XXXXXX");
+		fd = mkstemp(tmp);
+	}
+	if (fd == -1)
+		return E_ERR;
+
+	/* Write a new image and rename it over the old one, so readers in
+	 * other processes never see a partial image */
+	if (fchmod(fd, 0644) || write(fd, buf, size) != (ssize_t) size) {
+		close(fd);
+		unlink(tmp);
+		return E_ERR;
+	}
+
+	if (close(fd) || rename(tmp, path)) {
+		unlink(tmp);
+		return E_ERR;
+	}
+
+	return E_OK;
+}
+
+// Write a cached image of a platform freshly parsed from hdf
+int ee_hdf_cache_store(e_platform_t *dev, const char *hdf)
+{
+	char paths[EE_HDF_CACHE_PATHS][PATH_MAX];
+	struct ee_hdf_cache_hdr *hdr;
+	size_t chips, emems;
+	int i, n, ret = E_ERR;
+
+	if (!hdf_cache_p() || dev->num_chips < 0 || dev->num_emems < 0)
+		return E_ERR;
+
+	chips = dev->num_chips * sizeof(e_chip_t);
+	emems = dev->num_emems * sizeof(e_memseg_t);
+	if (sizeof(*hdr) + chips + emems >= EE_HDF_CACHE_MAX)
+		return E_ERR;
+
+	hdr = calloc(1, sizeof(*hdr) + chips + emems);
+	if (!hdr)
+		return E_ERR;
+
+	if (ee_hdf_cache_ident(hdf, hdr) != E_OK)
+		goto out;
+
+	hdr->num_chips = dev->num_chips;
+	hdr->num_emems = dev->num_emems;
+	snprintf(hdr->platform_version, sizeof(hdr->platform_version), "%s",
+			 dev->version);
+	if (chips)
+		memcpy(hdr + 1, dev->chip, chips);
+	if (emems)
+		memcpy((char *) (hdr + 1) + chips, dev->emem, emems);
+	hdr->checksum = ee_hdf_cache_checksum(hdr);
+
+	n = ee_hdf_cache_paths(hdf, hdr, paths, true);
+	for (i = 0; i < n; i++) {
+		if (ee_hdf_cache_store_one(paths[i], hdr, sizeof(*hdr) + chips + emems) == E_OK) {
+			diag(H_D2) { fprintf(diag_fd, "ee_hdf_cache_store(): wrote %s\n", paths[i]); }
+			ret = E_OK;
+			break;
+		}
+	}
+
+out:
+	free(hdr);
+
+	return ret;
+}
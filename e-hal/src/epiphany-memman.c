@@ -24,127 +24,423 @@
 */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
 
-/** Zero if mem manager is uninitialized, non-zero otherwise */ 
-static int is_initialized = 0;
+#include "memman.h"
 
-/** The first valid address of managed memory */
-static void *mem_start = 0;
+/*
+ * Segregated fit allocator with boundary tags.
+ *
+ * Every block starts and ends with a tag holding its size and an in-use
+ * bit, so both neighbours of a freed block can be found and merged in
+ * constant time. Free blocks are kept on one doubly linked list per power
+ * of two size class, with a bitmap of non-empty classes. An allocation
+ * takes the first block from the smallest class whose blocks are all big
+ * enough, and only searches a list when that class is the last resort.
+ *
+ * All links are offsets from the heap header, which lives at the start of
+ * the managed memory, so the heap can be used from processes that map it
+ * at different addresses.
+ */
+
+#define MEMMAN_MAGIC	0x6d656d32	/* "mem2" */
+#define MEMMAN_CLASSES	48
+#define MEMMAN_INUSE	1ULL
+
+/** Boundary tag: block size in bytes, or'ed with MEMMAN_INUSE */
+typedef uint64_t mem_tag_t;
+
+/** Free block layout. next and prev are heap offsets, 0 for none */
+typedef struct mem_free_blk
+{
+	mem_tag_t head;
+	uint64_t  next;
+	uint64_t  prev;
+} mem_free_blk_t;
 
-/** The last valid address of managed memory */
-static void *mem_end = 0;
+#define MEMMAN_TAGS			(2 * sizeof(mem_tag_t))
+#define MEMMAN_MIN_BLOCK	(sizeof(mem_free_blk_t) + sizeof(mem_tag_t))
+
+/** Heap header, at the start of the managed memory */
+typedef struct mem_heap
+{
+	uint32_t       magic;
+	uint32_t       classes;
+	uint64_t       size;		/* Size passed to memman_init() */
+	uint64_t       first;		/* Offset of the first block */
+	uint64_t       end;			/* Offset just past the last block */
+	uint64_t       nonempty;	/* Bit per class with free blocks */
+	uint64_t       free_list[MEMMAN_CLASSES];
+	memman_stats_t stats;
+} mem_heap_t;
+
+/** The heap, or NULL if memman_init() has not been called */
+static mem_heap_t *heap = NULL;
+
+#define ROUND_UP(x, a)	(((x) + (a) - 1) & ~((uint64_t) (a) - 1))
+
+static inline mem_tag_t *tag_at(uint64_t off)
+{
+	return (mem_tag_t *) ((char *) heap + off);
+}
+
+static inline uint64_t blk_size(uint64_t off)
+{
+	return *tag_at(off) & ~MEMMAN_INUSE;
+}
+
+static inline int blk_inuse(uint64_t off)
+{
+	return *tag_at(off) & MEMMAN_INUSE;
+}
+
+static inline mem_free_blk_t *free_blk(uint64_t off)
+{
+	return (mem_free_blk_t *) tag_at(off);
+}
+
+static void blk_set(uint64_t off, uint64_t size, int inuse)
+{
+	mem_tag_t tag = size | (inuse ? MEMMAN_INUSE : 0);
+
+	*tag_at(off) = tag;
+	*tag_at(off + size - sizeof(mem_tag_t)) = tag;
+}
+
+/** Size class holding blocks of size [2^(c+5), 2^(c+6)) */
+static unsigned size_class(uint64_t size)
+{
+	unsigned log2 = 63 - __builtin_clzll(size);
+	unsigned c = (log2 < 5) ? 0 : log2 - 5;
+
+	return (c < MEMMAN_CLASSES) ? c : MEMMAN_CLASSES - 1;
+}
+
+static void list_insert(uint64_t off)
+{
+	unsigned c = size_class(blk_size(off));
+	mem_free_blk_t *blk = free_blk(off);
+
+	blk->prev = 0;
+	blk->next = heap->free_list[c];
+	if (blk->next)
+		free_blk(blk->next)->prev = off;
+	heap->free_list[c] = off;
+	heap->nonempty |= 1ULL << c;
+	heap->stats.free_blocks++;
+}
+
+static void list_remove(uint64_t off)
+{
+	unsigned c = size_class(blk_size(off));
+	mem_free_blk_t *blk = free_blk(off);
+
+	if (blk->prev)
+		free_blk(blk->prev)->next = blk->next;
+	else
+		heap->free_list[c] = blk->next;
+	if (blk->next)
+		free_blk(blk->next)->prev = blk->prev;
+	if (!heap->free_list[c])
+		heap->nonempty &= ~(1ULL << c);
+	heap->stats.free_blocks--;
+}
 
 /**
- * The mem_control_block holds metadata for
- * each allocated chunk of memory
+ * Find a free block of at least size bytes and take it off its list.
+ * Returns its offset or 0 if there is none.
  */
-typedef struct mem_control_block
+static uint64_t find_fit(uint64_t size)
+{
+	unsigned c = size_class(size);
+	uint64_t above, off;
+
+	/* Every block in a higher class is big enough */
+	above = (c + 1 < MEMMAN_CLASSES) ? heap->nonempty & ~((2ULL << c) - 1) : 0;
+	if (above) {
+		off = heap->free_list[__builtin_ctzll(above)];
+		list_remove(off);
+		return off;
+	}
+
+	/* Only blocks in our own class can still fit */
+	for (off = heap->free_list[c]; off; off = free_blk(off)->next) {
+		if (blk_size(off) >= size) {
+			list_remove(off);
+			return off;
+		}
+	}
+
+	return 0;
+}
+
+/** Split size bytes off the front of a block, freeing the rest if worthwhile */
+static uint64_t blk_trim(uint64_t off, uint64_t size)
 {
-	unsigned int is_inuse;
-	unsigned int size;
-} mem_ctl_blk_t;
+	uint64_t total = blk_size(off);
 
-/** Coalesce adjacent memory blocks. Note this does forward
- * coalescing only  */
-static void coalesce(mem_ctl_blk_t *mcb);
+	if (total - size >= MEMMAN_MIN_BLOCK) {
+		blk_set(off + size, total - size, 0);
+		list_insert(off + size);
+		return size;
+	}
+
+	return total;
+}
 
-int memman_init(void *start, size_t size)
+int memman_init(void *start, size_t size, int format)
 {
+	uintptr_t base, first;
+
 	if ( (start == NULL) || (size == 0) ) {
 		return -1;
 	}
-	
-	mem_start = start;
-	mem_end = (void*)(((char*)start) + size);
 
-	memset(start, 0, size);
+	/* Blocks must be aligned to the granule */
+	base = ROUND_UP((uintptr_t) start, MEMMAN_GRAIN);
+	if (size < (base - (uintptr_t) start) + sizeof(mem_heap_t) + MEMMAN_MIN_BLOCK)
+		return -1;
+	size -= base - (uintptr_t) start;
+
+	heap = (mem_heap_t *) base;
+
+	if (!format && heap->magic == MEMMAN_MAGIC && heap->size == size &&
+		heap->classes == MEMMAN_CLASSES) {
+		return 0;
+	}
+
+	/* Payloads follow an 8 byte tag, so start blocks on an odd word */
+	first = ROUND_UP(sizeof(mem_heap_t) + sizeof(mem_tag_t), MEMMAN_GRAIN)
+		- sizeof(mem_tag_t);
 
-	is_initialized = 1;
+	memset(heap, 0, sizeof(*heap));
+	heap->classes = MEMMAN_CLASSES;
+	heap->size = size;
+	heap->first = first;
+	heap->end = first + ((size - first) & ~((uint64_t) MEMMAN_GRAIN - 1));
+	heap->stats.size = heap->end - heap->first;
+	heap->stats.free = heap->stats.size;
+
+	blk_set(heap->first, heap->stats.size, 0);
+	list_insert(heap->first);
+
+	heap->magic = MEMMAN_MAGIC;
 
 	return 0;
 }
 
 void *memman_alloc(size_t size)
 {
-	void          *current_location      = 0;
-	mem_ctl_blk_t *current_location_mcb  = 0;
-	void          *mem_location          = 0;
-
-	/* Account for the size of the memory control block */
-	size += sizeof(mem_ctl_blk_t);
+	return memman_alloc_aligned(size, MEMMAN_GRAIN);
+}
 
-	current_location = mem_start;
+void *memman_alloc_aligned(size_t size, size_t align)
+{
+	uint64_t need, search, off, gap;
 
-	if ( !is_initialized ) {
+	if ( !heap ) {
 		/* Ooops, foget to call memman_init() ? */
 		return NULL;
 	}
 
-	while ( current_location < mem_end ) {
-		current_location_mcb = (mem_ctl_blk_t*)current_location;
-
-		if ( !current_location_mcb->is_inuse ) {
-			if ( (current_location_mcb->size == 0) ||
-				 current_location_mcb->size >= size ) {
-				/* Found a free location */
+	if (size == 0 || (align & (align - 1)))
+		return NULL;
+	if (align < MEMMAN_GRAIN)
+		align = MEMMAN_GRAIN;
+
+	/* Account for the boundary tags */
+	need = ROUND_UP((uint64_t) size, MEMMAN_GRAIN) + MEMMAN_TAGS;
+	if (need < MEMMAN_MIN_BLOCK)
+		need = MEMMAN_MIN_BLOCK;
+
+	/* Leave room to move the payload up to the alignment, with the skipped
+	 * space big enough to be a free block of its own */
+	search = need;
+	if (align > MEMMAN_GRAIN)
+		search += align + MEMMAN_MIN_BLOCK;
+
+	off = find_fit(search);
+	if (!off) {
+		heap->stats.failed++;
+		return NULL;
+	}
 
-				current_location_mcb->is_inuse = 1;
-				current_location_mcb->size = size;
-				mem_location = current_location;
-		
-				break;
-			}
-		}
+	gap = 0;
+	if (align > MEMMAN_GRAIN) {
+		uintptr_t payload = (uintptr_t) heap + off + sizeof(mem_tag_t);
 
-		/* Advance to the next chunk location */
-		current_location = current_location + current_location_mcb->size;
+		gap = ROUND_UP(payload, align) - payload;
+		if (gap && gap < MEMMAN_MIN_BLOCK)
+			gap += ROUND_UP(MEMMAN_MIN_BLOCK - gap, align);
 	}
-	
-	if ( mem_location ) {
-		/* Advance the location past the memory control block */
-		mem_location = ((char*)mem_location) + sizeof(mem_ctl_blk_t);
+
+	if (gap) {
+		uint64_t total = blk_size(off);
+
+		blk_set(off, gap, 0);
+		list_insert(off);
+		off += gap;
+		blk_set(off, total - gap, 0);
 	}
 
-	return mem_location;
+	need = blk_trim(off, need);
+	blk_set(off, need, 1);
+
+	heap->stats.used += need;
+	heap->stats.free -= need;
+	heap->stats.allocs++;
+	if (heap->stats.used > heap->stats.high_water)
+		heap->stats.high_water = heap->stats.used;
+
+	return tag_at(off + sizeof(mem_tag_t));
 }
 
+void memman_free(void *ptr)
+{
+	uint64_t off, size, next;
+
+	if (!heap || !ptr)
+		return;
+
+	/* Back up from the given pointer to find the block tag, and ignore
+	 * anything that does not look like one of our allocated blocks */
+	off = (char *) ptr - (char *) heap - sizeof(mem_tag_t);
+	if (off < heap->first || off >= heap->end || !blk_inuse(off))
+		return;
+	size = blk_size(off);
+	if (off + size > heap->end ||
+		*tag_at(off + size - sizeof(mem_tag_t)) != *tag_at(off))
+		return;
+
+	heap->stats.used -= size;
+	heap->stats.free += size;
+	heap->stats.frees++;
+
+	/* Clear the in-use bit first so that a stale pointer into a merged
+	 * block is not taken for a live one later */
+	blk_set(off, size, 0);
+
+	/* Coalesce with the following block */
+	next = off + size;
+	if (next < heap->end && !blk_inuse(next)) {
+		list_remove(next);
+		size += blk_size(next);
+	}
+
+	/* Coalesce with the preceding block */
+	if (off > heap->first) {
+		mem_tag_t prev_tag = *tag_at(off - sizeof(mem_tag_t));
+
+		if (!(prev_tag & MEMMAN_INUSE)) {
+			off -= prev_tag;
+			list_remove(off);
+			size += prev_tag;
+		}
+	}
+
+	blk_set(off, size, 0);
+	list_insert(off);
+
+	return;
+}
 
 /**
- * Coalesce adjacent memory blocks. Note this does forward
- * coalescing only
+ * Make [from, to) a free block while rebuilding. A gap too small for one
+ * goes to the allocated block at prev instead, if there is one.
  */
-static void coalesce(mem_ctl_blk_t *mcb)
+static int rebuild_gap(uint64_t prev, uint64_t from, uint64_t to)
 {
-	mem_ctl_blk_t *pmcb = mcb;
-	unsigned int   free_space = 0;
+	if (from == to)
+		return 0;
+
+	if (to - from >= MEMMAN_MIN_BLOCK) {
+		blk_set(from, to - from, 0);
+		list_insert(from);
+		return 0;
+	}
+
+	if (!prev)
+		return -1;
 
-	assert(pmcb);
+	heap->stats.used += to - from;
+	blk_set(prev, to - prev, 1);
+	return 0;
+}
 
-	while ( !pmcb->is_inuse && (pmcb->size != 0) ) {
-		free_space += pmcb->size;
+size_t memman_rebuild(void **ptrs, const size_t *sizes, size_t n)
+{
+	uint64_t off, size, end, prev = 0;
+	size_t i, kept = 0;
+
+	if (!heap)
+		return 0;
+
+	memset(heap->free_list, 0, sizeof(heap->free_list));
+	heap->nonempty = 0;
+	heap->stats.used = 0;
+	heap->stats.free_blocks = 0;
+
+	end = heap->first;
+	for (i = 0; i < n; i++) {
+		if (!ptrs[i])
+			continue;
+
+		off = (char *) ptrs[i] - (char *) heap - sizeof(mem_tag_t);
+		size = ROUND_UP((uint64_t) sizes[i], MEMMAN_GRAIN) + MEMMAN_TAGS;
+		if (size < MEMMAN_MIN_BLOCK)
+			size = MEMMAN_MIN_BLOCK;
+
+		if ((char *) ptrs[i] < (char *) heap + end + sizeof(mem_tag_t) ||
+			off > heap->end || size > heap->end - off ||
+			(off - heap->first) % MEMMAN_GRAIN ||
+			rebuild_gap(prev, end, off)) {
+			ptrs[i] = NULL;
+			continue;
+		}
 
-		pmcb = (mem_ctl_blk_t*)(((char*)pmcb) + pmcb->size);
+		/* Keep any slack the block was given if its tags still agree */
+		if (blk_inuse(off) && blk_size(off) > size &&
+			blk_size(off) <= heap->end - off &&
+			*tag_at(off + blk_size(off) - sizeof(mem_tag_t)) == *tag_at(off))
+			size = blk_size(off);
+
+		blk_set(off, size, 1);
+		heap->stats.used += size;
+		prev = off;
+		end = off + size;
+		kept++;
 	}
+	rebuild_gap(prev, end, heap->end);
+
+	heap->stats.free = heap->stats.size - heap->stats.used;
+	if (heap->stats.used > heap->stats.high_water)
+		heap->stats.high_water = heap->stats.used;
 
-	mcb->size = free_space;
+	return kept;
 }
 
-void memman_free(void *ptr)
+void memman_get_stats(memman_stats_t *stats)
 {
-	mem_ctl_blk_t *mcb = 0;  
-
-	/* Backup from the given pointer to find the 
-	 * mem_control_block */ 
-	mcb = (mem_ctl_blk_t*)(((char*)ptr) - sizeof(mem_ctl_blk_t));
+	uint64_t largest = 0, off;
+	int c;
 
-	/* Mark the block as being available */ 
-	mcb->is_inuse = 0;
+	if (!heap) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
 
-	/* Coalesce unused regions adjacent to this chunk */
-	coalesce(mcb);
+	*stats = heap->stats;
 
-	return;   	
+	/* The largest block is in the highest non-empty class */
+	if (heap->nonempty) {
+		c = 63 - __builtin_clzll(heap->nonempty);
+		for (off = heap->free_list[c]; off; off = free_blk(off)->next) {
+			if (blk_size(off) > largest)
+				largest = blk_size(off);
+		}
+	}
+	stats->largest_free = largest ? largest - MEMMAN_TAGS : 0;
 }
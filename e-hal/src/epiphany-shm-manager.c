@@ -33,6 +33,9 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <err.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <assert.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -50,15 +53,37 @@ typedef unsigned long long ulong64;
 static e_shmtable_t    *shm_table        = 0;
 static size_t           shm_table_length = 0;
 static int              epiphany_devfd   = -1;
+static int              shm_lock_fd      = -1;
+static pthread_mutex_t  shm_local_lock   = PTHREAD_MUTEX_INITIALIZER;
 static epiphany_alloc_t shm_alloc        = { 0 };
+static e_mem_t          shm_emem;
 
 static e_shmseg_pvt_t* shm_lookup_region(e_shmtable_t *tbl, const char *name);
-static e_shmseg_pvt_t* shm_alloc_region(e_shmtable_t *tbl, const char *name, size_t size);
+static e_shmseg_pvt_t* shm_alloc_region(e_shmtable_t *tbl, const char *name, size_t size,
+										size_t align);
+static void shm_update_stats(e_shmtable_t *tbl);
+static void shm_index_insert(e_shmtable_t *tbl, unsigned region);
+static void shm_index_remove(e_shmtable_t *tbl, unsigned region);
+static void shm_index_rebuild(e_shmtable_t *tbl);
+static void shm_recover(e_shmtable_t *tbl);
 static int shm_table_sanity_check(e_shmtable_t *tbl);
+static int shm_lock_open(void);
+static int shm_lock(int *contended);
+static int shm_unlock(void);
+static int shm_init_lock(void);
+static int shm_init_unlock(void);
+static uint32_t shm_read_begin(e_shmtable_t *tbl);
+static int shm_read_retry(e_shmtable_t *tbl, uint32_t seq);
+static void shm_write_begin(e_shmtable_t *tbl);
+static void shm_write_end(e_shmtable_t *tbl);
+static void shm_release_region(e_shmtable_t *tbl, e_shmseg_pvt_t *region);
 
 e_shmtable_t *e_shm_get_shmtable();
 int e_shm_put_shmtable();
 
+/* When this process took the writer lock, for the hold time statistics */
+static struct timespec shm_lock_taken;
+
 extern e_platform_t e_platform;
 extern int	 e_host_verbose;
 #define diag(vN) if (e_host_verbose >= vN)
@@ -84,16 +109,8 @@ static int e_shm_init_esim_and_pal()
 
 int e_shm_init_native()
 {
-	int              devfd       = 0;
 	e_memseg_t       *emem;
 
-	/* Map the epiphany global shared memory into process address space */
-	devfd = open(EPIPHANY_DEV, O_RDWR | O_SYNC);
-	if ( -1 == devfd ) {
-		warnx("e_init(): EPIPHANY_DEV file open failure.");
-		return E_ERR;
-	}
-
 	if (!e_platform.num_emems) {
 		warnx("e_shm_init(): No memory regions.");
 		return E_ERR;
@@ -107,17 +124,17 @@ int e_shm_init_native()
 
 	shm_table_length = shm_alloc.size;
 
-	shm_alloc.uvirt_addr = (unsigned long)mmap(0, shm_alloc.size,
-		PROT_READ|PROT_WRITE, MAP_SHARED, devfd, (off_t)shm_alloc.mmap_handle);
-	if ( MAP_FAILED == (void*)shm_alloc.uvirt_addr ) {
+	/* Map the epiphany global shared memory into process address space.
+	 * This is a view into the persistent mapping of the segment when
+	 * there is one. */
+	if ( E_OK != e_alloc(&shm_emem, 0x01000000, shm_alloc.size) ) {
 		warnx("e_shm_init(): Failed to map global shared memory. Error is %s",
 			  strerror(errno));
-
-		close(devfd);
 		return E_ERR;
 	}
 
-	epiphany_devfd = devfd;
+	shm_alloc.uvirt_addr = (unsigned long) shm_emem.base;
+	epiphany_devfd = shm_emem.memfd;
 
 	return E_OK;
 }
@@ -130,7 +147,7 @@ int e_shm_init()
 	uintptr_t heap = 0;
 	size_t heap_length = 0;
 	int rc;
-	e_shmtable_t *tbl;
+	int reset = 0;
 
 	if (ee_native_target_p())
 		rc = e_shm_init_native();
@@ -150,9 +167,12 @@ int e_shm_init()
 	shm_table = (e_shmtable_t*)shm_alloc.uvirt_addr;
 
 
-	// Enter critical section
-	tbl = e_shm_get_shmtable();
-	if ( !tbl )
+	if ( E_OK != shm_lock_open() )
+		return E_ERR;
+
+	/* Checking and resetting the table is serialized by the same lock as
+	 * writers, without the bookkeeping in the table */
+	if ( E_OK != shm_init_lock() )
 		return E_ERR;
 
 	/* Check whether we have a working SHM table and if not reset it */
@@ -166,10 +186,11 @@ int e_shm_init()
 
 		memset((void *) shm_table, 0, sizeof(*shm_table));
 		shm_table->magic      = SHM_MAGIC;
+		shm_table->version    = SHM_VERSION;
 		shm_table->paddr_epi  = shm_alloc.bus_addr;
 		shm_table->paddr_cpu  = shm_alloc.phy_addr;
-
 		shm_table->initialized = 1;
+		reset = 1;
 		diag(H_D1) { fprintf(stderr, "e_shm_init(): SHM table was reset.\n"); }
 	}
 
@@ -182,10 +203,16 @@ int e_shm_init()
 						 " Heap addr is 0x%08llx, length is 0x%08llx\n",
 						 (ulong64) heap, (ulong64) heap_length); }
 
-	memman_init((void*)heap, heap_length);
-
+	/* The heap keeps its state in shared memory, so only format it
+	 * along with a fresh table and attach to it otherwise */
+	if ( memman_init((void*)heap, heap_length, reset) ) {
+		shm_init_unlock();
+		return E_ERR;
+	}
+	if ( reset )
+		shm_update_stats(shm_table);
 
-	if ( E_OK != e_shm_put_shmtable() )
+	if ( E_OK != shm_init_unlock() )
 		return E_ERR;
 
 	return E_OK;
@@ -194,18 +221,32 @@ int e_shm_init()
 
 void e_shm_finalize(void)
 {
-	if (!ee_esim_target_p())
+	/* The mem target hands out pointers into its own backing memory */
+	if (shm_table && ee_native_target_p())
+		e_free(&shm_emem);
+	else if (!ee_esim_target_p() && !ee_mem_target_p())
 		munmap((void*)shm_table, shm_table_length);
+	shm_table = NULL;
+
+	if (shm_lock_fd >= 0 && shm_lock_fd != epiphany_devfd)
+		close(shm_lock_fd);
+	shm_lock_fd = -1;
 	diag(H_D2) { fprintf(stderr, "e_shm_finalize(): teardown complete\n"); }
 }
 
 int e_shm_alloc(e_mem_t *mbuf, const char *name, size_t size)
+{
+	return e_shm_alloc_aligned(mbuf, name, size, MEMMAN_GRAIN);
+}
+
+static int ee_shm_alloc_aligned(e_mem_t *mbuf, const char *name, size_t size,
+								size_t align)
 {
 	e_shmtable_t   *tbl	   = NULL;
 	e_shmseg_pvt_t *region = NULL;
 	int				retval = E_ERR;
 
-	if ( !mbuf || !name || !size ) {
+	if ( !mbuf || !name || !size || !align || (align & (align - 1)) ) {
 		errno = EINVAL;
 		goto err2;
 	}
@@ -228,11 +269,8 @@ int e_shm_alloc(e_mem_t *mbuf, const char *name, size_t size)
 	diag(H_D1) { fprintf(stderr, "e_shm_alloc(): alloc request for 0x%08x "
 						 "bytes named %s\n", size, name); }
 
-	region = shm_alloc_region(tbl, name, size);
+	region = shm_alloc_region(tbl, name, size, align);
 	if ( region ) {
-		region->valid = 1;
-		region->refcnt = 1;
-
 		mbuf->objtype = E_SHARED_MEM;
 		mbuf->memfd = epiphany_devfd;
 		mbuf->phy_base = tbl->paddr_cpu;
@@ -261,53 +299,99 @@ int e_shm_alloc(e_mem_t *mbuf, const char *name, size_t size)
 	return retval;
 }
 
-int e_shm_attach(e_mem_t *mbuf, const char *name)
+int e_shm_alloc_aligned(e_mem_t *mbuf, const char *name, size_t size,
+						size_t align)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_shm_alloc_aligned(mbuf, name, size, align);
+	ee_stats_end(E_OP_SHM_ALLOC, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+static int ee_shm_attach(e_mem_t *mbuf, const char *name)
 {
 	e_shmtable_t   *tbl	   = NULL;
 	e_shmseg_pvt_t *region = NULL;
-	int				retval = E_ERR;
+	uint32_t		seq, refcnt;
+	uint64_t		offset, size;
 
 	if ( !mbuf || !name ) {
 		return E_ERR;
 	}
 
-	// Enter critical section
-	tbl = e_shm_get_shmtable();
-	if ( !tbl )
+	if ( !shm_table && E_OK != e_shm_init() )
 		return E_ERR;
+	tbl = shm_table;
 
-	if ( E_OK != shm_table_sanity_check(tbl) ) {
-		retval = E_ERR;
-		goto err;
-	}
+	if ( E_OK != shm_table_sanity_check(tbl) )
+		return E_ERR;
 
-	region = shm_lookup_region(tbl, name);
-	if ( region ) {
-		++region->refcnt;
+	/* Attaching only reads the table and bumps a reference count, so do
+	 * it without the writer lock and retry if a writer got in the way */
+	for ( ;; ) {
+		seq = shm_read_begin(tbl);
 
-		mbuf->objtype = E_SHARED_MEM;
-		mbuf->memfd = epiphany_devfd;
-		mbuf->phy_base = tbl->paddr_cpu + sizeof(*tbl);
-		mbuf->ephy_base = tbl->paddr_epi + sizeof(*tbl); 
-		mbuf->page_base = 0; // Not used ??
-		mbuf->page_offset = region->shm_seg.offset;
-		mbuf->map_size = region->shm_seg.size;
-		mbuf->mapped_base = ((char*)(tbl));
-		mbuf->base = mbuf->mapped_base + mbuf->page_offset;
-		mbuf->emap_size = region->shm_seg.size;
+		region = shm_lookup_region(tbl, name);
+		if ( !region ) {
+			if ( shm_read_retry(tbl, seq) )
+				continue;
+			return E_ERR;
+		}
 
-		retval = e_platform.target_ops->shm_alloc(mbuf);
+		/* A region whose count dropped to zero is being freed */
+		refcnt = region->refcnt;
+		if ( !refcnt ) {
+			if ( shm_read_retry(tbl, seq) )
+				continue;
+			return E_ERR;
+		}
+		if ( !__sync_bool_compare_and_swap(&region->refcnt, refcnt, refcnt + 1) )
+			continue;
+
+		offset = region->shm_seg.offset;
+		size = region->shm_seg.size;
+
+		if ( !shm_read_retry(tbl, seq) )
+			break;
+
+		/* The slot may have been reused, drop the reference and retry */
+		if ( !e_shm_get_shmtable() )
+			return E_ERR;
+		shm_release_region(tbl, region);
+		e_shm_put_shmtable();
 	}
 
- err:
-	// Exit critical section
-	if ( E_OK != e_shm_put_shmtable() )
-		return E_ERR;
+	mbuf->objtype = E_SHARED_MEM;
+	mbuf->memfd = epiphany_devfd;
+	mbuf->phy_base = tbl->paddr_cpu;
+	mbuf->ephy_base = tbl->paddr_epi;
+	mbuf->page_base = 0; // Not used for shared memory regions
+	mbuf->page_offset = offset;
+	mbuf->map_size = size;
+	mbuf->mapped_base = ((char*)(tbl));
+	mbuf->base = mbuf->mapped_base + mbuf->page_offset;
+	mbuf->emap_size = size;
+
+	return e_platform.target_ops->shm_alloc(mbuf);
+}
 
-	return retval;
+int e_shm_attach(e_mem_t *mbuf, const char *name)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_shm_attach(mbuf, name);
+	ee_stats_end(E_OP_SHM_ATTACH, t0, 0, rc == E_ERR);
+
+	return rc;
 }
 
-int e_shm_release(const char *name)
+static int ee_shm_release(const char *name)
 {
 	e_shmseg_pvt_t   *region = NULL;
 	int               retval = E_ERR;
@@ -321,10 +405,7 @@ int e_shm_release(const char *name)
 	region = shm_lookup_region(tbl, name);
 
 	if ( region ) {
-		if ( 0 == --region->refcnt ) {
-			region->valid = 0;
-			memman_free(region->shm_seg.addr);
-		}
+		shm_release_region(tbl, region);
 		retval = E_OK;
 	}
 
@@ -335,27 +416,220 @@ int e_shm_release(const char *name)
 	return retval;
 }
 
+int e_shm_release(const char *name)
+{
+	uint64_t t0;
+	int rc;
+
+	t0 = ee_stats_begin();
+	rc = ee_shm_release(name);
+	ee_stats_end(E_OP_SHM_RELEASE, t0, 0, rc == E_ERR);
+
+	return rc;
+}
+
+int e_shm_get_stats(e_shm_stats_t *stats)
+{
+	e_shmtable_t *tbl;
+
+	if ( !stats ) {
+		errno = EINVAL;
+		return E_ERR;
+	}
+
+	// Enter critical section
+	tbl = e_shm_get_shmtable();
+	if ( !tbl )
+		return E_ERR;
+
+	*stats = tbl->heap_stats;
+
+	// Exit critical section
+	if ( E_OK != e_shm_put_shmtable() )
+		return E_ERR;
+
+	return E_OK;
+}
+
 /**
  * Search the shm table for a region named by name.
  *
- * WARNING: The caller should hold the shm table lock when
- * calling this function.
+ * WARNING: The caller should either hold the shm table lock or
+ * validate the result with shm_read_retry().
  */
 static e_shmseg_pvt_t*
 shm_lookup_region(e_shmtable_t *tbl, const char *name)
 {
-	e_shmseg_pvt_t   *retval = NULL;
-	int               i      = 0;
+	uint32_t hash = e_shm_hash(name);
+	unsigned i, n;
 
-	for ( i = 0; i < MAX_SHM_REGIONS; ++i ) {
-		if ( tbl->regions[i].valid && 
-			 !strcmp(name, tbl->regions[i].shm_seg.name) ) {
-			retval = &tbl->regions[i];
+	for ( n = 0, i = hash & (SHM_INDEX_SIZE - 1); n < SHM_INDEX_SIZE;
+		  ++n, i = (i + 1) & (SHM_INDEX_SIZE - 1) ) {
+		e_shm_index_t *ent = &tbl->index[i];
+		e_shmseg_pvt_t *region;
+
+		if ( SHM_INDEX_EMPTY == ent->slot )
+			break;
+		if ( SHM_INDEX_DELETED == ent->slot || hash != ent->hash )
+			continue;
+
+		region = &tbl->regions[ent->slot - 1];
+		if ( region->valid &&
+			 !strncmp(name, region->shm_seg.name,
+					  sizeof(region->shm_seg.name)) )
+			return region;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a region to the name index.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_index_insert(e_shmtable_t *tbl, unsigned region)
+{
+	uint32_t hash = e_shm_hash(tbl->regions[region].shm_seg.name);
+	unsigned i;
+
+	/* There are more index entries than regions, so this terminates */
+	for ( i = hash & (SHM_INDEX_SIZE - 1);
+		  SHM_INDEX_EMPTY != tbl->index[i].slot &&
+			  SHM_INDEX_DELETED != tbl->index[i].slot;
+		  i = (i + 1) & (SHM_INDEX_SIZE - 1) )
+		;
+
+	if ( SHM_INDEX_DELETED == tbl->index[i].slot )
+		--tbl->index_deleted;
+
+	tbl->index[i].hash = hash;
+	tbl->index[i].slot = region + 1;
+}
+
+/**
+ * Remove a region from the name index, and rebuild the index once
+ * deleted entries start to lengthen the probe sequences.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_index_remove(e_shmtable_t *tbl, unsigned region)
+{
+	uint32_t hash = e_shm_hash(tbl->regions[region].shm_seg.name);
+	unsigned i, n;
+
+	for ( n = 0, i = hash & (SHM_INDEX_SIZE - 1);
+		  n < SHM_INDEX_SIZE && SHM_INDEX_EMPTY != tbl->index[i].slot;
+		  ++n, i = (i + 1) & (SHM_INDEX_SIZE - 1) ) {
+		if ( tbl->index[i].slot == region + 1 ) {
+			tbl->index[i].slot = SHM_INDEX_DELETED;
+			++tbl->index_deleted;
 			break;
 		}
 	}
 
-	return retval;
+	if ( tbl->index_deleted >= SHM_INDEX_SIZE / 4 )
+		shm_index_rebuild(tbl);
+}
+
+/**
+ * Rebuild the name index from the valid regions.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_index_rebuild(e_shmtable_t *tbl)
+{
+	unsigned i;
+
+	memset(tbl->index, 0, sizeof(tbl->index));
+	tbl->index_deleted = 0;
+	for ( i = 0; i < MAX_SHM_REGIONS; ++i ) {
+		if ( tbl->regions[i].valid )
+			shm_index_insert(tbl, i);
+	}
+}
+
+/**
+ * Bring the regions and the heap back in line after a writer died with
+ * the lock, possibly half way through changing either. Regions that don't
+ * describe a block of the heap are dropped, and the heap is rebuilt around
+ * the rest, which also frees any block the writer allocated but did not
+ * get to enter. Readers are kept out until the index is rebuilt too.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_recover(e_shmtable_t *tbl)
+{
+	unsigned        order[MAX_SHM_REGIONS];
+	void           *ptrs[MAX_SHM_REGIONS];
+	size_t          sizes[MAX_SHM_REGIONS] = { 0 };
+	e_shmseg_pvt_t *region;
+	unsigned        i, j, n = 0;
+
+	if ( !(tbl->seq & 1) )
+		shm_write_begin(tbl);
+
+	/* The heap wants the blocks in address order */
+	for ( i = 0; i < MAX_SHM_REGIONS; ++i ) {
+		if ( !tbl->regions[i].valid )
+			continue;
+		for ( j = n; j > 0 && tbl->regions[order[j - 1]].shm_seg.offset >
+				  tbl->regions[i].shm_seg.offset; --j )
+			order[j] = order[j - 1];
+		order[j] = i;
+		++n;
+	}
+
+	for ( i = 0; i < n; ++i ) {
+		region = &tbl->regions[order[i]];
+		sizes[i] = region->shm_seg.size;
+		ptrs[i] = ( region->shm_seg.offset < shm_table_length &&
+					region->shm_seg.size < shm_table_length ) ?
+			(char*)tbl + region->shm_seg.offset : NULL;
+	}
+
+	memman_rebuild(ptrs, sizes, n);
+
+	for ( i = 0; i < n; ++i ) {
+		if ( ptrs[i] )
+			continue;
+		region = &tbl->regions[order[i]];
+		warnx("%s(): Dropping inconsistent SHM region %.*s", __func__,
+			  (int) sizeof(region->shm_seg.name), region->shm_seg.name);
+		region->valid = 0;
+		region->refcnt = 0;
+	}
+
+	shm_index_rebuild(tbl);
+	shm_update_stats(tbl);
+	shm_write_end(tbl);
+}
+
+/**
+ * Drop a reference to a region and free it with the last one.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_release_region(e_shmtable_t *tbl, e_shmseg_pvt_t *region)
+{
+	/* Lock-free attaches may bump the count concurrently, but never
+	 * from zero */
+	if ( __sync_sub_and_fetch(&region->refcnt, 1) )
+		return;
+
+	shm_write_begin(tbl);
+	region->valid = 0;
+	shm_index_remove(tbl, region - tbl->regions);
+	shm_write_end(tbl);
+
+	/* addr is only valid in the allocating process */
+	memman_free((char*)tbl + region->shm_seg.offset);
+	shm_update_stats(tbl);
 }
 
 /**
@@ -365,57 +639,94 @@ shm_lookup_region(e_shmtable_t *tbl, const char *name)
  * calling this function.
  */
 static e_shmseg_pvt_t*
-shm_alloc_region(e_shmtable_t *tbl, const char *name, size_t size)
+shm_alloc_region(e_shmtable_t *tbl, const char *name, size_t size,
+				 size_t align)
 {
 	e_shmseg_pvt_t   *region = NULL;
+	void             *addr   = NULL;
 	int               i      = 0;
 
 	for ( i = 0; i < MAX_SHM_REGIONS; ++i ) {
-		if ( !tbl->regions[i].valid ) {
+		if ( !tbl->regions[i].valid )
+			break;
+	}
+	if ( i == MAX_SHM_REGIONS )
+		return NULL;
 
-			region = &tbl->regions[i];
-			strncpy(region->shm_seg.name, name, sizeof(region->shm_seg.name));
+	addr = memman_alloc_aligned(size, align);
+	shm_update_stats(tbl);
+	if ( !addr ) {
+		/* Allocation failed */
+		diag(H_D1) { fprintf(stderr, "shm_alloc_region(): alloc request for 0x%08x "
+							 "bytes named %s failed\n", size, name); }
+		return NULL;
+	}
 
-			region->shm_seg.addr = memman_alloc(size);
-			if ( !region->shm_seg.addr ) {
-				/* Allocation failed */
-				diag(H_D1) { fprintf(stderr, "shm_alloc_region(): alloc request for 0x%08x "
-									 "bytes named %s failed\n", size, name); }
+	/* Lock-free readers must not see the region half filled in */
+	shm_write_begin(tbl);
 
-				region = NULL;
-				break;
-			}
+	region = &tbl->regions[i];
+	strncpy(region->shm_seg.name, name, sizeof(region->shm_seg.name));
+	region->shm_seg.addr = addr;
 
-			/*
-			 * Note: the shm heap follows the shm table in memory.
-			 */
-			region->shm_seg.offset = ((char*)region->shm_seg.addr) -
-				((char*)tbl);
+	/*
+	 * Note: the shm heap follows the shm table in memory.
+	 */
+	region->shm_seg.offset = ((char*)region->shm_seg.addr) -
+		((char*)tbl);
 
-			region->shm_seg.paddr = ((char*)tbl->paddr_epi) + 
-				region->shm_seg.offset;
-			
-			region->shm_seg.size = size;
+	region->shm_seg.paddr = ((char*)tbl->paddr_epi) + 
+		region->shm_seg.offset;
 
-			tbl->regions[i].valid = 1;
+	region->shm_seg.size = size;
+	region->refcnt = 1;
 
-			diag(H_D1) {
-				fprintf(stderr, "e_hal::shm_alloc_region(): allocated shm "
-						"region: name %s, addr 0x%08lx, paddr 0x%08lx, "
-						"offset 0x%08x, size 0x%08x\n", region->shm_seg.name,
-						(unsigned long)region->shm_seg.addr,
-						(unsigned long)region->shm_seg.paddr,
-						(unsigned)region->shm_seg.offset,
-						region->shm_seg.size);
-			}
-			
-			break;
-		}
+	tbl->regions[i].valid = 1;
+	shm_index_insert(tbl, i);
+
+	shm_write_end(tbl);
+
+	diag(H_D1) {
+		fprintf(stderr, "e_hal::shm_alloc_region(): allocated shm "
+				"region: name %s, addr 0x%08lx, paddr 0x%08lx, "
+				"offset 0x%08x, size 0x%08x\n", region->shm_seg.name,
+				(unsigned long)region->shm_seg.addr,
+				(unsigned long)region->shm_seg.paddr,
+				(unsigned)region->shm_seg.offset,
+				region->shm_seg.size);
 	}
 
 	return region;
 }
 
+/**
+ * Copy the memory manager statistics into the shm table.
+ *
+ * WARNING: The caller should hold the shm table lock when
+ * calling this function.
+ */
+static void shm_update_stats(e_shmtable_t *tbl)
+{
+	memman_stats_t ms;
+	e_shm_stats_t *st = &tbl->heap_stats;
+
+	memman_get_stats(&ms);
+
+	st->size         = ms.size;
+	st->used         = ms.used;
+	st->free         = ms.free;
+	st->high_water   = ms.high_water;
+	st->largest_free = ms.largest_free;
+	st->free_blocks  = ms.free_blocks;
+	st->allocs       = ms.allocs;
+	st->frees        = ms.frees;
+	st->failed       = ms.failed;
+	st->fragmentation = ms.free ?
+		((ms.free - ms.largest_free) * 100) / ms.free : 0;
+
+	tbl->free_space = ms.free;
+}
+
 /**
  * Sanity-check the shm table
  *
@@ -447,21 +758,178 @@ static int shm_table_sanity_check(e_shmtable_t *tbl)
 		return E_ERR;
 	}
 
+	if ( tbl->version != SHM_VERSION ) {
+		diag(H_D1) {
+			fprintf(stderr, "shm_table_sanity_check(): Bad shm "
+					"version. Expected %u found %u\n",
+					SHM_VERSION, tbl->version);
+		}
+		return E_ERR;
+	}
+
 	return E_OK;
 }
 
 
 
 /**
- * The belows two functions provide mutual exclusion to the
- * SHM table.
+ * Writers to the SHM table are serialized by a mutex between the threads
+ * of this process and lockf() between processes: on the device for the
+ * native target, on a lock file for the simulators. The kernel drops the
+ * lockf() lock of a process that dies, and the holder's pid in the table
+ * tells the next writer that it has to recover. The memory target is
+ * private to the process and only needs the mutex. Readers do not lock.
+ * Writers make the sequence counter odd while they change regions or the
+ * index, and readers retry when the counter was odd or changed under
+ * them.
  *
- * lockf() is good for simple things like these, but if we ever need more
- * advanced locking features we might have to resort to fcntl().
+ * Creating or resetting the table is serialized by the same lock.
  */
 
+static uint64_t shm_ts_diff_ns(const struct timespec *a, const struct timespec *b)
+{
+	return (uint64_t) (b->tv_sec - a->tv_sec) * 1000000000ULL +
+		b->tv_nsec - a->tv_nsec;
+}
+
+static int shm_lock_open(void)
+{
+	char path[64];
+
+	if ( shm_lock_fd >= 0 || ee_mem_target_p() )
+		return E_OK;
+
+	if ( ee_native_target_p() ) {
+		shm_lock_fd = epiphany_devfd;
+		return E_OK;
+	}
+
+	/* The simulators don't give us a descriptor for their shared memory */
+	snprintf(path, sizeof(path), "/tmp/e-hal-shm.%u.lock", (unsigned) getuid());
+	shm_lock_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if ( shm_lock_fd < 0 ) {
+		warnx("%s(): Failed to open %s. Error is %s", __func__, path,
+			  strerror(errno));
+		return E_ERR;
+	}
+
+	return E_OK;
+}
+
+/* Returns 0 or an errno value */
+static int shm_lock(int *contended)
+{
+	int rc;
+
+	rc = pthread_mutex_trylock(&shm_local_lock);
+	if ( EBUSY == rc ) {
+		*contended = 1;
+		rc = pthread_mutex_lock(&shm_local_lock);
+	}
+	if ( rc )
+		return rc;
+
+	if ( shm_lock_fd < 0 || !lockf(shm_lock_fd, F_TLOCK, 0) )
+		return 0;
+
+	rc = errno;
+	if ( EACCES == rc || EAGAIN == rc ) {
+		*contended = 1;
+		do {
+			rc = lockf(shm_lock_fd, F_LOCK, 0) ? errno : 0;
+		} while ( EINTR == rc );
+	}
+
+	if ( rc )
+		pthread_mutex_unlock(&shm_local_lock);
+	return rc;
+}
+
+/* Returns 0 or an errno value */
+static int shm_unlock(void)
+{
+	int rc = 0;
+
+	if ( shm_lock_fd >= 0 && lockf(shm_lock_fd, F_ULOCK, 0) )
+		rc = errno;
+	pthread_mutex_unlock(&shm_local_lock);
+
+	return rc;
+}
+
+static int shm_init_lock(void)
+{
+	int contended = 0, rc;
+
+	rc = shm_lock(&contended);
+	if ( rc ) {
+		warnx("%s(): Failed to lock shared memory. Error is %s",
+				__func__, strerror(rc));
+		return E_ERR;
+	}
+	return E_OK;
+}
+
+static int shm_init_unlock(void)
+{
+	int rc;
+
+	rc = shm_unlock();
+	if ( rc ) {
+		warnx("%s(): Failed to unlock shared memory. Error is %s",
+				__func__, strerror(rc));
+		return E_ERR;
+	}
+	return E_OK;
+}
+
+static uint32_t shm_read_begin(e_shmtable_t *tbl)
+{
+	uint32_t seq;
+	unsigned spins = 0;
+
+	while ( (seq = *(volatile uint32_t *) &tbl->seq) & 1 ) {
+		/* Wait for the writer to finish, which also recovers the table
+		 * if the writer died in the middle of an update */
+		if ( ++spins % 1024 == 0 && e_shm_get_shmtable() )
+			e_shm_put_shmtable();
+		else if ( spins % 64 == 0 )
+			sched_yield();
+	}
+	__sync_synchronize();
+
+	return seq;
+}
+
+static int shm_read_retry(e_shmtable_t *tbl, uint32_t seq)
+{
+	__sync_synchronize();
+	if ( *(volatile uint32_t *) &tbl->seq == seq )
+		return 0;
+
+	__sync_fetch_and_add(&tbl->lock_stats.read_retries, 1);
+	return 1;
+}
+
+static void shm_write_begin(e_shmtable_t *tbl)
+{
+	*(volatile uint32_t *) &tbl->seq = tbl->seq + 1;
+	__sync_synchronize();
+}
+
+static void shm_write_end(e_shmtable_t *tbl)
+{
+	__sync_synchronize();
+	*(volatile uint32_t *) &tbl->seq = tbl->seq + 1;
+}
+
 e_shmtable_t *e_shm_get_shmtable()
 {
+	e_shm_lock_stats_t *st;
+	struct timespec start;
+	uint64_t wait;
+	int rc, contended = 0;
+
 	if (!shm_table) {
 		if ( E_OK != e_shm_init() ) {
 			warnx("e_init(): Failed to initialize the Epiphany Shared Memory Manager.");
@@ -469,31 +937,86 @@ e_shmtable_t *e_shm_get_shmtable()
 		}
 	}
 
-	/* TODO: Add locking support for ESIM / PAL target */
-	if (!ee_native_target_p())
-		return shm_table;
+	st = &shm_table->lock_stats;
 
 	diag(H_D3) { fprintf(stderr, "e_shm_get_shmtable(): Taking lock...\n"); }
-	if ( lockf(epiphany_devfd, F_LOCK, 0) ) {
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	rc = shm_lock(&contended);
+	if ( rc ) {
 		warnx("%s(): Failed to lock shared memory. Error is %s",
-				__func__, strerror(errno));
+				__func__, strerror(rc));
 		return NULL;
 	}
 	diag(H_D3) { fprintf(stderr, "e_shm_get_shmtable(): Lock acquired.\n"); }
 
+	if ( shm_table->writer ) {
+		/* The holder died, possibly half way through an update */
+		warnx("%s(): SHM table lock holder %u died, recovering",
+			  __func__, shm_table->writer);
+		shm_recover(shm_table);
+		++st->owner_died;
+	}
+	shm_table->writer = getpid();
+
+	clock_gettime(CLOCK_MONOTONIC, &shm_lock_taken);
+	++st->acquired;
+	if ( contended ) {
+		wait = shm_ts_diff_ns(&start, &shm_lock_taken);
+		++st->contended;
+		st->wait_ns += wait;
+		if ( wait > st->max_wait_ns )
+			st->max_wait_ns = wait;
+	}
+
 	return shm_table;
 }
 
 int e_shm_put_shmtable()
 {
-	/* TODO: Add locking support for ESIM / PAL target */
-	if (!ee_native_target_p())
-		return E_OK;
+	e_shm_lock_stats_t *st;
+	struct timespec now;
+	uint64_t hold;
+	int rc;
+
+	if ( !shm_table )
+		return E_ERR;
 
-	if ( lockf(epiphany_devfd, F_ULOCK, 0) ) {
+	st = &shm_table->lock_stats;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	hold = shm_ts_diff_ns(&shm_lock_taken, &now);
+	st->hold_ns += hold;
+	if ( hold > st->max_hold_ns )
+		st->max_hold_ns = hold;
+
+	shm_table->writer = 0;
+	rc = shm_unlock();
+	if ( rc ) {
 		warnx("%s(): Failed to unlock shared memory. Error is %s",
-				__func__, strerror(errno));
+				__func__, strerror(rc));
+		return E_ERR;
+	}
+	return E_OK;
+}
+
+int e_shm_get_lock_stats(e_shm_lock_stats_t *stats)
+{
+	e_shmtable_t *tbl;
+
+	if ( !stats ) {
+		errno = EINVAL;
 		return E_ERR;
 	}
+
+	// Enter critical section
+	tbl = e_shm_get_shmtable();
+	if ( !tbl )
+		return E_ERR;
+
+	*stats = tbl->lock_stats;
+
+	// Exit critical section
+	if ( E_OK != e_shm_put_shmtable() )
+		return E_ERR;
+
 	return E_OK;
 }
@@ -0,0 +1,416 @@
+/*
+  File: epiphany-stats.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.	 If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Call instrumentation.
+ *
+ * With EHAL_STATS set, the public API and the target operator dispatch
+ * count calls, bytes and errors and keep a log2 latency histogram per
+ * operation and target. Every thread counts into its own block, so the
+ * hot paths take no locks. Blocks are only linked into a list when a
+ * thread first counts something, and folded into a common block when the
+ * thread exits. Readers sum the blocks without stopping the writers, so a
+ * report taken while other threads are busy may be slightly torn.
+ *
+ * EHAL_STATS=json dumps the report as JSON at e_finalize(), any other
+ * value as text. EHAL_STATS_FILE redirects it from stderr to a file.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <err.h>
+
+#include "epiphany-hal.h"
+#include "epiphany-hal-api-local.h"
+
+#ifdef ESIM_TARGET
+extern const struct e_target_ops esim_target_ops;
+#endif
+#ifdef PAL_TARGET
+extern const struct e_target_ops pal_target_ops;
+#endif
+extern const struct e_target_ops mem_target_ops;
+extern e_platform_t e_platform;
+
+struct ee_stats_block {
+	e_op_stats_t		   ops[E_TARGET_NUM][E_OP_NUM];
+	struct ee_stats_block *next;
+};
+
+int ee_stats_on = 0;
+
+static pthread_mutex_t		  ee_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t		  ee_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t		  ee_stats_key;
+static struct ee_stats_block *ee_stats_blocks;	 /* Live threads */
+static struct ee_stats_block  ee_stats_retired;	 /* Exited threads */
+static e_target_t			  ee_stats_target;
+static bool					  ee_stats_json;
+
+static __thread struct ee_stats_block *ee_stats_tls;
+
+static const char *ee_op_names[E_OP_NUM] = {
+	[E_OP_OPEN]				 = "e_open",
+	[E_OP_CLOSE]			 = "e_close",
+	[E_OP_READ]				 = "e_read",
+	[E_OP_WRITE]			 = "e_write",
+	[E_OP_READ_V]			 = "e_read_v",
+	[E_OP_WRITE_V]			 = "e_write_v",
+	[E_OP_WRITE_BROADCAST]	 = "e_write_broadcast",
+	[E_OP_READ_REGS]		 = "e_read_regs",
+	[E_OP_ALLOC]			 = "e_alloc",
+	[E_OP_FREE]				 = "e_free",
+	[E_OP_LOAD_GROUP]		 = "e_load_group",
+	[E_OP_START_GROUP]		 = "e_start_group",
+	[E_OP_RESET_SYSTEM]		 = "e_reset_system",
+	[E_OP_RESET_GROUP]		 = "e_reset_group",
+	[E_OP_START]			 = "e_start",
+	[E_OP_SIGNAL]			 = "e_signal",
+	[E_OP_HALT]				 = "e_halt",
+	[E_OP_RESUME]			 = "e_resume",
+	[E_OP_WAIT]				 = "e_wait",
+	[E_OP_SHM_ALLOC]		 = "e_shm_alloc",
+	[E_OP_SHM_ATTACH]		 = "e_shm_attach",
+	[E_OP_SHM_RELEASE]		 = "e_shm_release",
+	[E_OP_T_READ_WORD]		 = "ee_read_word",
+	[E_OP_T_WRITE_WORD]		 = "ee_write_word",
+	[E_OP_T_READ_BUF]		 = "ee_read_buf",
+	[E_OP_T_WRITE_BUF]		 = "ee_write_buf",
+	[E_OP_T_READ_REG]		 = "ee_read_reg",
+	[E_OP_T_WRITE_REG]		 = "ee_write_reg",
+	[E_OP_T_MREAD_WORD]		 = "ee_mread_word",
+	[E_OP_T_MWRITE_WORD]	 = "ee_mwrite_word",
+	[E_OP_T_MREAD_BUF]		 = "ee_mread_buf",
+	[E_OP_T_MWRITE_BUF]		 = "ee_mwrite_buf",
+	[E_OP_T_READ_V]			 = "ee_read_v",
+	[E_OP_T_WRITE_V]		 = "ee_write_v",
+	[E_OP_T_READ_REGS]		 = "ee_read_regs",
+	[E_OP_T_WRITE_BROADCAST] = "ee_write_broadcast",
+};
+
+static const char *ee_target_names[E_TARGET_NUM] = {
+	[E_TARGET_NATIVE] = "native",
+	[E_TARGET_MEM]	  = "mem",
+	[E_TARGET_ESIM]	  = "esim",
+	[E_TARGET_PAL]	  = "pal",
+};
+
+static void ee_stats_merge(e_op_stats_t *to, const e_op_stats_t *from)
+{
+	unsigned i;
+
+	to->calls	 += from->calls;
+	to->errors	 += from->errors;
+	to->bytes	 += from->bytes;
+	to->total_ns += from->total_ns;
+	if (to->max_ns < from->max_ns)
+		to->max_ns = from->max_ns;
+	for (i = 0; i < E_STATS_BUCKETS; i++)
+		to->hist[i] += from->hist[i];
+}
+
+/* Fold the block of an exiting thread into the common one */
+static void ee_stats_thread_exit(void *arg)
+{
+	struct ee_stats_block *block = arg, **p;
+	unsigned t, op;
+
+	pthread_mutex_lock(&ee_stats_lock);
+
+	for (t = 0; t < E_TARGET_NUM; t++)
+		for (op = 0; op < E_OP_NUM; op++)
+			ee_stats_merge(&ee_stats_retired.ops[t][op], &block->ops[t][op]);
+
+	for (p = &ee_stats_blocks; *p; p = &(*p)->next) {
+		if (*p == block) {
+			*p = block->next;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&ee_stats_lock);
+
+	free(block);
+}
+
+static void ee_stats_make_key()
+{
+	pthread_key_create(&ee_stats_key, ee_stats_thread_exit);
+}
+
+static struct ee_stats_block *ee_stats_block()
+{
+	struct ee_stats_block *block;
+
+	if (ee_stats_tls)
+		return ee_stats_tls;
+
+	block = calloc(1, sizeof(*block));
+	if (!block)
+		return NULL;
+
+	pthread_once(&ee_stats_once, ee_stats_make_key);
+	pthread_setspecific(ee_stats_key, block);
+
+	pthread_mutex_lock(&ee_stats_lock);
+	block->next = ee_stats_blocks;
+	ee_stats_blocks = block;
+	pthread_mutex_unlock(&ee_stats_lock);
+
+	ee_stats_tls = block;
+
+	return block;
+}
+
+// Called by e_init() once the target is known
+void ee_stats_init()
+{
+	const char *p;
+
+	p = getenv("EHAL_STATS");
+	ee_stats_on = (p && p[0] != '\0');
+	ee_stats_json = (p && !strcmp(p, "json"));
+
+	ee_stats_target = E_TARGET_NATIVE;
+	if (e_platform.target_ops == &mem_target_ops)
+		ee_stats_target = E_TARGET_MEM;
+#ifdef ESIM_TARGET
+	if (e_platform.target_ops == &esim_target_ops)
+		ee_stats_target = E_TARGET_ESIM;
+#endif
+#ifdef PAL_TARGET
+	if (e_platform.target_ops == &pal_target_ops)
+		ee_stats_target = E_TARGET_PAL;
+#endif
+}
+
+// Called by e_finalize(). Dumps the report if EHAL_STATS is set.
+void ee_stats_finalize()
+{
+	const char *path;
+	FILE *f = stderr;
+
+	if (!ee_stats_on)
+		return;
+
+	path = getenv("EHAL_STATS_FILE");
+	if (path && path[0] != '\0') {
+		f = fopen(path, "w");
+		if (!f) {
+			warnx("e_finalize(): Can't open EHAL_STATS_FILE \"%s\".", path);
+			return;
+		}
+	}
+
+	e_dump_stats(f, ee_stats_json ? E_TRUE : E_FALSE);
+
+	if (f != stderr)
+		fclose(f);
+}
+
+uint64_t ee_stats_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	/* Zero means "not timed" to ee_stats_end() */
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec + 1;
+}
+
+void ee_stats_add(e_op_t op, uint64_t t0, ssize_t bytes, bool err)
+{
+	struct ee_stats_block *block;
+	e_op_stats_t *s;
+	uint64_t ns;
+	unsigned bucket;
+
+	ns = ee_stats_now() - t0;
+
+	block = ee_stats_block();
+	if (!block)
+		return;
+
+	s = &block->ops[ee_stats_target][op];
+	s->calls++;
+	if (err)
+		s->errors++;
+	else if (bytes > 0)
+		s->bytes += bytes;
+	s->total_ns += ns;
+	if (s->max_ns < ns)
+		s->max_ns = ns;
+
+	bucket = ns ? 64 - __builtin_clzll(ns) : 0;
+	if (bucket >= E_STATS_BUCKETS)
+		bucket = E_STATS_BUCKETS - 1;
+	s->hist[bucket]++;
+}
+
+// Get the statistics of one operation on one target, summed over threads
+int e_get_op_stats(e_target_t target, e_op_t op, e_op_stats_t *stats)
+{
+	struct ee_stats_block *block;
+
+	if (target >= E_TARGET_NUM || op >= E_OP_NUM || !stats)
+		return E_ERR;
+
+	pthread_mutex_lock(&ee_stats_lock);
+
+	*stats = ee_stats_retired.ops[target][op];
+	for (block = ee_stats_blocks; block; block = block->next)
+		ee_stats_merge(stats, &block->ops[target][op]);
+
+	pthread_mutex_unlock(&ee_stats_lock);
+
+	return E_OK;
+}
+
+// Get the name of an operation
+const char *e_get_op_name(e_op_t op)
+{
+	if (op >= E_OP_NUM)
+		return NULL;
+
+	return ee_op_names[op];
+}
+
+// Clear the statistics of all threads
+void e_reset_stats()
+{
+	struct ee_stats_block *block;
+
+	pthread_mutex_lock(&ee_stats_lock);
+
+	memset(ee_stats_retired.ops, 0, sizeof(ee_stats_retired.ops));
+	for (block = ee_stats_blocks; block; block = block->next)
+		memset(block->ops, 0, sizeof(block->ops));
+
+	pthread_mutex_unlock(&ee_stats_lock);
+}
+
+static void ee_dump_text(FILE *f, e_target_t target, e_op_stats_t *ops)
+{
+	e_op_stats_t *s;
+	unsigned op, i;
+
+	fprintf(f, "e-hal statistics, target %s\n", ee_target_names[target]);
+	fprintf(f, "%-20s %10s %8s %14s %12s %10s %10s\n",
+			"operation", "calls", "errors", "bytes", "total ms",
+			"mean us", "max us");
+
+	for (op = 0; op < E_OP_NUM; op++) {
+		s = &ops[op];
+		if (!s->calls)
+			continue;
+
+		fprintf(f, "%-20s %10llu %8llu %14llu %12.3f %10.3f %10.3f\n",
+				ee_op_names[op], (unsigned long long) s->calls,
+				(unsigned long long) s->errors,
+				(unsigned long long) s->bytes, s->total_ns / 1e6,
+				s->total_ns / 1e3 / s->calls, s->max_ns / 1e3);
+
+		fprintf(f, "%-20s", "");
+		for (i = 0; i < E_STATS_BUCKETS; i++)
+			if (s->hist[i])
+				fprintf(f, " <2^%u:%llu", i,
+						(unsigned long long) s->hist[i]);
+		fprintf(f, "\n");
+	}
+}
+
+static void ee_dump_json(FILE *f, e_target_t target, e_op_stats_t *ops,
+						 bool first)
+{
+	e_op_stats_t *s;
+	unsigned op, i;
+	bool first_op = true;
+
+	fprintf(f, "%s\n  {\"target\": \"%s\", \"ops\": [", first ? "" : ",",
+			ee_target_names[target]);
+
+	for (op = 0; op < E_OP_NUM; op++) {
+		s = &ops[op];
+		if (!s->calls)
+			continue;
+
+		fprintf(f, "%s\n    {\"name\": \"%s\", \"calls\": %llu, "
+				"\"errors\": %llu, \"bytes\": %llu, \"total_ns\": %llu, "
+				"\"max_ns\": %llu, \"hist\": [",
+				first_op ? "" : ",", ee_op_names[op],
+				(unsigned long long) s->calls,
+				(unsigned long long) s->errors,
+				(unsigned long long) s->bytes,
+				(unsigned long long) s->total_ns,
+				(unsigned long long) s->max_ns);
+		for (i = 0; i < E_STATS_BUCKETS; i++)
+			fprintf(f, "%s%llu", i ? ", " : "",
+					(unsigned long long) s->hist[i]);
+		fprintf(f, "]}");
+		first_op = false;
+	}
+
+	fprintf(f, "\n  ]}");
+}
+
+// Write a report of all operations with calls, as text or JSON
+int e_dump_stats(FILE *f, e_bool_t json)
+{
+	e_op_stats_t ops[E_OP_NUM];
+	unsigned target, op;
+	bool any, first = true;
+
+	if (!f)
+		return E_ERR;
+
+	if (json)
+		fprintf(f, "[");
+
+	for (target = 0; target < E_TARGET_NUM; target++) {
+		any = false;
+		for (op = 0; op < E_OP_NUM; op++) {
+			e_get_op_stats(target, op, &ops[op]);
+			any = any || ops[op].calls;
+		}
+		if (!any)
+			continue;
+
+		if (json)
+			ee_dump_json(f, target, ops, first);
+		else
+			ee_dump_text(f, target, ops);
+		first = false;
+	}
+
+	if (json)
+		fprintf(f, "\n]\n");
+
+	fflush(f);
+
+	return E_OK;
+}
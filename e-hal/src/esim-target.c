@@ -161,6 +161,24 @@ static ssize_t ee_write_reg_esim(e_epiphany_t *dev, unsigned row, unsigned col,
 	return size;
 }
 
+// Read a block of core registers from a core in a group
+static ssize_t ee_read_regs_esim(e_epiphany_t *dev, unsigned row, unsigned col, off_t from_addr, unsigned *buf, unsigned count)
+{
+	uint32_t addr;
+	ssize_t size;
+	es_state *esim = (es_state *) dev->priv;
+
+	addr = (dev->core[row][col].id << 20) + from_addr;
+
+	size = count * sizeof(unsigned);
+	if (ES_OK != es_ops.mem_load(esim, addr, size, (uint8_t *) buf))
+	{
+		warnx("ee_read_regs(): Failed.");
+		return E_ERR;
+	}
+	return size;
+}
+
 // Read a word from an external memory buffer
 static int ee_mread_word_esim(e_mem_t *mbuf, const off_t from_addr)
 {
@@ -356,4 +374,5 @@ const struct e_target_ops esim_target_ops = {
 	.alloc = alloc_esim,
 	.shm_alloc = alloc_esim,
 	.free = free_esim,
+	.ee_read_regs = ee_read_regs_esim,
 };
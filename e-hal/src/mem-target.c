@@ -0,0 +1,441 @@
+/*
+  File: mem-target.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2016 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* Memory backed target. Core SRAM, core register files and external memory
+ * are backed by anonymous host memory, sized from the HDF. No program is ever
+ * executed, but everything on the host side (e_open, e_load_group,
+ * e_read/e_write, the SHM manager ...) works at full host memory speed.
+ * Select with EHAL_TARGET=mem. */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <err.h>
+#include "epiphany-hal.h"
+#include "epiphany-hal-api-local.h"
+
+extern e_platform_t e_platform;
+
+struct mem_backing {
+	bool      initialized;
+	uint8_t **chip;       /* One block per chip, num_cores * (sram + regs) */
+	size_t   *chip_size;
+	uint8_t **emem;       /* One block per external memory segment */
+};
+
+static struct mem_backing backing;
+
+static void *map_anon(size_t size)
+{
+	void *p;
+
+	p = mmap(NULL, size, PROT_READ|PROT_WRITE,
+			 MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+
+	return p == MAP_FAILED ? NULL : p;
+}
+
+static void mem_release_backing(void)
+{
+	int i;
+
+	for (i = 0; backing.chip && i < e_platform.num_chips; i++)
+		if (backing.chip[i])
+			munmap(backing.chip[i], backing.chip_size[i]);
+
+	for (i = 0; backing.emem && i < e_platform.num_emems; i++)
+		if (backing.emem[i])
+			munmap(backing.emem[i], e_platform.emem[i].size);
+
+	free(backing.chip);
+	free(backing.chip_size);
+	free(backing.emem);
+
+	memset(&backing, 0, sizeof(backing));
+}
+
+/* Chip parameters are filled in by e_init() after populate_platform(), so
+ * defer allocation until the first access. */
+static int mem_init_backing(void)
+{
+	e_chip_t *chip;
+	int i;
+
+	if (backing.initialized)
+		return E_OK;
+
+	backing.chip      = calloc(e_platform.num_chips, sizeof(*backing.chip));
+	backing.chip_size = calloc(e_platform.num_chips, sizeof(*backing.chip_size));
+	backing.emem      = calloc(e_platform.num_emems, sizeof(*backing.emem));
+	if ((e_platform.num_chips && (!backing.chip || !backing.chip_size)) ||
+		(e_platform.num_emems && !backing.emem))
+		goto err;
+
+	for (i = 0; i < e_platform.num_chips; i++) {
+		chip = &e_platform.chip[i];
+		backing.chip_size[i] =
+			chip->num_cores * (chip->sram_size + chip->regs_size);
+		backing.chip[i] = map_anon(backing.chip_size[i]);
+		if (!backing.chip[i])
+			goto err;
+	}
+
+	for (i = 0; i < e_platform.num_emems; i++) {
+		backing.emem[i] = map_anon(e_platform.emem[i].size);
+		if (!backing.emem[i])
+			goto err;
+	}
+
+	backing.initialized = true;
+
+	return E_OK;
+
+err:
+	warnx("mem target: Failed to allocate backing memory.");
+	mem_release_backing();
+	return E_ERR;
+}
+
+// Translate a global Epiphany address range to a host pointer
+static void *mem_lookup(unsigned long addr, unsigned long size)
+{
+	unsigned  coreid, row, col, core;
+	unsigned long offset;
+	uint8_t  *base;
+	e_chip_t *chip;
+	e_memseg_t *emem;
+	int i;
+
+	if (mem_init_backing() != E_OK)
+		return NULL;
+
+	coreid = addr >> 20;
+	row    = (coreid >> 6) & 0x3f;
+	col    = (coreid >> 0) & 0x3f;
+	offset = addr & 0xfffff;
+
+	for (i = 0; i < e_platform.num_chips; i++) {
+		chip = &e_platform.chip[i];
+		if (row < chip->row || row >= chip->row + chip->rows ||
+			col < chip->col || col >= chip->col + chip->cols)
+			continue;
+
+		core = (row - chip->row) * chip->cols + (col - chip->col);
+		base = backing.chip[i] + core * (chip->sram_size + chip->regs_size);
+
+		if (offset >= chip->sram_base &&
+			offset + size <= chip->sram_base + chip->sram_size)
+			return base + (offset - chip->sram_base);
+
+		if (offset >= chip->regs_base &&
+			offset + size <= chip->regs_base + chip->regs_size)
+			return base + chip->sram_size + (offset - chip->regs_base);
+
+		return NULL;
+	}
+
+	for (i = 0; i < e_platform.num_emems; i++) {
+		emem = &e_platform.emem[i];
+		if (addr >= (unsigned long) emem->ephy_base &&
+			addr + size <= (unsigned long) emem->ephy_base + emem->size)
+			return backing.emem[i] + (addr - emem->ephy_base);
+	}
+
+	return NULL;
+}
+
+// Allocate a buffer in external memory
+static int alloc_mem(e_mem_t *mbuf)
+{
+	mbuf->base = mem_lookup(mbuf->ephy_base, mbuf->emap_size);
+	if (!mbuf->base) {
+		warnx("e_alloc(): Buffer is outside of external memory.");
+		return E_ERR;
+	}
+	mbuf->mapped_base = (uint8_t *) mbuf->base - mbuf->page_offset;
+	mbuf->memfd = -1;
+
+	return E_OK;
+}
+
+// Shared memory regions are carved out of the SHM table mapping
+static int shm_alloc_mem(e_mem_t *mbuf)
+{
+	(void) mbuf;
+
+	return E_OK;
+}
+
+// Free a memory buffer in external memory
+static int free_mem(e_mem_t *mbuf)
+{
+	(void) mbuf;
+
+	return E_OK;
+}
+
+// Read a word from SRAM of a core in a group
+static int ee_read_word_mem(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
+{
+	int data;
+
+	if (((from_addr + sizeof(int)) > dev->core[row][col].mems.map_size) || (from_addr < 0)) {
+		warnx("ee_read_word(): Buffer range is out of bounds.");
+		return E_ERR;
+	}
+
+	memcpy(&data, (uint8_t *) dev->core[row][col].mems.base + from_addr, sizeof(data));
+
+	return data;
+}
+
+// Write a word to SRAM of a core in a group
+static ssize_t ee_write_word_mem(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, int data)
+{
+	if (((to_addr + sizeof(int)) > dev->core[row][col].mems.map_size) || (to_addr < 0)) {
+		warnx("ee_write_word(): Buffer range is out of bounds.");
+		return E_ERR;
+	}
+
+	memcpy((uint8_t *) dev->core[row][col].mems.base + to_addr, &data, sizeof(data));
+
+	return sizeof(int);
+}
+
+// Read a memory block from SRAM of a core in a group
+static ssize_t ee_read_buf_mem(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr, void *buf, size_t size)
+{
+	if (((from_addr + size) > dev->core[row][col].mems.map_size) || (from_addr < 0)) {
+		warnx("ee_read_buf(): Buffer range is out of bounds.");
+		return E_ERR;
+	}
+
+	// Same rule as the native target, so both copy paths get exercised
+	ee_memcpy_from_dev(buf, (uint8_t *) dev->core[row][col].mems.base + from_addr, size,
+					   !((dev->type == E_E64G401) && ((row >= 1) && (row <= 2))));
+
+	return size;
+}
+
+// Write a memory block to SRAM of a core in a group
+static ssize_t ee_write_buf_mem(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, const void *buf, size_t size)
+{
+	if (((to_addr + size) > dev->core[row][col].mems.map_size) || (to_addr < 0)) {
+		warnx("ee_write_buf(): Buffer range is out of bounds.");
+		return E_ERR;
+	}
+
+	ee_memcpy_to_dev((uint8_t *) dev->core[row][col].mems.base + to_addr, buf, size, true);
+
+	return size;
+}
+
+static inline int *mem_reg(e_epiphany_t *dev, unsigned row, unsigned col, off_t addr)
+{
+	return (int *) ((uint8_t *) dev->core[row][col].regs.base + addr);
+}
+
+// Read a core register from a core in a group
+static int ee_read_reg_mem(e_epiphany_t *dev, unsigned row, unsigned col, const off_t from_addr)
+{
+	off_t addr;
+
+	addr = from_addr;
+	if (addr >= E_REG_R0)
+		addr = addr - E_REG_R0;
+
+	if (((addr + sizeof(int)) > dev->core[row][col].regs.map_size) || (addr < 0)) {
+		warnx("ee_read_reg(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	return *mem_reg(dev, row, col, addr);
+}
+
+// Write to a core register of a core in a group
+static ssize_t ee_write_reg_mem(e_epiphany_t *dev, unsigned row, unsigned col, off_t to_addr, int data)
+{
+	if (to_addr >= E_REG_R0)
+		to_addr = to_addr - E_REG_R0;
+
+	if (((to_addr + sizeof(int)) > dev->core[row][col].regs.map_size) || (to_addr < 0)) {
+		warnx("ee_write_reg(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	/* Emulate the side effects e-hal itself depends on: the ILAT set/clear
+	 * aliases and the DEBUGCMD halt bit. Everything else is plain memory. */
+	switch (to_addr + E_REG_R0) {
+	case E_REG_ILATST:
+		*mem_reg(dev, row, col, E_REG_ILAT - E_REG_R0) |= data;
+		break;
+	case E_REG_ILATCL:
+		*mem_reg(dev, row, col, E_REG_ILAT - E_REG_R0) &= ~data;
+		break;
+	case E_REG_DEBUGCMD:
+		*mem_reg(dev, row, col, E_REG_DEBUGSTATUS - E_REG_R0) =
+			(*mem_reg(dev, row, col, E_REG_DEBUGSTATUS - E_REG_R0) & ~1) | (data & 1);
+		/* Fall through */
+	default:
+		*mem_reg(dev, row, col, to_addr) = data;
+	}
+
+	return sizeof(int);
+}
+
+// Read a word from an external memory buffer
+static int ee_mread_word_mem(e_mem_t *mbuf, const off_t from_addr)
+{
+	int data;
+
+	if (((from_addr + sizeof(int)) > mbuf->map_size) || (from_addr < 0)) {
+		warnx("ee_mread_word(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	memcpy(&data, (uint8_t *) mbuf->base + from_addr, sizeof(data));
+
+	return data;
+}
+
+// Write a word to an external memory buffer
+static ssize_t ee_mwrite_word_mem(e_mem_t *mbuf, off_t to_addr, int data)
+{
+	if (((to_addr + sizeof(int)) > mbuf->map_size) || (to_addr < 0)) {
+		warnx("ee_mwrite_word(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	memcpy((uint8_t *) mbuf->base + to_addr, &data, sizeof(data));
+
+	return sizeof(int);
+}
+
+// Read a block from an external memory buffer
+static ssize_t ee_mread_buf_mem(e_mem_t *mbuf, const off_t from_addr, void *buf, size_t size)
+{
+	if (((from_addr + size) > mbuf->map_size) || (from_addr < 0)) {
+		warnx("ee_mread_buf(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	ee_memcpy_from_dev(buf, (uint8_t *) mbuf->base + from_addr, size, true);
+
+	return size;
+}
+
+// Write a block to an external memory buffer
+static ssize_t ee_mwrite_buf_mem(e_mem_t *mbuf, off_t to_addr, const void *buf, size_t size)
+{
+	if (((to_addr + size) > mbuf->map_size) || (to_addr < 0)) {
+		warnx("ee_mwrite_buf(): Address is out of bounds.");
+		return E_ERR;
+	}
+
+	ee_memcpy_to_dev((uint8_t *) mbuf->base + to_addr, buf, size, true);
+
+	return size;
+}
+
+// Reset the Epiphany platform
+static int e_reset_system_mem(void)
+{
+	int i;
+
+	if (mem_init_backing() != E_OK)
+		return E_ERR;
+
+	for (i = 0; i < e_platform.num_chips; i++)
+		memset(backing.chip[i], 0, backing.chip_size[i]);
+
+	return E_OK;
+}
+
+static int ee_init_mem()
+{
+	memset(&backing, 0, sizeof(backing));
+
+	return E_OK;
+}
+
+static void ee_finalize_mem()
+{
+	mem_release_backing();
+}
+
+static int ee_open_mem(e_epiphany_t *dev, unsigned row, unsigned col,
+					   unsigned rows, unsigned cols)
+{
+	(void) row;
+	(void) col;
+	(void) rows;
+	(void) cols;
+
+	dev->memfd = -1;
+
+	return mem_init_backing();
+}
+
+static void *ee_get_raw_pointer_mem(unsigned long addr, unsigned long size)
+{
+	return mem_lookup(addr, size);
+}
+
+extern int _e_default_populate_platform(e_platform_t *platform, char *hdf);
+extern int _e_default_load_group(const char *executable, e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols);
+extern int _e_default_start_group(e_epiphany_t *dev, unsigned row, unsigned col, unsigned rows, unsigned cols);
+extern ssize_t _e_default_read_v(const e_iovec_t * const *iov, unsigned count);
+extern ssize_t _e_default_write_v(const e_iovec_t * const *iov, unsigned count);
+extern ssize_t _e_default_read_regs(e_epiphany_t *dev, unsigned row, unsigned col, off_t from_addr, unsigned *buf, unsigned count);
+
+/* Memory backed target ops */
+const struct e_target_ops mem_target_ops = {
+	.ee_read_word = ee_read_word_mem,
+	.ee_write_word = ee_write_word_mem,
+	.ee_read_buf = ee_read_buf_mem,
+	.ee_write_buf = ee_write_buf_mem,
+	.ee_read_reg = ee_read_reg_mem,
+	.ee_write_reg = ee_write_reg_mem,
+	.ee_mread_word = ee_mread_word_mem,
+	.ee_mwrite_word = ee_mwrite_word_mem,
+	.ee_mread_buf = ee_mread_buf_mem,
+	.ee_mwrite_buf = ee_mwrite_buf_mem,
+	.e_reset_system = e_reset_system_mem,
+	.populate_platform = _e_default_populate_platform,
+	.init = ee_init_mem,
+	.finalize = ee_finalize_mem,
+	.open = ee_open_mem,
+	.load_group = _e_default_load_group,
+	.start_group = _e_default_start_group,
+	.get_raw_pointer = ee_get_raw_pointer_mem,
+	.alloc = alloc_mem,
+	.shm_alloc = shm_alloc_mem,
+	.free = free_mem,
+	.ee_read_v = _e_default_read_v,
+	.ee_write_v = _e_default_write_v,
+	.ee_read_regs = _e_default_read_regs,
+};
@@ -27,26 +27,69 @@
 #define _MEMMAN_H__
 
 #include <stddef.h>
+#include <stdint.h>
+
+/** Allocation granule. Block sizes and default alignment are multiples of this */
+#define MEMMAN_GRAIN	8
+
+/** Heap statistics */
+typedef struct memman_stats {
+	uint64_t size;			/* Bytes managed, excluding the heap header */
+	uint64_t used;			/* Bytes in allocated blocks, including tags */
+	uint64_t free;			/* Bytes in free blocks */
+	uint64_t high_water;	/* Largest value of used so far */
+	uint64_t largest_free;	/* Largest allocation that would succeed now */
+	uint64_t free_blocks;	/* Number of free blocks */
+	uint64_t allocs;		/* Successful allocations */
+	uint64_t frees;			/* Successful frees */
+	uint64_t failed;		/* Failed allocations */
+} memman_stats_t;
 
 /**
  *  Initialize the memory manager
  *
  *  This function initializes the memory manager. The memory managed
- *  begins at the address start and is size bytes long.
+ *  begins at the address start and is size bytes long. All heap state
+ *  lives in the managed memory itself, so several processes can share a
+ *  heap. If format is zero and the memory already holds a heap of the
+ *  same size, that heap is attached to; otherwise a new, empty heap is
+ *  created.
  *
- *  Returns 0 on success, -1 if start address is NULL or size is 0
+ *  Returns 0 on success, -1 if start address is NULL or size is too small
  */
-int memman_init(void *start, size_t size);
+int memman_init(void *start, size_t size, int format);
 
 /**
- * Allocate a block of size bytes of memory.
+ * Allocate a block of size bytes of memory, aligned to MEMMAN_GRAIN.
  */
 void* memman_alloc(size_t size);
 
+/**
+ * Allocate a block of size bytes of memory, aligned to align bytes.
+ * align must be a power of two. Returns NULL on failure.
+ */
+void* memman_alloc_aligned(size_t size, size_t align);
+
 /**
  * Free a block of memory located at address ptr.
  */
 void memman_free(void *ptr);
 
+/**
+ * Get the heap statistics.
+ */
+void memman_get_stats(memman_stats_t *stats);
+
+/**
+ * Rebuild the heap around the blocks that are still in use, e.g. after a
+ * process died while changing it. ptrs holds the n payload addresses in
+ * ascending order and sizes the sizes they were allocated with. All other
+ * memory becomes free. Blocks that are outside the heap or overlap the one
+ * before are dropped, and their ptrs entries set to NULL.
+ *
+ * Returns the number of blocks kept.
+ */
+size_t memman_rebuild(void **ptrs, const size_t *sizes, size_t n);
+
 
 #endif    /*  _MEMMAN_H__*/
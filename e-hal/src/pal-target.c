@@ -164,6 +164,14 @@ static ssize_t pal_write_reg(e_epiphany_t *dev, unsigned row, unsigned col,
 	return pal_write_buf(dev, row, col, to_addr, &data, sizeof(data));
 }
 
+// Read a block of core registers from a core in a group
+static ssize_t pal_read_regs(e_epiphany_t *dev, unsigned row, unsigned col,
+							 off_t from_addr, unsigned *buf, unsigned count)
+{
+	return pal_read_buf(dev, row, col, from_addr, buf,
+						count * sizeof(unsigned));
+}
+
 // Read a block from an external memory buffer
 static ssize_t pal_mread_buf(e_mem_t *mbuf, const off_t from_addr, void *buf,
 							 size_t size)
@@ -439,4 +447,5 @@ const struct e_target_ops pal_target_ops = {
 	.alloc             = pal_alloc,
 	.shm_alloc         = pal_alloc,
 	.free              = pal_free,
+	.ee_read_regs      = pal_read_regs,
 };
@@ -0,0 +1,114 @@
+/*
+  File: e-barrier-bench.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* Device side of the barrier benchmark. Every core times ITERATIONS back to
+ * back barriers of each kind with CTIMER0 counting E_CTIMER_CLK and posts
+ * the mean cycles per barrier to the "e_barrier_bench" shared memory region
+ * allocated by e-utils/e-barrier-bench. Runs on hardware and on the
+ * simulator. */
+
+#include <e_lib.h>
+
+#define ITERATIONS 1000
+
+enum { BAR_FLIPFLOP, BAR_TREE, BAR_DISS, BAR_HW, BAR_KINDS };
+
+typedef struct {
+	unsigned done;
+	unsigned iterations;
+	unsigned cycles[BAR_KINDS];
+} bench_result_t;
+
+volatile e_barrier_t  bar_array[E_BARRIER_MAX_DIM];
+volatile e_barrier_t *tgt_bar_array[E_BARRIER_MAX_DIM];
+e_barrier_tree_t	  tree;
+e_barrier_diss_t	  diss;
+e_barrier_hw_t		  hw;
+
+static void barrier(int kind)
+{
+	switch (kind)
+	{
+	case BAR_FLIPFLOP:
+		e_barrier(bar_array, tgt_bar_array);
+		break;
+	case BAR_TREE:
+		e_barrier_tree(&tree);
+		break;
+	case BAR_DISS:
+		e_barrier_diss(&diss);
+		break;
+	case BAR_HW:
+		e_barrier_hw(&hw);
+		break;
+	}
+}
+
+static unsigned time_barrier(int kind)
+{
+	unsigned i, left;
+
+	// line everybody up and warm up
+	e_barrier(bar_array, tgt_bar_array);
+	barrier(kind);
+
+	e_ctimer_set(E_CTIMER_0, E_CTIMER_MAX);
+	e_ctimer_start(E_CTIMER_0, E_CTIMER_CLK);
+	for (i=0; i<ITERATIONS; i++)
+		barrier(kind);
+	left = e_ctimer_stop(E_CTIMER_0);
+
+	return (E_CTIMER_MAX - left) / ITERATIONS;
+}
+
+int main(void)
+{
+	e_memseg_t	   shm;
+	bench_result_t res;
+	unsigned	   corenum, done = 1;
+	int			   kind;
+
+	corenum = e_group_config.core_row * e_group_config.group_cols + e_group_config.core_col;
+
+	if (e_shm_attach(&shm, "e_barrier_bench") != E_OK)
+		return 1;
+
+	e_barrier_init(bar_array, tgt_bar_array);
+	e_barrier_tree_init(&tree);
+	e_barrier_diss_init(&diss);
+	e_barrier_hw_init(&hw);
+
+	for (kind=0; kind<BAR_KINDS; kind++)
+		res.cycles[kind] = time_barrier(kind);
+	res.iterations = ITERATIONS;
+
+	// publish the results before the done flag
+	e_write(&shm, &res.iterations, 0, 0,
+			(void *) (corenum * sizeof(res) + sizeof(res.done)),
+			sizeof(res) - sizeof(res.done));
+	e_write(&shm, &done, 0, 0, (void *) (corenum * sizeof(res)), sizeof(done));
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+  File: e_chan.h
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.	 If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _E_CHAN_H_
+#define _E_CHAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "e_common.h"
+#include "e_mem.h"
+
+#define E_CHAN_MAGIC				   0x6e616863	/* "chan" */
+#define E_CHAN_LINE					   64			/* Index spacing */
+
+/*
+** Type definitions
+*/
+#pragma pack(push, 1)
+
+/**
+ * Single producer, single consumer channel header, at the start of the
+ * channel's shared memory region and followed by depth slots of
+ * slot_size bytes. head and tail are free running counts of slots
+ * committed and consumed, each on its own line so the producer and
+ * consumer never write to the same one.
+ *
+ * NOTE: Must match e_chan_hdr_t in the e-hal.
+ */
+typedef struct ALIGN(8) e_chan_hdr {
+	uint32_t	magic;
+	uint32_t	slot_size;	  /* Bytes per slot, a multiple of 8 */
+	uint32_t	depth;		  /* Number of slots, a power of two */
+	uint32_t	__pad0[E_CHAN_LINE / 4 - 3];
+	uint32_t	head;		  /* Written by the producer only */
+	uint32_t	__pad1[E_CHAN_LINE / 4 - 1];
+	uint32_t	tail;		  /* Written by the consumer only */
+	uint32_t	__pad2[E_CHAN_LINE / 4 - 1];
+} e_chan_hdr_t;
+
+#pragma pack(pop)
+
+/** Core end of a channel, best kept in core local memory. The producer
+ *  and consumer each need their own. */
+typedef struct {
+	e_chan_hdr_t  *hdr;			  // shared header in external memory
+	uint8_t		  *slots;		  // first slot
+	unsigned	   slot_size;	  // bytes per slot
+	unsigned	   depth;		  // number of slots
+	uint32_t	   head;		  // producer: next head, consumer: last head seen
+	uint32_t	   tail;		  // consumer: next tail, producer: last tail seen
+} e_chan_t;
+
+/** Attach to a channel created by the host with e_chan_create() */
+int e_chan_attach(e_chan_t *chan, const char *name);
+
+/** Reserve up to n contiguous slots for writing, return how many */
+unsigned e_chan_reserve(e_chan_t *chan, void **slots, unsigned n);
+
+/** Publish the first n reserved slots */
+void e_chan_commit(e_chan_t *chan, unsigned n);
+
+/** Get up to n contiguous filled slots for reading, return how many */
+unsigned e_chan_peek(e_chan_t *chan, void **slots, unsigned n);
+
+/** Hand the first n peeked slots back to the producer */
+void e_chan_consume(e_chan_t *chan, unsigned n);
+
+/** Copy size bytes into the next slot and commit it, spinning until
+ *  a slot is free. Returns E_ERR if size is larger than a slot. */
+int e_chan_send(e_chan_t *chan, const void *buf, size_t size);
+
+/** Copy up to size bytes of the next slot out and consume it, spinning
+ *  until a slot is filled */
+int e_chan_recv(e_chan_t *chan, void *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	  /* _E_CHAN_H_ */
@@ -32,6 +32,7 @@ extern "C" {
 
 #include <stddef.h>
 #include "e_common.h"
+#include "e_types.h"
 
 /*
   These defs can be or'd together to form a value suitable for
@@ -71,11 +72,43 @@ typedef struct
 	void    *dst_addr;
 } ALIGN(8) e_dma_desc_t;
 
+/* Asynchronous copies are queued per channel, in a pool of E_DMA_POOL_SIZE
+ * descriptors, and run one after the other on that channel. A copy is complete when
+ * e_dma_test() returns 1 for its handle. The queue moves on whenever
+ * e_dma_test() or e_dma_wait_handle() is called, or, once e_dma_async_irq()
+ * has enabled it, from the channel's DMA interrupt. Do not start descriptors
+ * of your own on a channel that has asynchronous copies queued. */
+#define E_DMA_POOL_SIZE 8
+
+typedef struct
+{
+	e_dma_id_t chan;
+	unsigned   seq;        // last descriptor of the copy on its channel
+} e_dma_handle_t;
+
 
 int  e_dma_start(e_dma_desc_t *descriptor, e_dma_id_t chan);
 int  e_dma_busy(e_dma_id_t chan);
 void e_dma_wait(e_dma_id_t chan);
 int  e_dma_copy(void *dst, void *src, size_t n);
+e_dma_handle_t e_dma_copy_async(void *dst, void *src, size_t n, e_dma_id_t chan);
+int  e_dma_test(e_dma_handle_t handle);
+int  e_dma_wait_handle(e_dma_handle_t handle);
+int  e_dma_async_irq(e_dma_id_t chan, e_bool_t enable);
+
+/* Asynchronous strided copies. e_dma_copy_2d() copies rows of width bytes
+ * whose starts are dst_pitch and src_pitch bytes apart. e_dma_gather() packs
+ * count blocks of n bytes from src[] one after the other into dst, and
+ * e_dma_scatter() does the reverse. The descriptors use the widest element
+ * size the addresses, pitches and sizes allow, and large or awkward shapes
+ * are split over chained descriptors. */
+e_dma_handle_t e_dma_copy_2d(void *dst, unsigned dst_pitch,
+		void *src, unsigned src_pitch,
+		size_t width, unsigned rows, e_dma_id_t chan);
+e_dma_handle_t e_dma_gather(void *dst, void *const src[], size_t n,
+		unsigned count, e_dma_id_t chan);
+e_dma_handle_t e_dma_scatter(void *const dst[], void *src, size_t n,
+		unsigned count, e_dma_id_t chan);
 void e_dma_set_desc(e_dma_id_t chan,
 		unsigned config,     e_dma_desc_t *next_desc,
 		unsigned strd_i_src, unsigned strd_i_dst,
@@ -36,6 +36,7 @@
 #include "e_mutex.h"
 #include "e_coreid.h"
 #include "e_shm.h"
+#include "e_chan.h"
 
 #endif /* __ELIB_H__ */
 
@@ -50,6 +50,121 @@ void e_mutex_unlock(unsigned row, unsigned col, e_mutex_t *mutex);
 void e_barrier_init(volatile e_barrier_t bar_array[], volatile e_barrier_t *tgt_bar_array[]);
 void e_barrier(volatile e_barrier_t *bar_array, volatile e_barrier_t *tgt_bar_array[]);
 
+/* Contention aware locks. Like e_mutex_t, a lock object must be a statically
+ * zero-initialized global, so it sits at the same address on all cores of
+ * the group. The copy on the owner core (row, col) is the lock itself; each
+ * core keeps its own bookkeeping and counters in its local copy, which its
+ * init function sets up. Init never touches the owner's copy, so cores may
+ * lock while others are still initializing. */
+
+//-- failed attempts wait E_MUTEX_BACKOFF_MIN loops, doubling up to MAX
+#define E_MUTEX_BACKOFF_MIN 8
+#define E_MUTEX_BACKOFF_MAX 1024
+//-- maximum number of cores queueing on a ticket lock
+#define E_MUTEX_MAX_CORES   64
+
+/* Per core lock counters. Use e_mutex_stats() to sum them over the group. */
+typedef struct {
+	unsigned acquires;   // locks taken
+	unsigned contended;  // locks that were not free at the first attempt
+	unsigned retries;    // failed testset attempts
+	unsigned timeouts;   // trylocks that gave up
+} e_mutex_stats_t;
+
+/* Test-and-set lock on the owner's word with bounded exponential backoff
+ * between attempts, so waiters do not flood the mesh with testsets. */
+typedef struct {
+	e_mutex_t        lock;     // the testset word, used on the owner only
+	e_mutex_t       *glock;    // global address of the owner's word
+	unsigned         coreid;
+	e_mutex_stats_t  stats;
+} e_mutex_backoff_t;
+
+/* Fair FIFO lock. Cores take tickets under a short backoff guarded section
+ * at the owner and wait for the previous holder to write their ticket to
+ * the grant word of their own copy, so waiters only spin on local memory. */
+typedef struct e_mutex_ticket_s {
+	e_mutex_t                 guard;   // protects tail, head and queue
+	volatile unsigned         tail;    // next ticket to hand out
+	volatile unsigned         head;    // ticket holding the lock
+	volatile unsigned         grant;   // written by the previous holder
+	unsigned                  ticket;  // our ticket while we hold the lock
+	struct e_mutex_ticket_s  *owner;   // global address of the owner's copy
+	unsigned                  coreid;
+	e_mutex_stats_t           stats;
+	volatile unsigned short   queue[E_MUTEX_MAX_CORES]; // waiting coreids by ticket
+} e_mutex_ticket_t;
+
+unsigned e_mutex_backoff(unsigned delay);
+void e_mutex_backoff_init(unsigned row, unsigned col, e_mutex_backoff_t *mutex);
+void e_mutex_backoff_lock(e_mutex_backoff_t *mutex);
+unsigned e_mutex_backoff_trylock(e_mutex_backoff_t *mutex, unsigned tries);
+void e_mutex_backoff_unlock(e_mutex_backoff_t *mutex);
+void e_mutex_ticket_init(unsigned row, unsigned col, e_mutex_ticket_t *mutex);
+void e_mutex_ticket_lock(e_mutex_ticket_t *mutex);
+void e_mutex_ticket_unlock(e_mutex_ticket_t *mutex);
+void e_mutex_stats(const e_mutex_stats_t *stats, e_mutex_stats_t *sum);
+
+/* Scalable barriers. Like e_barrier_t arrays, a barrier object must be a
+ * statically zero-initialized global, so it sits at the same address on all
+ * cores of the group, and each core must call the init function once before
+ * its first wait. Neither init clears state written by other cores, so cores
+ * may enter the first barrier while others are still initializing. */
+
+//-- maximum group dimension and number of dissemination rounds
+#define E_BARRIER_MAX_DIM    64
+#define E_BARRIER_MAX_ROUNDS 12
+//-- maximum number of cores on a chip
+#define E_BARRIER_CHIP_CORES 64
+
+/* Combining tree along the mesh: cores report to the first core of their
+ * row, those report to core (0,0), and the release goes back down the same
+ * way. Every core only polls its own memory. */
+typedef struct {
+	volatile unsigned char  arrive[2 * E_BARRIER_MAX_DIM]; // written by children
+	volatile unsigned char  release;   // written by the parent
+	unsigned char           epoch;     // number of barriers passed
+	volatile unsigned char *parent;    // our arrive slot at the parent
+	volatile unsigned char *release0;  // release of the first core of our row
+} e_barrier_tree_t;
+
+/* Dissemination barrier: in round k every core signals the core 2^k ahead of
+ * it in row-major order and waits for the one 2^k behind it, for
+ * ceil(log2(cores)) rounds. */
+typedef struct {
+	volatile unsigned char  flag[E_BARRIER_MAX_ROUNDS];  // written by peers
+	unsigned char           epoch;     // number of barriers passed
+	unsigned char           rounds;    // ceil(log2(cores))
+	volatile unsigned char *peer[E_BARRIER_MAX_ROUNDS];  // flags we write
+} e_barrier_diss_t;
+
+void e_barrier_tree_init(e_barrier_tree_t *bar);
+void e_barrier_tree(e_barrier_tree_t *bar);
+void e_barrier_diss_init(e_barrier_diss_t *bar);
+void e_barrier_diss(e_barrier_diss_t *bar);
+
+/* Hardware barrier on the chip wide WAND line. Each core sets its WAND bit
+ * and waits for the WAND interrupt, which is raised on all cores of a chip
+ * once every one of them has set its bit. Init installs the WAND ISR,
+ * unmasks it and enables interrupts. WAND covers a whole chip, so when the
+ * group is anything else the combining tree barrier is used instead.
+ * A core that set its bit again while another had yet to clear it from the
+ * previous barrier would complete the line early, so cores report to core
+ * (0,0) once they have cleared their bit, and core (0,0) lets them set it
+ * again when all have. */
+typedef struct {
+	e_barrier_tree_t        sw;      // fallback when the group is not a whole chip
+	unsigned char           hw;      // group is a whole chip
+	unsigned char           epoch;   // number of barriers passed
+	volatile unsigned char  armed;   // written by core (0,0)
+	volatile unsigned char  cleared[E_BARRIER_CHIP_CORES]; // written by the other cores
+	volatile unsigned char *report;  // our cleared slot at core (0,0)
+	volatile unsigned char *armed0;  // armed of core (0,0)
+} e_barrier_hw_t;
+
+void e_barrier_hw_init(e_barrier_hw_t *bar);
+void e_barrier_hw(e_barrier_hw_t *bar);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,14 +30,20 @@
 extern "C" {
 #endif
 
-#define MAX_SHM_REGIONS				   64
-
 #include <stdint.h>
 #include <sys/types.h>
 #include "e_common.h"
 #include "e_mem.h"
 
-#define MAX_SHM_REGIONS				   64
+#define MAX_SHM_REGIONS				   256
+
+/* Layout version of e_shmtable_t, bumped whenever it changes */
+#define SHM_VERSION					   4
+
+/* Size of the region name index, a power of two */
+#define SHM_INDEX_SIZE				   512
+#define SHM_INDEX_EMPTY				   0
+#define SHM_INDEX_DELETED			   0xffffffff
 
 /*
 ** Type definitions
@@ -73,9 +79,48 @@ typedef struct ALIGN(8) e_shmseg_pvt	{
 	uint32_t	valid;	  /* 1 if the region is in use, 0 otherwise */
 } e_shmseg_pvt_t;
 
+/** Shared memory heap statistics, in bytes unless noted */
+typedef struct ALIGN(8) e_shm_stats {
+	uint64_t	size;		   /* Heap size */
+	uint64_t	used;		   /* Bytes in allocated blocks */
+	uint64_t	free;		   /* Bytes in free blocks */
+	uint64_t	high_water;	   /* Highest value of used */
+	uint64_t	largest_free;  /* Largest allocation that would succeed */
+	uint64_t	free_blocks;   /* Number of free blocks */
+	uint64_t	allocs;		   /* Successful allocations */
+	uint64_t	frees;		   /* Blocks freed */
+	uint64_t	failed;		   /* Failed allocations */
+	uint64_t	fragmentation; /* Percentage of free space not in the largest block */
+} e_shm_stats_t;
+
+/**
+ * Region name index entry. Entries are found by open addressing with
+ * linear probing from e_shm_hash(name) & (SHM_INDEX_SIZE - 1). slot is
+ * SHM_INDEX_EMPTY, SHM_INDEX_DELETED or the region number plus one.
+ */
+typedef struct ALIGN(8) e_shm_index {
+	uint32_t	hash;		  /* Hash of the region name */
+	uint32_t	slot;		  /* Region number + 1 */
+} e_shm_index_t;
+
+/** SHM table writer lock statistics, times in nanoseconds */
+typedef struct ALIGN(8) e_shm_lock_stats {
+	uint64_t	acquired;	   /* Writer lock acquisitions */
+	uint64_t	contended;	   /* Acquisitions that had to wait */
+	uint64_t	wait_ns;	   /* Total time spent waiting */
+	uint64_t	max_wait_ns;   /* Longest wait */
+	uint64_t	hold_ns;	   /* Total time held */
+	uint64_t	max_hold_ns;   /* Longest hold */
+	uint64_t	owner_died;	   /* Recoveries from a holder that died */
+	uint64_t	read_retries;  /* Lock-free lookups that had to retry */
+} e_shm_lock_stats_t;
+
 typedef struct ALIGN(8) e_shmtable {
 	uint32_t		magic;
 	uint32_t		initialized;
+	uint32_t		version;	/* SHM_VERSION */
+	uint32_t		index_deleted;	/* Number of deleted index entries */
+	e_shm_index_t	index[SHM_INDEX_SIZE];
 	e_shmseg_pvt_t	regions[MAX_SHM_REGIONS];
 	uint64_t		free_space;
 	uint64_t		next_free_offset;
@@ -89,10 +134,32 @@ typedef struct ALIGN(8) e_shmtable {
 		void		*lock;		/* User-space semaphore (sem_t* on e-hal side) */
 		uint64_t	__fill2;
 	};
+	e_shm_stats_t	heap_stats;	/* Heap statistics, updated on every alloc and free */
+	uint32_t		seq;		/* Odd while a writer is updating regions */
+	uint32_t		writer;		/* Pid of the writer lock holder, 0 if none */
+	e_shm_lock_stats_t lock_stats;
 } e_shmtable_t;
 
 #pragma pack(pop)
 
+/**
+ * Hash of a region name for the name index (32-bit FNV-1a over at most
+ * the stored name length). The FNV prime multiply is spelled out as
+ * shifts, which is cheaper on the Epiphany than a library multiply.
+ */
+static inline uint32_t e_shm_hash(const char *name)
+{
+	uint32_t h = 2166136261u;
+	unsigned i;
+
+	for (i = 0; i < sizeof(((e_shmseg_t *) 0)->name) && name[i]; i++) {
+		h ^= (uint8_t) name[i];
+		h += (h << 1) + (h << 4) + (h << 7) + (h << 8) + (h << 24);
+	}
+
+	return h;
+}
+
 /** Attach to a shared region identifiable by name */
 int e_shm_attach(e_memseg_t *mem, const char* name);
 
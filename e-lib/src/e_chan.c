@@ -0,0 +1,151 @@
+/*
+  File: e_chan.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.	 If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "e_types.h"
+#include "e_shm.h"
+#include "e_chan.h"
+
+/*
+ * The header lives in external memory, where every read is a round trip
+ * through the mesh. Each end therefore keeps its own counter locally and
+ * only re-reads the other end's when its cached copy says the ring is
+ * full (or empty).
+ *
+ * Writes from a core to external memory arrive in order, so the slot
+ * data is visible to the host before the head that publishes it.
+ */
+
+static inline uint32_t chan_load(const uint32_t *p)
+{
+	return *(volatile const uint32_t *) p;
+}
+
+static inline void chan_store(uint32_t *p, uint32_t v)
+{
+	*(volatile uint32_t *) p = v;
+}
+
+int e_chan_attach(e_chan_t *chan, const char *name)
+{
+	e_memseg_t	  mem;
+	e_chan_hdr_t *hdr;
+
+	if ( !chan || E_OK != e_shm_attach(&mem, name) )
+		return E_ERR;
+
+	hdr = (e_chan_hdr_t *) mem.ephy_base;
+	if ( E_CHAN_MAGIC != chan_load(&hdr->magic) )
+		return E_ERR;
+
+	chan->hdr		= hdr;
+	chan->slots		= (uint8_t *) hdr + sizeof(*hdr);
+	chan->slot_size = hdr->slot_size;
+	chan->depth		= hdr->depth;
+	chan->head		= chan_load(&hdr->head);
+	chan->tail		= chan_load(&hdr->tail);
+
+	return E_OK;
+}
+
+unsigned e_chan_reserve(e_chan_t *chan, void **slots, unsigned n)
+{
+	unsigned idx = chan->head & (chan->depth - 1);
+	unsigned avail = chan->depth - (chan->head - chan->tail);
+
+	if ( avail < n ) {
+		chan->tail = chan_load(&chan->hdr->tail);
+		avail = chan->depth - (chan->head - chan->tail);
+	}
+
+	/* Reserved slots must not wrap */
+	if ( avail > chan->depth - idx )
+		avail = chan->depth - idx;
+	if ( n > avail )
+		n = avail;
+
+	*slots = chan->slots + idx * chan->slot_size;
+	return n;
+}
+
+void e_chan_commit(e_chan_t *chan, unsigned n)
+{
+	chan->head += n;
+	chan_store(&chan->hdr->head, chan->head);
+}
+
+unsigned e_chan_peek(e_chan_t *chan, void **slots, unsigned n)
+{
+	unsigned idx = chan->tail & (chan->depth - 1);
+	unsigned avail = chan->head - chan->tail;
+
+	if ( avail < n ) {
+		chan->head = chan_load(&chan->hdr->head);
+		avail = chan->head - chan->tail;
+	}
+
+	if ( avail > chan->depth - idx )
+		avail = chan->depth - idx;
+	if ( n > avail )
+		n = avail;
+
+	*slots = chan->slots + idx * chan->slot_size;
+	return n;
+}
+
+void e_chan_consume(e_chan_t *chan, unsigned n)
+{
+	chan->tail += n;
+	chan_store(&chan->hdr->tail, chan->tail);
+}
+
+int e_chan_send(e_chan_t *chan, const void *buf, size_t size)
+{
+	void *slot;
+
+	if ( size > chan->slot_size )
+		return E_ERR;
+
+	while ( !e_chan_reserve(chan, &slot, 1) )
+		;
+
+	memcpy(slot, buf, size);
+	e_chan_commit(chan, 1);
+
+	return E_OK;
+}
+
+int e_chan_recv(e_chan_t *chan, void *buf, size_t size)
+{
+	void *slot;
+
+	while ( !e_chan_peek(chan, &slot, 1) )
+		;
+
+	memcpy(buf, slot, size < chan->slot_size ? size : chan->slot_size);
+	e_chan_consume(chan, 1);
+
+	return E_OK;
+}
@@ -0,0 +1,409 @@
+/*
+  File: e_dma_async.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "e_common.h"
+#include "e_regs.h"
+#include "e_types.h"
+#include "e_ic.h"
+#include "e_dma.h"
+
+
+#define local_mask (0xfff00000)
+#define count_max  (0xffff)     // inner and outer counts are 16 bit fields
+#define STATUS_GID (1 << 1)     // interrupts globally disabled
+
+extern unsigned dma_data_size[8];
+
+/* Queue positions count descriptors. A queued transfer is a chain of
+ * consecutive pool slots that is started as one, and is done once the
+ * done count has passed its last slot. */
+typedef struct
+{
+	volatile unsigned issued;   // descriptors queued
+	volatile unsigned started;  // descriptors handed to the engine
+	volatile unsigned done;     // descriptors completed
+	unsigned          irq;      // new transfers raise the DMA interrupt
+} dma_queue_t;
+
+// Descriptor number seq of a channel uses slot seq % E_DMA_POOL_SIZE
+static e_dma_desc_t  dma_pool[2][E_DMA_POOL_SIZE] SECTION(".data_bank0");
+static unsigned char dma_chain_len[2][E_DMA_POOL_SIZE];
+static dma_queue_t   dma_queue[2];
+
+// A transfer being put together
+typedef struct
+{
+	e_dma_id_t    chan;
+	dma_queue_t  *q;
+	unsigned      len;          // descriptors in the chain so far
+	e_dma_desc_t *last;
+	unsigned      gid;
+} dma_chain_t;
+
+
+/* The queues are also worked on from ISRs, so keep interrupts off while
+ * touching them */
+static unsigned irq_save(void)
+{
+	unsigned status;
+
+	status = e_reg_read(E_REG_STATUS);
+	e_irq_global_mask(E_TRUE);
+
+	return status & STATUS_GID;
+}
+
+
+static void irq_restore(unsigned gid)
+{
+	if (!gid)
+		e_irq_global_mask(E_FALSE);
+}
+
+
+// Retire the running chain if the engine is done with it and start the next
+static void dma_progress(e_dma_id_t chan)
+{
+	dma_queue_t *q;
+	unsigned     slot;
+
+	q = &dma_queue[chan];
+
+	if (q->started != q->done && !e_dma_busy(chan))
+		q->done = q->started;
+
+	if (q->started == q->done && q->issued != q->started)
+	{
+		slot = q->started % E_DMA_POOL_SIZE;
+		e_dma_start(&dma_pool[chan][slot], chan);
+		q->started += dma_chain_len[chan][slot];
+	}
+
+	return;
+}
+
+
+static void __attribute__((interrupt)) dma0_isr()
+{
+	unsigned gid;
+
+	gid = irq_save();
+	dma_progress(E_DMA_0);
+	irq_restore(gid);
+}
+
+
+static void __attribute__((interrupt)) dma1_isr()
+{
+	unsigned gid;
+
+	gid = irq_save();
+	dma_progress(E_DMA_1);
+	irq_restore(gid);
+}
+
+
+static void chain_begin(dma_chain_t *c, e_dma_id_t chan)
+{
+	c->chan = chan;
+	c->q    = &dma_queue[chan];
+	c->len  = 0;
+	c->last = 0;
+	c->gid  = irq_save();
+}
+
+
+// Queue the chain built so far
+static void chain_queue(dma_chain_t *c)
+{
+	if (c->len == 0)
+		return;
+
+	if (c->q->irq)
+		c->last->config |= E_DMA_IRQEN;
+
+	dma_chain_len[c->chan][c->q->issued % E_DMA_POOL_SIZE] = c->len;
+	c->q->issued += c->len;
+	c->len = 0;
+
+	dma_progress(c->chan);
+}
+
+
+// Take the next pool slot and link it to the end of the chain
+static e_dma_desc_t *chain_add(dma_chain_t *c)
+{
+	e_dma_desc_t *desc;
+
+	// a chain longer than the pool goes out in pieces
+	if (c->len == E_DMA_POOL_SIZE)
+		chain_queue(c);
+
+	/* Wait for a free slot with interrupts back on, so the DMA and other
+	 * ISRs are served meanwhile. The chain so far is queued first, so an
+	 * ISR that queues copies of its own can't take its slots. */
+	if (c->q->issued + c->len - c->q->done == E_DMA_POOL_SIZE)
+	{
+		chain_queue(c);
+		while (c->q->issued - c->q->done == E_DMA_POOL_SIZE)
+		{
+			irq_restore(c->gid);
+			irq_save();
+			dma_progress(c->chan);
+		}
+	}
+
+	desc = &dma_pool[c->chan][(c->q->issued + c->len) % E_DMA_POOL_SIZE];
+	if (c->len)
+		c->last->config |= (((unsigned) desc) << 16) | E_DMA_CHAIN;
+
+	c->len++;
+	c->last = desc;
+
+	return desc;
+}
+
+
+// Queue what is left and return the handle of the last descriptor
+static e_dma_handle_t chain_end(dma_chain_t *c)
+{
+	e_dma_handle_t handle;
+
+	chain_queue(c);
+
+	handle.chan = c->chan;
+	handle.seq  = c->q->issued - 1;
+
+	irq_restore(c->gid);
+
+	return handle;
+}
+
+
+static int fits_stride(int stride)
+{
+	return (stride >= -0x8000) && (stride <= 0x7fff);
+}
+
+
+/* Add rows of width bytes. The element size is the widest that all the
+ * addresses, pitches and the width are aligned to. Rows wider than the
+ * inner count are split into bands of columns, and rows go into one
+ * descriptor as long as the outer count and outer strides fit. The outer
+ * stride is applied in place of the inner stride after the last element of
+ * a row. */
+static void chain_2d(dma_chain_t *c, void *dst, unsigned dst_pitch,
+		void *src, unsigned src_pitch, size_t width, unsigned rows)
+{
+	e_dma_desc_t *desc;
+	unsigned      index;
+	unsigned      shift;
+	unsigned      size;
+	unsigned      config;
+	unsigned      elems, col, band;
+	unsigned      row, block, max_rows;
+	int           strd_o_src, strd_o_dst;
+	char         *s, *d;
+
+	index = (((unsigned) dst) | ((unsigned) src) | ((unsigned) width) |
+			dst_pitch | src_pitch) & 7;
+
+	config = E_DMA_MASTER | E_DMA_ENABLE | dma_data_size[index];
+	shift  = dma_data_size[index] >> 5;
+	size   = 1 << shift;
+	elems  = width >> shift;
+
+	for (col = 0; col < elems; col += band)
+	{
+		band = elems - col;
+		if (band > count_max)
+			band = count_max;
+
+		strd_o_src = (int) src_pitch - (int) ((band - 1) << shift);
+		strd_o_dst = (int) dst_pitch - (int) ((band - 1) << shift);
+		if (fits_stride(strd_o_src) && fits_stride(strd_o_dst))
+			max_rows = count_max;
+		else
+			max_rows = 1;
+
+		for (row = 0; row < rows; row += block)
+		{
+			block = rows - row;
+			if (block > max_rows)
+				block = max_rows;
+
+			s = (char *) src + row * src_pitch + (col << shift);
+			d = (char *) dst + row * dst_pitch + (col << shift);
+
+			desc = chain_add(c);
+			desc->config = config;
+			if ((((unsigned) d) & local_mask) == 0)
+				desc->config = desc->config | E_DMA_MSGMODE;
+			desc->inner_stride = (size << 16) | size;
+			desc->count        = (block << 16) | band;
+			desc->outer_stride = (((unsigned) strd_o_dst & 0xffff) << 16) |
+					((unsigned) strd_o_src & 0xffff);
+			desc->src_addr     = s;
+			desc->dst_addr     = d;
+		}
+	}
+
+	return;
+}
+
+
+e_dma_handle_t e_dma_copy_async(void *dst, void *src, size_t n, e_dma_id_t chan)
+{
+	dma_chain_t    c;
+	e_dma_handle_t handle;
+
+	// e_dma_test() rejects the handle
+	handle.chan = chan;
+	handle.seq  = 0;
+	if ((chan | 1) != 1)
+		return handle;
+
+	chain_begin(&c, chan);
+	chain_2d(&c, dst, n, src, n, n, 1);
+
+	return chain_end(&c);
+}
+
+
+e_dma_handle_t e_dma_copy_2d(void *dst, unsigned dst_pitch,
+		void *src, unsigned src_pitch,
+		size_t width, unsigned rows, e_dma_id_t chan)
+{
+	dma_chain_t    c;
+	e_dma_handle_t handle;
+
+	handle.chan = chan;
+	handle.seq  = 0;
+	if ((chan | 1) != 1)
+		return handle;
+
+	chain_begin(&c, chan);
+	chain_2d(&c, dst, dst_pitch, src, src_pitch, width, rows);
+
+	return chain_end(&c);
+}
+
+
+e_dma_handle_t e_dma_gather(void *dst, void *const src[], size_t n,
+		unsigned count, e_dma_id_t chan)
+{
+	dma_chain_t    c;
+	e_dma_handle_t handle;
+	unsigned       i;
+
+	handle.chan = chan;
+	handle.seq  = 0;
+	if ((chan | 1) != 1)
+		return handle;
+
+	chain_begin(&c, chan);
+	for (i = 0; i < count; i++)
+		chain_2d(&c, (char *) dst + i * n, n, src[i], n, n, 1);
+
+	return chain_end(&c);
+}
+
+
+e_dma_handle_t e_dma_scatter(void *const dst[], void *src, size_t n,
+		unsigned count, e_dma_id_t chan)
+{
+	dma_chain_t    c;
+	e_dma_handle_t handle;
+	unsigned       i;
+
+	handle.chan = chan;
+	handle.seq  = 0;
+	if ((chan | 1) != 1)
+		return handle;
+
+	chain_begin(&c, chan);
+	for (i = 0; i < count; i++)
+		chain_2d(&c, dst[i], n, (char *) src + i * n, n, n, 1);
+
+	return chain_end(&c);
+}
+
+
+int e_dma_test(e_dma_handle_t handle)
+{
+	dma_queue_t *q;
+	unsigned     gid;
+	int          done;
+
+	if ((handle.chan | 1) != 1)
+		return E_ERR;
+
+	q = &dma_queue[handle.chan];
+
+	gid = irq_save();
+	dma_progress(handle.chan);
+	done = ((int) (q->done - handle.seq) > 0);
+	irq_restore(gid);
+
+	return done;
+}
+
+
+int e_dma_wait_handle(e_dma_handle_t handle)
+{
+	int done;
+
+	while ((done = e_dma_test(handle)) == 0) {};
+
+	return (done == E_ERR) ? E_ERR : E_OK;
+}
+
+
+int e_dma_async_irq(e_dma_id_t chan, e_bool_t enable)
+{
+	e_irq_type_t irq;
+
+	if ((chan | 1) != 1)
+		return E_ERR;
+
+	irq = (chan == E_DMA_0) ? E_DMA0_INT : E_DMA1_INT;
+
+	// Copies already queued keep the mode they were queued with
+	dma_queue[chan].irq = enable;
+
+	if (enable)
+	{
+		if (chan == E_DMA_0)
+			e_irq_attach(irq, dma0_isr);
+		else
+			e_irq_attach(irq, dma1_isr);
+		e_irq_mask(irq, E_FALSE);
+		e_irq_global_mask(E_FALSE);
+	} else {
+		e_irq_mask(irq, E_TRUE);
+	}
+
+	return E_OK;
+}
@@ -27,8 +27,6 @@
 #include "e_dma.h"
 
 
-e_dma_desc_t _dma_copy_descriptor_ SECTION(".data_bank0");
-
 unsigned dma_data_size[8] =
 {
 	E_DMA_DWORD,
@@ -41,40 +39,14 @@ unsigned dma_data_size[8] =
 	E_DMA_BYTE,
 };
 
-#define local_mask (0xfff00000)
-
 
 int e_dma_copy(void *dst, void *src, size_t n)
 {
-	e_dma_id_t chan;
-	unsigned   index;
-	unsigned   shift;
-	unsigned   stride;
-	unsigned   config;
-	int        ret_val;
-
-	chan  = E_DMA_1;
-
-	index = (((unsigned) dst) | ((unsigned) src) | ((unsigned) n)) & 7;
+	e_dma_handle_t handle;
 
-	config = E_DMA_MASTER | E_DMA_ENABLE | dma_data_size[index];
-	if ((((unsigned) dst) & local_mask) == 0)
-		config = config | E_DMA_MSGMODE;
-	shift = dma_data_size[index] >> 5;
-	stride = 0x10001 << shift;
+	/* A queued copy on E_DMA_1, so this does not clobber copies that are
+	 * still running from ISRs or e_dma_copy_async() */
+	handle = e_dma_copy_async(dst, src, n, E_DMA_1);
 
-	// TODO: add e_dma_wait()!!!
-	_dma_copy_descriptor_.config       = config;
-	_dma_copy_descriptor_.inner_stride = stride;
-	_dma_copy_descriptor_.count        = 0x10000 | (n >> shift);
-	_dma_copy_descriptor_.outer_stride = stride;
-	_dma_copy_descriptor_.src_addr     = src;
-	_dma_copy_descriptor_.dst_addr     = dst;
-
-	ret_val = e_dma_start(&_dma_copy_descriptor_, chan);
-
-	while (e_dma_busy(chan));
-
-	return ret_val;
+	return e_dma_wait_handle(handle);
 }
-
@@ -0,0 +1,146 @@
+/*
+  File: e_mutex_backoff.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "e_coreid.h"
+#include "e_mutex.h"
+
+
+unsigned e_mutex_backoff(unsigned delay)
+{
+	unsigned i, spins;
+
+	if (delay < E_MUTEX_BACKOFF_MIN)
+		delay = E_MUTEX_BACKOFF_MIN;
+
+	// Spread the cores over the next delay so they do not retry in lockstep
+	spins = delay + ((e_get_coreid() * 7) & (delay - 1));
+	for (i=0; i<spins; i++)
+		__asm__ __volatile__("nop");
+
+	delay <<= 1;
+	return (delay > E_MUTEX_BACKOFF_MAX) ? E_MUTEX_BACKOFF_MAX : delay;
+}
+
+
+void e_mutex_backoff_init(unsigned row, unsigned col, e_mutex_backoff_t *mutex)
+{
+	/* Only our own bookkeeping is set up. If we are the owner, other cores
+	 * may already be holding the lock word. */
+	mutex->glock  = (e_mutex_t *) e_get_global_address(row, col, &(mutex->lock));
+	mutex->coreid = e_get_coreid();
+
+	mutex->stats.acquires  = 0;
+	mutex->stats.contended = 0;
+	mutex->stats.retries   = 0;
+	mutex->stats.timeouts  = 0;
+
+	return;
+}
+
+
+void e_mutex_backoff_lock(e_mutex_backoff_t *mutex)
+{
+	unsigned val, delay, offset, failed;
+
+	delay  = E_MUTEX_BACKOFF_MIN;
+	offset = 0x0;
+	failed = 0;
+
+	for (;;)
+	{
+		val = mutex->coreid;
+		__asm__ __volatile__(
+			"testset	%[val], [%[glock], %[offset]]"
+			: [val] "+r" (val)
+			: [glock] "r" (mutex->glock), [offset] "r" (offset)
+			: "memory");
+		if (val == 0)
+			break;
+
+		failed++;
+		delay = e_mutex_backoff(delay);
+	}
+
+	mutex->stats.acquires++;
+	mutex->stats.retries += failed;
+	if (failed)
+		mutex->stats.contended++;
+
+	return;
+}
+
+
+unsigned e_mutex_backoff_trylock(e_mutex_backoff_t *mutex, unsigned tries)
+{
+	unsigned val, delay, offset, failed;
+
+	delay  = E_MUTEX_BACKOFF_MIN;
+	offset = 0x0;
+	failed = 0;
+
+	/* Make at least one attempt, backing off between further ones.
+	 * Returns 0 once the lock is taken, else the coreid holding it. */
+	for (;;)
+	{
+		val = mutex->coreid;
+		__asm__ __volatile__(
+			"testset	%[val], [%[glock], %[offset]]"
+			: [val] "+r" (val)
+			: [glock] "r" (mutex->glock), [offset] "r" (offset)
+			: "memory");
+		if (val == 0)
+			break;
+
+		failed++;
+		if (failed >= tries)
+		{
+			mutex->stats.retries += failed;
+			mutex->stats.timeouts++;
+			return val;
+		}
+		delay = e_mutex_backoff(delay);
+	}
+
+	mutex->stats.acquires++;
+	mutex->stats.retries += failed;
+	if (failed)
+		mutex->stats.contended++;
+
+	return 0;
+}
+
+
+void e_mutex_backoff_unlock(e_mutex_backoff_t *mutex)
+{
+	register const unsigned zero = 0;
+
+	__asm__ __volatile__(
+		"str	%[zero], [%[glock]]"
+		: /* no outputs */
+		: [zero] "r" (zero), [glock] "r" (mutex->glock)
+		: "memory");
+
+	return;
+}
@@ -0,0 +1,44 @@
+/*
+  File: e_mutex_barrier_diss.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_mutex.h>
+
+void e_barrier_diss(e_barrier_diss_t *bar)
+{
+	unsigned k;
+	unsigned char epoch;
+
+	epoch = ++bar->epoch;
+
+	/* A peer that already left this barrier may signal the next one before
+	 * we look, so a flag counts once it is at or past our epoch. */
+	for (k=0; k<bar->rounds; k++)
+	{
+		*(bar->peer[k]) = epoch;
+		while ((signed char) (bar->flag[k] - epoch) < 0) {};
+	}
+
+	return;
+}
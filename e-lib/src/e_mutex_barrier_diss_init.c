@@ -0,0 +1,48 @@
+/*
+  File: e_mutex_barrier_diss_init.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_coreid.h>
+#include <e_mutex.h>
+
+void e_barrier_diss_init(e_barrier_diss_t *bar)
+{
+	unsigned corenum, numcores, peer, k;
+
+	numcores = e_group_config.group_rows * e_group_config.group_cols;
+	corenum  = e_group_config.core_row * e_group_config.group_cols + e_group_config.core_col;
+
+	/* As with e_barrier_init(), the object must be statically initialized.
+	 * Peers may already have written our flags. */
+
+	for (k=0; (1u << k) < numcores && k < E_BARRIER_MAX_ROUNDS; k++)
+	{
+		peer = (corenum + (1u << k)) % numcores;
+		bar->peer[k] = (unsigned char *) e_get_global_address(peer / e_group_config.group_cols,
+				peer % e_group_config.group_cols, (void *) &(bar->flag[k]));
+	}
+	bar->rounds = k;
+
+	return;
+}
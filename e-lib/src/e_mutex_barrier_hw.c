@@ -0,0 +1,92 @@
+/*
+  File: e_mutex_barrier_hw.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_coreid.h>
+#include <e_ic.h>
+#include <e_regs.h>
+#include <e_mutex.h>
+
+#define E_STATUS_WAND (1 << 3)
+
+// Cores one column and one row apart in the global address space
+#define COL_STRIDE (1 << 20)
+#define ROW_STRIDE (0x40 << 20)
+
+// set by the WAND ISR, there is only one WAND line per core
+static volatile unsigned char wand_done;
+
+void __attribute__((interrupt)) e_barrier_hw_isr()
+{
+	wand_done = 1;
+}
+
+void e_barrier_hw(e_barrier_hw_t *bar)
+{
+	unsigned rows, cols, row, col, i, status, root;
+	unsigned char epoch;
+
+	if (!bar->hw)
+	{
+		e_barrier_tree(&(bar->sw));
+		return;
+	}
+
+	rows  = e_group_config.group_rows;
+	cols  = e_group_config.group_cols;
+	root  = (e_group_config.core_row == 0) && (e_group_config.core_col == 0);
+	epoch = bar->epoch;
+
+	/* Don't set our bit before every core has cleared it from the
+	 * previous barrier. All bits are clear before the first one. */
+	if (root)
+	{
+		for (i=1; i<rows*cols; i++)
+			while (bar->cleared[i] != epoch) {};
+		for (row=0; row<rows; row++)
+			for (col=(row ? 0 : 1); col<cols; col++)
+				*((volatile unsigned char *) ((unsigned) bar->armed0 + row * ROW_STRIDE + col * COL_STRIDE)) = epoch;
+	}
+	else
+	{
+		while (bar->armed != epoch) {};
+	}
+
+	wand_done = 0;
+	__asm__ __volatile__("wand");
+
+	/* Spin rather than idle: an interrupt arriving between the test and
+	 * the idle would leave us asleep for good. */
+	while (!wand_done) {};
+
+	// Clear our WAND bit to re-arm the line for the next barrier
+	status = e_reg_read(E_REG_STATUS);
+	e_reg_write(E_REG_FSTATUS, status & ~E_STATUS_WAND);
+
+	epoch = ++bar->epoch;
+	if (!root)
+		*(bar->report) = epoch;
+
+	return;
+}
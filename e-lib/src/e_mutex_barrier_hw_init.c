@@ -0,0 +1,58 @@
+/*
+  File: e_mutex_barrier_hw_init.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_coreid.h>
+#include <e_ic.h>
+#include <e_mutex.h>
+
+void __attribute__((interrupt)) e_barrier_hw_isr();
+
+void e_barrier_hw_init(e_barrier_hw_t *bar)
+{
+	unsigned dim;
+
+	dim = (e_group_config.chiptype == E_E64G401) ? 8 : 4;
+
+	// WAND is wired across one chip, so the group must be exactly one chip
+	bar->hw = (e_group_config.group_rows == dim) && (e_group_config.group_cols == dim) &&
+			  (e_group_config.group_row % dim == 0) && (e_group_config.group_col % dim == 0);
+
+	if (!bar->hw)
+	{
+		e_barrier_tree_init(&(bar->sw));
+		return;
+	}
+
+	// Cores report clearing their WAND bit to (0,0), which arms the others
+	bar->report = (unsigned char *) e_get_global_address(0, 0,
+			(void *) &(bar->cleared[e_group_config.core_row * dim + e_group_config.core_col]));
+	bar->armed0 = (unsigned char *) e_get_global_address(0, 0, (void *) &(bar->armed));
+
+	e_irq_attach(E_WAND_INT, e_barrier_hw_isr);
+	e_irq_mask(E_WAND_INT, E_FALSE);
+	e_irq_global_mask(E_FALSE);
+
+	return;
+}
@@ -0,0 +1,78 @@
+/*
+  File: e_mutex_barrier_tree.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_coreid.h>
+#include <e_mutex.h>
+
+// Cores one column and one row apart in the global address space
+#define COL_STRIDE (1 << 20)
+#define ROW_STRIDE (0x40 << 20)
+
+void e_barrier_tree(e_barrier_tree_t *bar)
+{
+	unsigned rows, cols, row, col, i;
+	unsigned char epoch;
+
+	rows = e_group_config.group_rows;
+	cols = e_group_config.group_cols;
+	row	 = e_group_config.core_row;
+	col	 = e_group_config.core_col;
+
+	epoch = ++bar->epoch;
+
+	/* A child can not get a barrier ahead of its parent, so every slot
+	 * holds either the previous or the current epoch when polled. */
+
+	// Gather pass
+	if (col == 0)
+	{
+		// wait for the rest of the row
+		for (i=1; i<cols; i++)
+			while (bar->arrive[i] != epoch) {};
+		// core (0,0) also waits for the other rows
+		if (row == 0)
+			for (i=1; i<rows; i++)
+				while (bar->arrive[E_BARRIER_MAX_DIM + i] != epoch) {};
+	}
+
+	if (bar->parent)
+	{
+		*(bar->parent) = epoch;
+		while (bar->release != epoch) {};
+	}
+
+	// Release pass
+	if (col == 0)
+	{
+		// release the other rows, then our own
+		if (row == 0)
+			for (i=1; i<rows; i++)
+				*((volatile unsigned char *) ((unsigned) bar->release0 + i * ROW_STRIDE)) = epoch;
+		for (i=1; i<cols; i++)
+			*((volatile unsigned char *) ((unsigned) bar->release0 + i * COL_STRIDE)) = epoch;
+	}
+
+	return;
+}
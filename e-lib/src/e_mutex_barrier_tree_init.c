@@ -0,0 +1,50 @@
+/*
+  File: e_mutex_barrier_tree_init.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <e_coreid.h>
+#include <e_mutex.h>
+
+void e_barrier_tree_init(e_barrier_tree_t *bar)
+{
+	unsigned row, col;
+
+	row = e_group_config.core_row;
+	col = e_group_config.core_col;
+
+	/* As with e_barrier_init(), the object must be statically initialized.
+	 * Children may already have written our arrive slots. */
+
+	// Row members report to the first core of the row, which reports to (0,0)
+	if (col > 0)
+		bar->parent = (unsigned char *) e_get_global_address(row, 0, (void *) &(bar->arrive[col]));
+	else if (row > 0)
+		bar->parent = (unsigned char *) e_get_global_address(0, 0, (void *) &(bar->arrive[E_BARRIER_MAX_DIM + row]));
+	else
+		bar->parent = 0;
+
+	bar->release0 = (unsigned char *) e_get_global_address(row, 0, (void *) &(bar->release));
+
+	return;
+}
@@ -43,5 +43,8 @@ void e_mutex_init(unsigned row, unsigned col, e_mutex_t *mutex, e_mutexattr_t *a
 	 * and any other cores' call to e_mutex_lock(). To avoid that, it is now a
 	 * requirement that mutex is statically initialized to 0. */
 
+	/* Locks that do need per core setup, e_mutex_backoff_t and
+	 * e_mutex_ticket_t, have their own init functions. */
+
 	return;
 }
@@ -32,12 +32,14 @@
 void e_mutex_lock(unsigned row, unsigned col, e_mutex_t *mutex)
 {
 	e_mutex_t *gmutex;
-	uint32_t coreid, offset, val;
+	uint32_t coreid, offset, val, delay;
 
 	coreid = e_get_coreid();
 	gmutex = (e_mutex_t *) e_get_global_address(row, col, mutex);
 	offset = 0x0;
+	delay  = E_MUTEX_BACKOFF_MIN;
 
+	// Back off between attempts rather than hammer the owner with testsets
 	do {
 		val = coreid;
 		__asm__ __volatile__(
@@ -45,6 +47,8 @@ void e_mutex_lock(unsigned row, unsigned col, e_mutex_t *mutex)
 			: [val] "+r" (val)
 			: [gmutex] "r" (gmutex), [offset] "r" (offset)
 			: "memory");
+		if (val != 0)
+			delay = e_mutex_backoff(delay);
 	} while (val != 0);
 
 	return;
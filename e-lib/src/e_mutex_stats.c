@@ -0,0 +1,52 @@
+/*
+  File: e_mutex_stats.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "e_coreid.h"
+#include "e_mutex.h"
+
+
+void e_mutex_stats(const e_mutex_stats_t *stats, e_mutex_stats_t *sum)
+{
+	const volatile e_mutex_stats_t *s;
+	unsigned row, col;
+
+	sum->acquires  = 0;
+	sum->contended = 0;
+	sum->retries   = 0;
+	sum->timeouts  = 0;
+
+	// Every core keeps its counters in its own copy of the lock
+	for (row=0; row<e_group_config.group_rows; row++)
+		for (col=0; col<e_group_config.group_cols; col++)
+		{
+			s = (const volatile e_mutex_stats_t *) e_get_global_address(row, col, stats);
+			sum->acquires  += s->acquires;
+			sum->contended += s->contended;
+			sum->retries   += s->retries;
+			sum->timeouts  += s->timeouts;
+		}
+
+	return;
+}
@@ -0,0 +1,145 @@
+/*
+  File: e_mutex_ticket.c
+
+  This file is part of the Epiphany Software Development Kit.
+
+  Copyright (C) 2026 Adapteva, Inc.
+  See AUTHORS for list of contributors.
+  Support e-mail: <support@adapteva.com>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License (LGPL)
+  as published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  and the GNU Lesser General Public License along with this program,
+  see the files COPYING and COPYING.LESSER.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "e_coreid.h"
+#include "e_mutex.h"
+
+// Offset of a core's slice in the global address space
+#define COREID_SHIFT 20
+#define LOCAL_MASK   0x000fffff
+
+
+void e_mutex_ticket_init(unsigned row, unsigned col, e_mutex_ticket_t *mutex)
+{
+	/* Only our own bookkeeping is set up. Tickets and grants already handed
+	 * out by other cores must survive. */
+	mutex->owner  = (e_mutex_ticket_t *) e_get_global_address(row, col, mutex);
+	mutex->coreid = e_get_coreid();
+
+	mutex->stats.acquires  = 0;
+	mutex->stats.contended = 0;
+	mutex->stats.retries   = 0;
+	mutex->stats.timeouts  = 0;
+
+	return;
+}
+
+
+// The guard is only held for a few remote accesses, back off on it
+static void guard_lock(e_mutex_ticket_t *mutex)
+{
+	e_mutex_t *guard;
+	unsigned val, delay, offset;
+
+	guard  = &(mutex->owner->guard);
+	delay  = E_MUTEX_BACKOFF_MIN;
+	offset = 0x0;
+
+	for (;;)
+	{
+		val = mutex->coreid;
+		__asm__ __volatile__(
+			"testset	%[val], [%[guard], %[offset]]"
+			: [val] "+r" (val)
+			: [guard] "r" (guard), [offset] "r" (offset)
+			: "memory");
+		if (val == 0)
+			break;
+
+		mutex->stats.retries++;
+		delay = e_mutex_backoff(delay);
+	}
+
+	return;
+}
+
+
+static void guard_unlock(e_mutex_ticket_t *mutex)
+{
+	register const unsigned zero = 0;
+
+	__asm__ __volatile__(
+		"str	%[zero], [%[guard]]"
+		: /* no outputs */
+		: [zero] "r" (zero), [guard] "r" (&(mutex->owner->guard))
+		: "memory");
+
+	return;
+}
+
+
+void e_mutex_ticket_lock(e_mutex_ticket_t *mutex)
+{
+	e_mutex_ticket_t *owner;
+	unsigned ticket, wait;
+
+	owner = mutex->owner;
+
+	// Take a ticket, and queue up if it is not being served yet
+	guard_lock(mutex);
+	ticket = owner->tail;
+	owner->tail = ticket + 1;
+	wait = (ticket != owner->head);
+	if (wait)
+		owner->queue[ticket % E_MUTEX_MAX_CORES] = mutex->coreid;
+	guard_unlock(mutex);
+
+	if (wait)
+	{
+		mutex->stats.contended++;
+		// the previous holder writes our ticket to our own copy
+		while (mutex->grant != ticket) {};
+	}
+
+	mutex->ticket = ticket;
+	mutex->stats.acquires++;
+
+	return;
+}
+
+
+void e_mutex_ticket_unlock(e_mutex_ticket_t *mutex)
+{
+	e_mutex_ticket_t *owner;
+	volatile unsigned *grant;
+	unsigned next, coreid;
+
+	owner = mutex->owner;
+	next  = mutex->ticket + 1;
+
+	// Serve the next ticket and hand the lock to its core, if it is taken
+	guard_lock(mutex);
+	owner->head = next;
+	if (owner->tail != next)
+	{
+		coreid = owner->queue[next % E_MUTEX_MAX_CORES];
+		grant  = (volatile unsigned *) ((coreid << COREID_SHIFT) |
+				((unsigned) &(mutex->grant) & LOCAL_MASK));
+		*grant = next;
+	}
+	guard_unlock(mutex);
+
+	return;
+}
@@ -72,7 +72,8 @@ static int check_shmtable()
 {
 	int retval = E_OK;
 
-	if ( SHM_MAGIC != shm_table->magic ) {
+	if ( SHM_MAGIC != shm_table->magic ||
+		 SHM_VERSION != shm_table->version ) {
 		retval = E_ERR;
 	}
 
@@ -82,49 +83,75 @@ static int check_shmtable()
 static const e_shmseg_pvt_t*
 shm_lookup_region(const char *name)
 {
-	const e_shmseg_pvt_t	 *retval = NULL;
-	int						  i		 = 0;
-
-	for ( i = 0; i < MAX_SHM_REGIONS; ++i ) {
-		if ( 1 == shm_table->regions[i].valid ) {
-			if ( 0 == e_strcmp(name, shm_table->regions[i].shm_seg.name) ) {
-				retval = &shm_table->regions[i];
-				break;
-			}
-		}
+	const e_shm_index_t		 *ent;
+	const e_shmseg_pvt_t	 *region;
+	uint32_t				  hash	 = e_shm_hash(name);
+	unsigned				  i, n;
+
+	/* Probe the name index, so that only regions whose name hash
+	 * matches are compared in external memory */
+	for ( n = 0, i = hash & (SHM_INDEX_SIZE - 1); n < SHM_INDEX_SIZE;
+		  ++n, i = (i + 1) & (SHM_INDEX_SIZE - 1) ) {
+		ent = &shm_table->index[i];
+
+		if ( SHM_INDEX_EMPTY == ent->slot )
+			break;
+		if ( SHM_INDEX_DELETED == ent->slot || hash != ent->hash ||
+			 ent->slot > MAX_SHM_REGIONS )
+			continue;
+
+		region = &shm_table->regions[ent->slot - 1];
+		if ( 1 == region->valid &&
+			 0 == e_strcmp(name, region->shm_seg.name) )
+			return region;
 	}
 
-	return retval;
+	return NULL;
 }
 
 
 /**
  * WARNING: we cannot serialize access to the shm table from the Epiphany
- * cores so treat the SHM Table as read-only!! 
+ * cores so treat the SHM Table as read-only!! The host makes the sequence
+ * counter odd while it changes regions, so retry the lookup if it was odd
+ * or changed while we read.
  */
 int e_shm_attach(e_memseg_t *mem, const char* name)
 {
 	const e_shmseg_pvt_t  *region = NULL;
-	int					   retval = E_ERR;
+	const volatile uint32_t *seqp = &shm_table->seq;
+	uint32_t			   seq;
+	e_memseg_t			   seg;
 
 	if ( !mem || !name ) {
-		return retval;
+		return E_ERR;
 	}
 
-	if ( E_OK == check_shmtable() ) {
+	if ( E_OK != check_shmtable() )
+		return E_ERR;
+
+	do {
+		while ( (seq = *seqp) & 1 )
+			;
+
 		region = shm_lookup_region(name);
 		if ( region ) {
-			mem->objtype	 = E_SHARED_MEM;
-			mem->phy_base	 = shm_table->paddr_cpu + region->shm_seg.offset;
-			mem->ephy_base	 = (unsigned)(region->shm_seg.paddr);
-			mem->size		 = region->shm_seg.size;
-			mem->type		 = E_RDWR;
-
-			retval			 = E_OK;
+			seg.phy_base	 = shm_table->paddr_cpu + region->shm_seg.offset;
+			seg.ephy_base	 = (unsigned)(region->shm_seg.paddr);
+			seg.size		 = region->shm_seg.size;
 		}
-	}
+	} while ( seq != *seqp );
 
-	return retval;
+	if ( !region )
+		return E_ERR;
+
+	mem->objtype	 = E_SHARED_MEM;
+	mem->phy_base	 = seg.phy_base;
+	mem->ephy_base	 = seg.ephy_base;
+	mem->size		 = seg.size;
+	mem->type		 = E_RDWR;
+
+	return E_OK;
 }
 
 int e_shm_release(const char* name)
@@ -34,14 +34,6 @@ void __attribute__((interrupt)) wand_trace_isr();
  */
 void __attribute__((interrupt)) timer1_trace_isr();
 
- /* **
- * Internal MACRO definitions
- *
- */
-
-// Hack until WAND interrupt gets implemented in Epiphany functions
-#define E_WAND_INT (0x8)
-
 /**
  * Internal static variables
  */
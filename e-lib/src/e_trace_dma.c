@@ -40,8 +40,6 @@ void __attribute__((interrupt)) wand_trace_isr();
  *
  */
 
-// Hack until WAND interrupt get implemented in epiphany functions
-#define E_WAND_INT (0x8)
 // should be 0xF0534
 #define DMA1AUTO0 (0xF0534)
 #define DMA1AUTO1 (0xF0538)
@@ -35,6 +35,7 @@
 
 #include <execinfo.h>
 #include <fcntl.h>
+#include <sys/time.h>
 #define __STDC_FORMAT_MACROS 1
 #include <inttypes.h>
 #include <unistd.h>
@@ -48,12 +49,14 @@ using std::cerr;
 using std::cout;
 using std::dec;
 using std::endl;
+using std::fixed;
 using std::flush;
 using std::hex;
 using std::ostringstream;
 using std::pair;
 using std::setbase;
 using std::setfill;
+using std::setprecision;
 using std::setw;
 using std::stringstream;
 using std::vector;
@@ -94,8 +97,12 @@ GdbServer::GdbServer (ServerInfo* _si) :
   mExtendedMode (false),
   mCurrentThread (NULL),
   mNotifyingP (false),
+  mStopCount (0),
+  mStopLatencyTotal (0.0),
+  mStopLatencyMax (0.0),
   si (_si),
-  fTargetControl (NULL)
+  fTargetControl (NULL),
+  mLoadSampler (NULL)
 {
   pkt = new RspPacket (RSP_PKT_MAX);
   rsp = new RspConnection (si);
@@ -107,6 +114,7 @@ GdbServer::GdbServer (ServerInfo* _si) :
 //! Destructor
 GdbServer::~GdbServer ()
 {
+  delete mLoadSampler;
   delete mpHash;
   delete rsp;
   delete pkt;
@@ -175,7 +183,9 @@ GdbServer::rspServer (TargetControl* _fTargetControl)
 	    cerr << "DebugTranDetail: Sending RSP client notifications."
 		 << endl;
 
+	  fTargetControl->lock ();
 	  rspClientNotifications ();
+	  fTargetControl->unlock ();
 	}
     }
 }	// rspServer()
@@ -538,6 +548,9 @@ GdbServer::rspStatus ()
 void
 GdbServer::rspClientRequest ()
 {
+  if (mLoadSampler)
+    mLoadSampler->poll ();
+
   if (mDebugMode == NON_STOP && !rsp->inputReady ())
     return;
 
@@ -548,6 +561,9 @@ GdbServer::rspClientRequest ()
       return;
     }
 
+  // The load sampler waits while we handle the packet
+  fTargetControl->lock ();
+
   switch (pkt->data[0])
     {
     case '!':
@@ -654,6 +670,9 @@ GdbServer::rspClientRequest ()
       rspUnknownPacket ();
       break;
     }
+
+  fTargetControl->unlock ();
+
 }				// rspClientRequest()
 
 
@@ -1239,15 +1258,19 @@ GdbServer::rspReadAllRegs ()
   if (si->debugStopResumeDetail ())
     fTargetControl->startOfBaudMeasurement ();
 
-  // Get each reg
+  // Get all the regs at once
+  vector <uint32_t> vals;
+  vector <bool> valid;
+
+  mCurrentThread->readAllRegs (vals, valid);
+
   for (unsigned int r = 0; r < NUM_REGS; r++)
     {
-      uint32_t val;
       unsigned int pktOffset = r * TargetControl::E_REG_BYTES * 2;
 
       // Not all registers are necessarily supported.
-      if (mCurrentThread->readReg (r, val))
-	Utils::reg2Hex (val, &(pkt->data[pktOffset]));
+      if (valid[r])
+	Utils::reg2Hex (vals[r], &(pkt->data[pktOffset]));
       else
 	for (unsigned int i = 0; i < TargetControl::E_REG_BYTES * 2; i++)
 	  pkt->data[pktOffset + i] = 'X';
@@ -1707,10 +1730,14 @@ GdbServer::rspCommand ()
     {
       rspCmdWorkgroup (cmd);
     }
+  else if (strcmp ("stop-latency", cmd) == 0)
+    {
+      rspCmdStopLatency ();
+    }
   else if (strcmp ("help", cmd) == 0)
     {
       pkt->packHexstr ("monitor commands: hwreset, coreid, swreset, halt, "
-		       "run, help\n");
+		       "run, stop-latency, help\n");
       rsp->putPkt (pkt);
       pkt->packStr ("OK");
       rsp->putPkt (pkt);
@@ -1726,6 +1753,31 @@ GdbServer::rspCommand ()
 }	// rspCommand()
 
 
+//-----------------------------------------------------------------------------
+//! Handle the "monitor stop-latency" command.
+
+//! Report how long it has taken to report thread stops to GDB while waiting
+//! in waitAllThreads.
+//-----------------------------------------------------------------------------
+void
+GdbServer::rspCmdStopLatency ()
+{
+  ostringstream  oss;
+
+  oss << "Stops reported: " << mStopCount << endl;
+  if (mStopCount > 0)
+    oss << "Stop reporting latency: mean " << setprecision (3) << fixed
+	<< mStopLatencyTotal / mStopCount << " ms, max " << mStopLatencyMax
+	<< " ms" << endl;
+
+  pkt->packHexstr (oss.str ().c_str ());
+  rsp->putPkt (pkt);
+  pkt->packStr ("OK");
+  rsp->putPkt (pkt);
+
+}	// rspCmdStopLatency ()
+
+
 //-----------------------------------------------------------------------------
 //! Handle the "monitor workgroup" command.
 
@@ -2160,18 +2212,58 @@ GdbServer::rspMakeOsDataProcessesReply ()
 }
 
 
+//-----------------------------------------------------------------------------
+//! Get the load sampler
+
+//! Sampling only starts once someone asks for load or traffic, so a server
+//! that is never asked costs nothing. Each request keeps it going; it stops
+//! by itself once requests have stopped coming in.
+
+//! @return  The load sampler.
+//-----------------------------------------------------------------------------
+LoadSampler*
+GdbServer::loadSampler ()
+{
+  if (NULL == mLoadSampler)
+    mLoadSampler = new LoadSampler (si, fTargetControl);
+
+  mLoadSampler->start ();
+
+  return mLoadSampler;
+
+}	// loadSampler ()
+
+
+//-----------------------------------------------------------------------------
+//! Format a sampled percentage for an OS data reply
+
+//! @param[in] percent  The percentage, or -1 if unknown.
+//! @return  The percentage as two or more digits, or "??" if unknown.
+//-----------------------------------------------------------------------------
+string
+GdbServer::osDataPercent (int percent)
+{
+  if (percent < 0)
+    return "??";
+  else
+    return Utils::intStr (percent, 10, 2);
+
+}	// osDataPercent ()
+
+
 //-----------------------------------------------------------------------------
 //! Make an OS core load request reply.
 
 //! This is epiphany specific.
 
-//! @todo For now this is a stub which returns random values in the range 0 -
-//! 99 for each core.
+//! The load is the percentage of the last second each core spent active and
+//! not halted, as measured by the load sampler.
 
 //-----------------------------------------------------------------------------
 string
 GdbServer::rspMakeOsDataLoadReply ()
 {
+  LoadSampler *sampler = loadSampler ();
   string reply =
     "<?xml version=\"1.0\"?>\n"
     "<!DOCTYPE target SYSTEM \"osdata.dtd\">\n"
@@ -2189,7 +2281,7 @@ GdbServer::rspMakeOsDataLoadReply ()
 
       reply +=
 	"    <column name=\"load\">";
-      reply += Utils::intStr (random () % 100, 10, 2);
+      reply += osDataPercent (sampler->load (it->first));
       reply += "</column>\n"
 	"  </item>\n";
     }
@@ -2206,15 +2298,17 @@ GdbServer::rspMakeOsDataLoadReply ()
 //! This is epiphany specific.
 
 //! When working out "North", "South", "East" and "West", the assumption is
-//! that core (0,0) is at the North-East corner. We provide in and out traffic
+//! that core (0,0) is at the North-West corner. We provide in and out traffic
 //! for each direction.
 
-//! @todo Currently only dummy data.
+//! The hardware has no link counters, so this is the percentage of the last
+//! second each link carried DMA traffic, as estimated by the load sampler.
 
 //-----------------------------------------------------------------------------
 string
 GdbServer::rspMakeOsDataTrafficReply ()
 {
+  LoadSampler *sampler = loadSampler ();
   string reply =
     "<?xml version=\"1.0\"?>\n"
     "<!DOCTYPE target SYSTEM \"osdata.dtd\">\n"
@@ -2223,13 +2317,22 @@ GdbServer::rspMakeOsDataTrafficReply ()
   unsigned int maxRow = fTargetControl->getNumRows () - 1;
   unsigned int maxCol = fTargetControl->getNumCols () - 1;
 
+  static const struct
+  {
+    const char *name;
+    LoadSampler::Direction dir;
+  } links[] = {
+    { "North", LoadSampler::NORTH },
+    { "South", LoadSampler::SOUTH },
+    { "East",  LoadSampler::EAST },
+    { "West",  LoadSampler::WEST }
+  };
+
   for (map <CoreId, int>::iterator it = mCore2Tid.begin ();
        it != mCore2Tid.end ();
        it++)
     {
       CoreId coreId = it->first;
-      string inTraffic;
-      string outTraffic;
 
       reply +=
 	"  <item>\n"
@@ -2237,65 +2340,43 @@ GdbServer::rspMakeOsDataTrafficReply ()
       reply += coreId;
       reply += "</column>\n";
 
-      // See what adjacent cores we have.  Note that empty columns
-      // confuse GDB! There is traffic on incoming edges, but not
-      // outgoing.
-      inTraffic = Utils::intStr (random () % 100, 10, 2);
-      if (coreId.row () > 0)
-	outTraffic = Utils::intStr (random () % 100, 10, 2);
-      else
-	outTraffic = "--";
-
-      reply +=
-	"    <column name=\"North In\">";
-      reply += inTraffic;
-      reply += "</column>\n"
-	"    <column name=\"North Out\">";
-      reply += outTraffic;
-      reply += "</column>\n";
-
-      inTraffic = Utils::intStr (random () % 100, 10, 2);
-      if (coreId.row ()< maxRow)
-	outTraffic = Utils::intStr (random () % 100, 10, 2);
-      else
-	outTraffic = "--";
-
-      reply +=
-	"    <column name=\"South In\">";
-      reply += inTraffic;
-      reply += "</column>\n"
-	"    <column name=\"South Out\">";
-      reply += outTraffic;
-      reply += "</column>\n";
-
-      inTraffic = Utils::intStr (random () % 100, 10, 2);
-      if (coreId.col () < maxCol)
-	outTraffic = Utils::intStr (random () % 100, 10, 2);
-      else
-	outTraffic = "--";
+      for (unsigned int i = 0; i < sizeof (links) / sizeof (links[0]); i++)
+	{
+	  LoadSampler::Direction dir = links[i].dir;
+	  string inTraffic;
+	  string outTraffic;
+	  bool edge;
 
-      reply +=
-	"    <column name=\"East In\">";
-      reply += inTraffic;
-      reply += "</column>\n"
-	"    <column name=\"East Out\">";
-      reply += outTraffic;
-      reply += "</column>\n";
+	  switch (dir)
+	    {
+	    case LoadSampler::NORTH: edge = coreId.row () == 0;      break;
+	    case LoadSampler::SOUTH: edge = coreId.row () >= maxRow; break;
+	    case LoadSampler::EAST:  edge = coreId.col () >= maxCol; break;
+	    default:                 edge = coreId.col () == 0;      break;
+	    }
 
-      inTraffic = Utils::intStr (random () % 100, 10, 2);
-      if (coreId.col () > 0)
-	outTraffic = Utils::intStr (random () % 100, 10, 2);
-      else
-	outTraffic = "--";
+	  // See what adjacent cores we have.  Note that empty columns
+	  // confuse GDB! There is traffic on incoming edges, but not
+	  // outgoing.
+	  inTraffic = osDataPercent (sampler->traffic (coreId, dir, false));
+	  if (edge)
+	    outTraffic = "--";
+	  else
+	    outTraffic = osDataPercent (sampler->traffic (coreId, dir, true));
+
+	  reply += "    <column name=\"";
+	  reply += links[i].name;
+	  reply += " In\">";
+	  reply += inTraffic;
+	  reply += "</column>\n"
+	    "    <column name=\"";
+	  reply += links[i].name;
+	  reply += " Out\">";
+	  reply += outTraffic;
+	  reply += "</column>\n";
+	}
 
-      reply +=
-	"    <column name=\"West In\">";
-      reply += inTraffic;
-      reply += "</column>\n"
-	"    <column name=\"West Out\">";
-      reply += outTraffic;
-      reply += "</column>\n"
-	"  </item>\n";
+      reply += "  </item>\n";
     }
 
   reply += "</osdata>";
@@ -2649,9 +2730,42 @@ GdbServer::waitAllThreads ()
 	}
     }
 
-  // We must wait until a thread halts.
+  // Collect the threads we are waiting for, in the order we prefer to
+  // report them.
+  vector <Thread*> waiting;
+  vector <CoreId> coreIds;
+  vector <uint32_t> debugStatus;
+
+  for (PidProcessInfoMap::iterator proc_it = mAttachedProcesses.begin ();
+       proc_it != mAttachedProcesses.end ();
+       ++proc_it)
+    {
+      ProcessInfo* process = (*proc_it).second;
+
+      for (set <Thread*>::iterator it = process->threadBegin ();
+	   it != process->threadEnd ();
+	   it++)
+	if ((*it)->lastAction () == ACTION_CONTINUE)
+	  {
+	    waiting.push_back (*it);
+	    coreIds.push_back ((*it)->coreId ());
+	  }
+    }
+
+  // We must wait until a thread halts. Poll often at first, so short runs
+  // (single steps, conditional breakpoints) are reported quickly, then back
+  // off so long runs don't flood the mesh with reads.
+  unsigned long delayUs = WAIT_POLL_MIN_US;
+  struct timeval lastRunning;
+
+  gettimeofday (&lastRunning, NULL);
+
   while (true)
     {
+      struct timeval pollStart;
+
+      gettimeofday (&pollStart, NULL);
+
       // Check for Ctrl-C.  Prioritize it over thread stops,
       // otherwise, e.g., "next" over a loop never manages to react to
       // the Ctrl-C, because a thread always manages to finish a
@@ -2666,31 +2780,65 @@ GdbServer::waitAllThreads ()
 	  return;
 	}
 
+      // Nobody left to report to. The main loop will detach.
+      if (!rsp->isConnected ())
+	return;
+
       if (si->debugCtrlCWait())
 	cerr << "DebugCtrlCWait: check for CTLR-C done" << endl;
 
-      for (PidProcessInfoMap::iterator proc_it = mAttachedProcesses.begin ();
-	   proc_it != mAttachedProcesses.end ();
-	   ++proc_it)
+      // Read DEBUGSTATUS of all the cores in one sweep. Confirm with
+      // isHalted, which also updates the thread's cached state.
+      bool swept = fTargetControl->readMem32Multi (coreIds,
+						   TargetControl::DEBUGSTATUS,
+						   debugStatus);
+
+      for (size_t i = 0; i < waiting.size (); i++)
 	{
-	  ProcessInfo* process = (*proc_it).second;
+	  Thread *thread = waiting[i];
 
-	  for (set <Thread*>::iterator it = process->threadBegin ();
-	       it != process->threadEnd ();
-	       it++)
+	  if (swept
+	      && (debugStatus[i] & TargetControl::DEBUGSTATUS_HALT_MASK)
+		 != TargetControl::DEBUGSTATUS_HALT_HALTED)
+	    continue;
+
+	  if (thread->isHalted ())
 	    {
-	      Thread *thread = *it;
+	      struct timeval now;
+	      struct timeval diff;
 
-	      if (thread->lastAction () == ACTION_CONTINUE && thread->isHalted ())
-		{
-		  thread->setPendingSignal (findStopReason (thread));
-		  doContinue (thread);
-		  return;
-		}
+	      thread->setPendingSignal (findStopReason (thread));
+	      doContinue (thread);
+
+	      gettimeofday (&now, NULL);
+	      timersub (&now, &lastRunning, &diff);
+
+	      double latency = diff.tv_sec * 1000.0 + diff.tv_usec / 1000.0;
+
+	      mStopCount++;
+	      mStopLatencyTotal += latency;
+	      if (latency > mStopLatencyMax)
+		mStopLatencyMax = latency;
+
+	      if (si->debugTiming ())
+		cerr << "DebugTiming: stop of thread " << thread->tid ()
+		     << " reported within " << latency << " ms." << endl;
+	      return;
 	    }
 	}
 
-      Utils::microSleep (100000);	// Every 100ms
+      lastRunning = pollStart;
+
+      if (mLoadSampler)
+	mLoadSampler->poll ();
+
+      // Sleep until the next poll, but wake at once if GDB sends anything.
+      // Let the load sampler at the target meanwhile.
+      fTargetControl->unlock ();
+      rsp->inputReady (delayUs);
+      fTargetControl->lock ();
+      delayUs = (2 * delayUs < WAIT_POLL_MAX_US) ? 2 * delayUs
+	: WAIT_POLL_MAX_US;
     }
 }	// waitAllThreads ()
 
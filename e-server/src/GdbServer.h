@@ -50,6 +50,7 @@
 #include <string.h>
 
 #include "CoreId.h"
+#include "LoadSampler.h"
 #include "MpHash.h"
 #include "ProcessInfo.h"
 #include "RspConnection.h"
@@ -196,6 +197,11 @@ private:
   //! PID of the process holding threads not assigned to a workgroup
   static const int DEFAULT_PID = 1;
 
+  //! Halt polling in waitAllThreads starts this often (microseconds), then
+  //! backs off by doubling up to WAIT_POLL_MAX_US.
+  static const unsigned long WAIT_POLL_MIN_US = 10;
+  static const unsigned long WAIT_POLL_MAX_US = 20000;
+
   //! Our debug mode
   enum {
     NON_STOP,
@@ -235,6 +241,13 @@ private:
   //! Indicate if we are in the middle of a notification sequence.
   bool mNotifyingP;
 
+  //! Stop reporting latency statistics from waitAllThreads. The latency of a
+  //! stop is measured from the last poll which saw the thread running to the
+  //! stop being reported, so is an upper bound.
+  unsigned long mStopCount;
+  double mStopLatencyTotal;		//!< In milliseconds
+  double mStopLatencyMax;		//!< In milliseconds
+
   //! Local pointer to server info
   ServerInfo *si;
 
@@ -251,6 +264,9 @@ private:
   //! Hash table for matchpoints
   MpHash *mpHash;
 
+  //! Background core load and traffic sampler. Created on first use.
+  LoadSampler *mLoadSampler;
+
   //! String for OS info
   string  osInfoReply;
 
@@ -294,7 +310,10 @@ private:
   string rspThreadExtraInfo (Thread* thread);
   void rspCommand ();
   void rspCmdWorkgroup (char* cmd);
+  void rspCmdStopLatency ();
 
+  LoadSampler* loadSampler ();
+  string osDataPercent (int percent);
   void rspTransfer ();
   typedef string (GdbServer::* makeTransferReplyFtype) (void);
   void rspTransferObject (const char *object,
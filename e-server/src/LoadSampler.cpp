@@ -0,0 +1,626 @@
+// Load Sampler class: Definition.
+
+// Copyright (C) 2026 Adapteva Inc.
+
+// This file is part of the Adapteva RSP server.
+
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+// Commenting is Doxygen compatible.
+
+#include <cstring>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "LoadSampler.h"
+
+using std::cerr;
+using std::endl;
+
+
+//-----------------------------------------------------------------------------
+//! Constructor.
+
+//! Sampling does not begin until start () is called.
+
+//! @param[in] _si              All the information about the server.
+//! @param[in] _fTargetControl  The target to sample.
+//-----------------------------------------------------------------------------
+LoadSampler::LoadSampler (ServerInfo* _si,
+			  TargetControl* _fTargetControl) :
+  si (_si),
+  fTargetControl (_fTargetControl),
+  mRunning (false),
+  mStopping (false),
+  mIdle (false)
+{
+  pthread_mutex_init (&mLock, NULL);
+  timerclear (&mLastQuery);
+
+}	// LoadSampler ()
+
+
+//-----------------------------------------------------------------------------
+//! Destructor.
+
+//! Stop the sampling thread if it is running.
+//-----------------------------------------------------------------------------
+LoadSampler::~LoadSampler ()
+{
+  stop ();
+  pthread_mutex_destroy (&mLock);
+
+}	// ~LoadSampler ()
+
+
+//-----------------------------------------------------------------------------
+//! Start sampling.
+
+//! Called for every query, which keeps sampling from going idle. If it is
+//! not running, take one sample synchronously, so the first query after
+//! starting already has data, then hand over to the sampling thread.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::start ()
+{
+  pthread_mutex_lock (&mLock);
+  gettimeofday (&mLastQuery, NULL);
+  pthread_mutex_unlock (&mLock);
+
+  poll ();
+  if (mRunning)
+    return;
+
+  initCores ();
+  sampleAll ();
+
+  mStopping = false;
+  mIdle = false;
+  if (pthread_create (&mThread, NULL, samplerThread, this) != 0)
+    {
+      cerr << "Warning: Unable to start load sampling thread." << endl;
+      restoreCtimers ();
+      return;
+    }
+
+  mRunning = true;
+
+}	// start ()
+
+
+//-----------------------------------------------------------------------------
+//! Stop sampling.
+
+//! Any core timers we took over are handed back.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::stop ()
+{
+  if (!mRunning)
+    return;
+
+  mStopping = true;
+  pthread_join (mThread, NULL);
+  mRunning = false;
+
+  restoreCtimers ();
+
+}	// stop ()
+
+
+//-----------------------------------------------------------------------------
+//! Clean up after sampling went idle.
+
+//! If the sampling thread ended for lack of queries, join it and hand back
+//! the core timers. Once idle the thread no longer touches the target, so
+//! this may be called with the target lock held.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::poll ()
+{
+  bool isIdle;
+
+  if (!mRunning)
+    return;
+
+  pthread_mutex_lock (&mLock);
+  isIdle = mIdle;
+  pthread_mutex_unlock (&mLock);
+
+  if (isIdle)
+    stop ();
+
+}	// poll ()
+
+
+//-----------------------------------------------------------------------------
+//! Rolling load of a core.
+
+//! @param[in] coreId  Relative core ID.
+//! @return  The percentage of the sampling window the core was busy, or -1
+//!          if we have no samples for it.
+//-----------------------------------------------------------------------------
+int
+LoadSampler::load (CoreId coreId)
+{
+  int res = -1;
+
+  pthread_mutex_lock (&mLock);
+
+  CoreState *cs = find (coreId);
+  if (cs && cs->count)
+    res = cs->busySum / cs->count;
+
+  pthread_mutex_unlock (&mLock);
+
+  return res;
+
+}	// load ()
+
+
+//-----------------------------------------------------------------------------
+//! Rolling traffic on one link of a core.
+
+//! @param[in] coreId  Relative core ID.
+//! @param[in] dir     Direction of the link from the core.
+//! @param[in] out     True for traffic leaving the core, false for arriving.
+//! @return  The percentage of the sampling window the link carried DMA
+//!          traffic, or -1 if we have no samples for the core.
+//-----------------------------------------------------------------------------
+int
+LoadSampler::traffic (CoreId coreId,
+		      Direction dir,
+		      bool out)
+{
+  int res = -1;
+
+  pthread_mutex_lock (&mLock);
+
+  CoreState *cs = find (coreId);
+  if (cs && cs->count)
+    res = cs->linkSum[linkBit (dir, out)] * 100 / cs->count;
+
+  pthread_mutex_unlock (&mLock);
+
+  return res;
+
+}	// traffic ()
+
+
+//-----------------------------------------------------------------------------
+//! Bit number of a link in a sample's link flags
+
+//! @param[in] dir  Direction of the link.
+//! @param[in] out  True for the outgoing half of the link.
+//! @return  The bit number.
+//-----------------------------------------------------------------------------
+unsigned int
+LoadSampler::linkBit (Direction dir,
+		      bool out)
+{
+  return 2 * (unsigned int) dir + (out ? 1 : 0);
+
+}	// linkBit ()
+
+
+//-----------------------------------------------------------------------------
+//! Sampling thread main loop
+
+//! @param[in] arg  The LoadSampler to drive.
+//! @return  NULL.
+//-----------------------------------------------------------------------------
+void *
+LoadSampler::samplerThread (void* arg)
+{
+  LoadSampler *sampler = static_cast <LoadSampler *> (arg);
+
+  while (!sampler->mStopping)
+    {
+      usleep (SAMPLE_PERIOD_US);
+      if (sampler->idle ())
+	break;
+      sampler->sampleAll ();
+    }
+
+  return NULL;
+
+}	// samplerThread ()
+
+
+//-----------------------------------------------------------------------------
+//! Check whether sampling should go idle
+
+//! Once this has returned true, the sampling thread must not touch the
+//! target again, see poll ().
+
+//! @return  True if there has been no query for IDLE_TIMEOUT_S seconds.
+//-----------------------------------------------------------------------------
+bool
+LoadSampler::idle ()
+{
+  struct timeval now;
+  struct timeval diff;
+  bool res;
+
+  gettimeofday (&now, NULL);
+
+  pthread_mutex_lock (&mLock);
+
+  timersub (&now, &mLastQuery, &diff);
+  if (diff.tv_sec >= (time_t) IDLE_TIMEOUT_S)
+    mIdle = true;
+  res = mIdle;
+
+  pthread_mutex_unlock (&mLock);
+
+  return res;
+
+}	// idle ()
+
+
+//-----------------------------------------------------------------------------
+//! Set up the per-core state
+
+//! Read each core's absolute ID, so DMA addresses can be mapped back to
+//! cores, and if requested program its timers to count clock and idle
+//! cycles.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::initCores ()
+{
+  mCores.clear ();
+  mRel2Idx.clear ();
+  mAbs2Idx.clear ();
+
+  fTargetControl->lock ();
+
+  for (vector <CoreId>::iterator it = fTargetControl->coreIdBegin ();
+       it != fTargetControl->coreIdEnd ();
+       it++)
+    {
+      CoreState cs;
+      uint32_t absId;
+
+      cs.relId = *it;
+      cs.ctimersValid = false;
+      cs.savedConfig = 0;
+      cs.head = 0;
+      cs.count = 0;
+      cs.busySum = 0;
+      memset (cs.linkSum, 0, sizeof (cs.linkSum));
+      if (fTargetControl->readMem32 (*it, TargetControl::COREID, absId))
+	{
+	  cs.absId = CoreId (absId & 0xfff);
+	  mAbs2Idx[cs.absId.coreId ()] = mCores.size ();
+	}
+
+      if (si->sampleCtimers ()
+	  && fTargetControl->readMem32 (*it, TargetControl::CONFIG,
+					cs.savedConfig))
+	{
+	  uint32_t config = cs.savedConfig;
+
+	  config &= ~(CONFIG_CTIMER_MASK << CONFIG_CTIMER0_SHIFT);
+	  config &= ~(CONFIG_CTIMER_MASK << CONFIG_CTIMER1_SHIFT);
+	  config |= CTIMER_CLK << CONFIG_CTIMER0_SHIFT;
+	  config |= CTIMER_IDLE << CONFIG_CTIMER1_SHIFT;
+
+	  cs.ctimersValid =
+	    fTargetControl->writeMem32 (*it, TargetControl::CTIMER0,
+					CTIMER_MAX)
+	    && fTargetControl->writeMem32 (*it, TargetControl::CTIMER1,
+					   CTIMER_MAX)
+	    && fTargetControl->writeMem32 (*it, TargetControl::CONFIG,
+					   config);
+	}
+
+      mRel2Idx[cs.relId] = mCores.size ();
+      mCores.push_back (cs);
+    }
+
+  fTargetControl->unlock ();
+
+}	// initCores ()
+
+
+//-----------------------------------------------------------------------------
+//! Hand the core timers back
+
+//! Put back the timer modes the cores had before we programmed them, leaving
+//! the rest of CONFIG as the application now has it.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::restoreCtimers ()
+{
+  uint32_t timerMask = (CONFIG_CTIMER_MASK << CONFIG_CTIMER0_SHIFT)
+    | (CONFIG_CTIMER_MASK << CONFIG_CTIMER1_SHIFT);
+
+  fTargetControl->lock ();
+
+  for (vector <CoreState>::iterator it = mCores.begin ();
+       it != mCores.end ();
+       it++)
+    {
+      uint32_t config;
+
+      if (!it->ctimersValid
+	  || !fTargetControl->readMem32 (it->relId, TargetControl::CONFIG,
+					 config))
+	continue;
+
+      config = (config & ~timerMask) | (it->savedConfig & timerMask);
+      fTargetControl->writeMem32 (it->relId, TargetControl::CONFIG, config);
+      it->ctimersValid = false;
+    }
+
+  fTargetControl->unlock ();
+
+}	// restoreCtimers ()
+
+
+//-----------------------------------------------------------------------------
+//! Take one sample of every core
+
+//! The sweep holds the target lock, but all target reads happen outside
+//! the ring lock, so queries are never held up by the mesh.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::sampleAll ()
+{
+  unsigned int n = mCores.size ();
+  vector <uint8_t> busy (n);
+  vector <uint8_t> links (n, 0);
+
+  fTargetControl->lock ();
+
+  for (unsigned int i = 0; i < n; i++)
+    {
+      busy[i] = sampleBusy (mCores[i]);
+      sampleDma (i, links);
+    }
+
+  fTargetControl->unlock ();
+
+  pthread_mutex_lock (&mLock);
+
+  for (unsigned int i = 0; i < n; i++)
+    {
+      Sample s;
+
+      s.busy = busy[i];
+      s.links = links[i];
+      push (mCores[i], s);
+    }
+
+  pthread_mutex_unlock (&mLock);
+
+}	// sampleAll ()
+
+
+//-----------------------------------------------------------------------------
+//! Sample how busy a core is
+
+//! If we own the core timers and the application has not reprogrammed them,
+//! use the clock and idle cycle counts since the last sample. Otherwise
+//! fall back to the STATUS active bit. A halted core is never busy.
+
+//! @param[in] cs  The core to sample.
+//! @return  The percentage of time busy.
+//-----------------------------------------------------------------------------
+uint8_t
+LoadSampler::sampleBusy (CoreState& cs)
+{
+  uint32_t status;
+  uint32_t debugStatus;
+
+  if (!fTargetControl->readMem32 (cs.relId, TargetControl::DEBUGSTATUS,
+				  debugStatus)
+      || (debugStatus & TargetControl::DEBUGSTATUS_HALT_MASK)
+         == TargetControl::DEBUGSTATUS_HALT_HALTED)
+    return 0;
+
+  if (cs.ctimersValid)
+    {
+      uint32_t config;
+      uint32_t clk;
+      uint32_t idle;
+
+      if (fTargetControl->readMem32 (cs.relId, TargetControl::CONFIG, config)
+	  && ((config >> CONFIG_CTIMER0_SHIFT) & CONFIG_CTIMER_MASK)
+	     == CTIMER_CLK
+	  && ((config >> CONFIG_CTIMER1_SHIFT) & CONFIG_CTIMER_MASK)
+	     == CTIMER_IDLE
+	  && fTargetControl->readMem32 (cs.relId, TargetControl::CTIMER0, clk)
+	  && fTargetControl->readMem32 (cs.relId, TargetControl::CTIMER1,
+					idle))
+	{
+	  // The timers count down from CTIMER_MAX
+	  fTargetControl->writeMem32 (cs.relId, TargetControl::CTIMER0,
+				      CTIMER_MAX);
+	  fTargetControl->writeMem32 (cs.relId, TargetControl::CTIMER1,
+				      CTIMER_MAX);
+
+	  uint64_t clkCycles = CTIMER_MAX - clk;
+	  uint64_t idleCycles = CTIMER_MAX - idle;
+
+	  if (clkCycles > 0)
+	    {
+	      if (idleCycles > clkCycles)
+		idleCycles = clkCycles;
+	      return (clkCycles - idleCycles) * 100 / clkCycles;
+	    }
+	}
+    }
+
+  if (!fTargetControl->readMem32 (cs.relId, TargetControl::STATUS, status))
+    return 0;
+
+  return (status & TargetControl::STATUS_ACTIVE_MASK) ? 100 : 0;
+
+}	// sampleBusy ()
+
+
+//-----------------------------------------------------------------------------
+//! Sample the DMA engines of a core
+
+//! For each busy channel, attribute its source and destination to the mesh
+//! links they use.
+
+//! @param[in]  idx    Index of the core to sample.
+//! @param[out] links  Link flags for all cores, updated.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::sampleDma (unsigned int idx,
+			vector <uint8_t>& links)
+{
+  static const uint32_t channelRegs[][3] = {
+    { TargetControl::DMA0STATUS, TargetControl::DMA0SRCADDR,
+      TargetControl::DMA0DSTADDR },
+    { TargetControl::DMA1STATUS, TargetControl::DMA1SRCADDR,
+      TargetControl::DMA1DSTADDR }
+  };
+
+  CoreId coreId = mCores[idx].relId;
+
+  for (unsigned int chan = 0; chan < 2; chan++)
+    {
+      uint32_t status;
+      uint32_t srcAddr;
+      uint32_t dstAddr;
+
+      if (!fTargetControl->readMem32 (coreId, channelRegs[chan][0], status)
+	  || !(status & DMASTATUS_STATE_MASK))
+	continue;
+
+      if (fTargetControl->readMem32 (coreId, channelRegs[chan][1], srcAddr))
+	routeTraffic (idx, srcAddr >> 20, false, links);
+      if (fTargetControl->readMem32 (coreId, channelRegs[chan][2], dstAddr))
+	routeTraffic (idx, dstAddr >> 20, true, links);
+    }
+}	// sampleDma ()
+
+
+//-----------------------------------------------------------------------------
+//! Attribute a transfer to mesh links
+
+//! Transfers are routed columns first (XY): along the row to the destination
+//! column, then along that column. We flag the first link leaving the sender and, if the other
+//! end is one of our cores, the last link arriving at the receiver. Reads
+//! are attributed to the data coming back.
+
+//! @param[in]  from    Index of the core doing the transfer.
+//! @param[in]  remote  Absolute core ID of the other end. Zero for local.
+//! @param[in]  out     True if data leaves the core, false if it arrives.
+//! @param[out] links   Link flags for all cores, updated.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::routeTraffic (unsigned int from,
+			   uint16_t remote,
+			   bool out,
+			   vector <uint8_t>& links)
+{
+  CoreId self = mCores[from].absId;
+  CoreId other (remote);
+
+  if ((remote == 0) || (remote == self.coreId ()))
+    return;
+
+  CoreId src = out ? self : other;
+  CoreId dst = out ? other : self;
+  Direction firstHop;
+  Direction lastHop;
+
+  if (src.col () != dst.col ())
+    firstHop = (dst.col () > src.col ()) ? EAST : WEST;
+  else
+    firstHop = (dst.row () > src.row ()) ? SOUTH : NORTH;
+
+  if (src.row () != dst.row ())
+    lastHop = (src.row () < dst.row ()) ? NORTH : SOUTH;
+  else
+    lastHop = (src.col () < dst.col ()) ? WEST : EAST;
+
+  map <uint16_t, unsigned int>::iterator it = mAbs2Idx.find (remote);
+
+  if (out)
+    {
+      links[from] |= 1 << linkBit (firstHop, true);
+      if (it != mAbs2Idx.end ())
+	links[it->second] |= 1 << linkBit (lastHop, false);
+    }
+  else
+    {
+      links[from] |= 1 << linkBit (lastHop, false);
+      if (it != mAbs2Idx.end ())
+	links[it->second] |= 1 << linkBit (firstHop, true);
+    }
+}	// routeTraffic ()
+
+
+//-----------------------------------------------------------------------------
+//! Add a sample to a core's ring
+
+//! Must be called with the lock held.
+
+//! @param[in] cs  The core.
+//! @param[in] s   The sample.
+//-----------------------------------------------------------------------------
+void
+LoadSampler::push (CoreState& cs,
+		   Sample s)
+{
+  if (cs.count == RING_SIZE)
+    {
+      Sample& old = cs.ring[cs.head];
+
+      cs.busySum -= old.busy;
+      for (unsigned int bit = 0; bit < 8; bit++)
+	if (old.links & (1 << bit))
+	  cs.linkSum[bit]--;
+    }
+  else
+    cs.count++;
+
+  cs.ring[cs.head] = s;
+  cs.busySum += s.busy;
+  for (unsigned int bit = 0; bit < 8; bit++)
+    if (s.links & (1 << bit))
+      cs.linkSum[bit]++;
+
+  cs.head = (cs.head + 1) % RING_SIZE;
+
+}	// push ()
+
+
+//-----------------------------------------------------------------------------
+//! Find the state for a core
+
+//! @param[in] coreId  Relative core ID.
+//! @return  The core state, or NULL if we do not know the core.
+//-----------------------------------------------------------------------------
+LoadSampler::CoreState *
+LoadSampler::find (CoreId coreId)
+{
+  map <CoreId, unsigned int>::iterator it = mRel2Idx.find (coreId);
+
+  return (it == mRel2Idx.end ()) ? NULL : &mCores[it->second];
+
+}	// find ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,198 @@
+// Load Sampler class: Declaration.
+
+// Copyright (C) 2026 Adapteva Inc.
+
+// This file is part of the Adapteva RSP server.
+
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+
+// You should have received a copy of the GNU General Public License along
+// with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+// Commenting is Doxygen compatible.
+
+#ifndef LOAD_SAMPLER__H
+#define LOAD_SAMPLER__H
+
+#include <map>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/time.h>
+
+//! @todo We would prefer to use <cstdint> here, but that requires ISO C++ 2011.
+#include <stdint.h>
+
+#include "CoreId.h"
+#include "ServerInfo.h"
+#include "TargetControl.h"
+
+using std::map;
+using std::vector;
+
+
+//-----------------------------------------------------------------------------
+//! Class sampling per-core load and mesh traffic in the background
+
+//! A sampling thread polls the STATUS, DEBUGSTATUS and DMA status registers
+//! of every core and keeps the last RING_SIZE samples per core in a ring
+//! buffer. Load is the fraction of samples in which the core was active and
+//! not halted.
+
+//! If the server was started with --sample-ctimers, the core timers are
+//! instead programmed to count clock and idle cycles (E_CTIMER_CLK and
+//! E_CTIMER_IDLE), which gives a cycle accurate load at the cost of taking
+//! over CTIMER0/CTIMER1 from the application.
+
+//! The Epiphany has no per-link traffic counters, so mesh traffic is
+//! approximated from the DMA engines. Whenever a channel is busy its source
+//! and destination addresses are decoded and the transfer is attributed to
+//! the first outgoing and last incoming link of its XY route: columns
+//! first, i.e. along the row to the destination column, then along that
+//! column. Traffic is the fraction of samples in which a link carried such
+//! a transfer.
+
+//! Each sweep over the cores holds the target lock, so it does not mix
+//! with the GDB server's own accesses. Sampling goes idle when nobody has
+//! asked for data for IDLE_TIMEOUT_S seconds. The sampling thread then
+//! ends, and poll () hands the core timers back. The next call to start ()
+//! begins afresh.
+//-----------------------------------------------------------------------------
+class LoadSampler
+{
+public:
+
+  //! Mesh directions. Increasing rows are South, increasing columns East,
+  //! matching the osdata traffic table.
+  enum Direction
+  {
+    NORTH = 0,
+    SOUTH = 1,
+    EAST  = 2,
+    WEST  = 3
+  };
+
+  // Constructor and destructor
+  LoadSampler (ServerInfo* _si,
+	       TargetControl* _fTargetControl);
+  ~LoadSampler ();
+
+  // Control
+  void start ();
+  void stop ();
+  void poll ();
+
+  // Accessors for the rolling rates as percentages, or -1 if unknown.
+  int  load (CoreId coreId);
+  int  traffic (CoreId coreId,
+		Direction dir,
+		bool out);
+
+private:
+
+  //! Number of samples kept per core
+  static const unsigned int RING_SIZE = 100;
+
+  //! Time between samples in microseconds. With RING_SIZE this gives a one
+  //! second window.
+  static const unsigned int SAMPLE_PERIOD_US = 10000;
+
+  //! Seconds without a query after which sampling stops
+  static const unsigned int IDLE_TIMEOUT_S = 10;
+
+  // CONFIG register fields for the core timers
+  static const unsigned int CONFIG_CTIMER0_SHIFT = 4;
+  static const unsigned int CONFIG_CTIMER1_SHIFT = 8;
+  static const uint32_t CONFIG_CTIMER_MASK = 0xf;
+  static const uint32_t CTIMER_CLK  = 0x1;
+  static const uint32_t CTIMER_IDLE = 0x2;
+  static const uint32_t CTIMER_MAX  = 0xffffffff;
+
+  // DMA status register
+  static const uint32_t DMASTATUS_STATE_MASK = 0xf;
+
+  //! Per-link traffic flags in a sample: bit (2 * dir) is in, bit
+  //! (2 * dir + 1) is out.
+  static unsigned int linkBit (Direction dir,
+			       bool out);
+
+  //! A single sample
+  struct Sample
+  {
+    uint8_t busy;			//!< Percentage of time busy
+    uint8_t links;			//!< Link flags, see linkBit ()
+  };
+
+  //! Per-core state
+  struct CoreState
+  {
+    CoreId  relId;			//!< Relative core ID
+    CoreId  absId;			//!< Absolute core ID from COREID
+    bool  ctimersValid;		//!< Ctimers were programmed by us
+    uint32_t  savedConfig;		//!< CONFIG before we programmed it
+    Sample  ring[RING_SIZE];		//!< Most recent samples
+    unsigned int  head;			//!< Next slot to fill
+    unsigned int  count;		//!< Number of valid slots
+    unsigned long  busySum;		//!< Sum of busy over valid slots
+    unsigned int  linkSum[8];		//!< Count of each link flag
+  };
+
+  //! Local pointer to server info
+  ServerInfo *si;
+
+  //! Target we sample
+  TargetControl *fTargetControl;
+
+  //! All cores, with indices by relative and absolute core ID
+  vector <CoreState> mCores;
+  map <CoreId, unsigned int> mRel2Idx;
+  map <uint16_t, unsigned int> mAbs2Idx;
+
+  //! Protects the rings, mLastQuery and mIdle
+  pthread_mutex_t  mLock;
+
+  //! The sampling thread and whether it is running
+  pthread_t  mThread;
+  bool  mRunning;
+  volatile bool  mStopping;
+
+  //! When start () was last called
+  struct timeval  mLastQuery;
+
+  //! The sampling thread has gone idle and is about to end
+  bool  mIdle;
+
+  // Helper functions
+  static void* samplerThread (void* arg);
+  bool idle ();
+  void initCores ();
+  void sampleAll ();
+  uint8_t sampleBusy (CoreState& cs);
+  void sampleDma (unsigned int idx,
+		  vector <uint8_t>& links);
+  void routeTraffic (unsigned int from,
+		     uint16_t remote,
+		     bool out,
+		     vector <uint8_t>& links);
+  void push (CoreState& cs,
+	     Sample s);
+  void restoreCtimers ();
+  CoreState* find (CoreId coreId);
+
+};	// LoadSampler ()
+
+#endif // LOAD_SAMPLER__H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
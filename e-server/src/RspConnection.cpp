@@ -127,6 +127,8 @@ RspConnection::rspInit (int _portNum)
 {
   portNum = _portNum;
   clientFd = -1;
+  mInPos = 0;
+  mInLen = 0;
 
 }				// init()
 
@@ -215,6 +217,8 @@ bool RspConnection::rspConnect ()
   socklen_t
     len = sizeof (sockAddr);	// Size of the socket address
   clientFd = accept (tmpFd, (struct sockaddr *) &sockAddr, &len);
+  mInPos = 0;
+  mInLen = 0;
 
   if (-1 == clientFd)
     {
@@ -255,6 +259,8 @@ RspConnection::rspClose ()
       cerr << "Closing connection" << endl;
       close (clientFd);
       clientFd = -1;
+      mInPos = 0;
+      mInLen = 0;
     }
 }				// rspClose()
 
@@ -431,8 +437,9 @@ bool RspConnection::getPkt (RspPacket * pkt)
 //! are escaped by preceding them with '}' and then XORing the character with
 //! 0x20.
 
-//! Since this is SystemC, if we hit something that requires a
-//! restart/retransmission, we wait so another thread gets a lookin.
+//! The whole packet is framed once into mOutBuf and sent with a single write,
+//! rather than a write per character. A retransmission resends the same
+//! buffer.
 
 //! @param[in] pkt  The Packet to transmit
 
@@ -441,62 +448,16 @@ bool RspConnection::getPkt (RspPacket * pkt)
 //-----------------------------------------------------------------------------
 bool RspConnection::putPkt (RspPacket * pkt)
 {
-  int
-    len = pkt->getLen ();
   int
     ch;				// Ack char
 
-  // Construct $<packet info>#<checksum>. Repeat until the GDB client
-  // acknowledges satisfactory receipt.
+  frameOutBuf ('$', pkt->data, pkt->getLen (), true);
+
+  // Send $<packet info>#<checksum>. Repeat until the GDB client acknowledges
+  // satisfactory receipt.
   do
     {
-      unsigned char
-	checksum = 0;		// Computed checksum
-      int
-	count = 0;		// Index into the buffer
-
-      if (!putRspChar ('$'))	// Start char
-	{
-	  return false;		// Comms failure
-	}
-
-
-      // Body of the packet
-      for (count = 0; count < len; count++)
-	{
-	  unsigned char
-	    ch = pkt->data[count];
-
-	  // Check for escaped chars
-	  if (('$' == ch) || ('#' == ch) || ('*' == ch) || ('}' == ch))
-	    {
-	      ch ^= 0x20;
-	      checksum += (unsigned char) '}';
-	      if (!putRspChar ('}'))
-		{
-		  return false;	// Comms failure
-		}
-
-	    }
-
-	  checksum += ch;
-	  if (!putRspChar (ch))
-	    {
-	      return false;	// Comms failure
-	    }
-	}
-
-      if (!putRspChar ('#'))	// End char
-	{
-	  return false;		// Comms failure
-	}
-
-      // Computed checksum
-      if (!putRspChar (Utils::hex2Char (checksum >> 4)))
-	{
-	  return false;		// Comms failure
-	}
-      if (!putRspChar (Utils::hex2Char (checksum % 16)))
+      if (!writeAll (mOutBuf.data (), mOutBuf.size ()))
 	{
 	  return false;		// Comms failure
 	}
@@ -535,86 +496,141 @@ bool RspConnection::putPkt (RspPacket * pkt)
 bool
 RspConnection::putNotification (RspPacket* pkt)
 {
-  unsigned char  checksum = 0;		// Computed checksum
-  int            count = 0;		// Index into the buffer
+  frameOutBuf ('%', pkt->data, pkt->getLen (), false);
 
-  if (!putRspChar ('%'))	// Start char
+  if (!writeAll (mOutBuf.data (), mOutBuf.size ()))
     return false;		// Comms failure
 
-  int len = pkt->getLen ();
+  if (si->debugTrapAndRspCon ())
+    cerr << "[" << portNum << "]:" << " putNotification: " << *pkt << endl;
 
-  // Body of the packet
-  for (count = 0; count < len; count++)
-    {
-      unsigned char uch = pkt->data[count];
+  return true;
 
-      checksum += uch;
-      if (!putRspChar (uch))
-	return false;	// Comms failure
-    }
+}	// putNotification ()
 
-  if (!putRspChar ('#'))	// End char
-    return false;		// Comms failure
 
-  // Computed checksum
-  if (!putRspChar (Utils::hex2Char (checksum >> 4)))
-    return false;		// Comms failure
-  if (!putRspChar (Utils::hex2Char (checksum % 16)))
-    return false;		// Comms failure
+//-----------------------------------------------------------------------------
+//! Frame a packet into the output buffer
 
-  if (si->debugTrapAndRspCon ())
-    cerr << "[" << portNum << "]:" << " putNotification: " << *pkt << endl;
+//! Construct <start><packet info>#<checksum> in mOutBuf, escaping the body if
+//! requested. The buffer keeps its capacity, so after the first few packets
+//! this does no allocation.
 
-  return true;
+//! @param[in] start   The start character, '$' or '%'.
+//! @param[in] data    The packet body.
+//! @param[in] len     The length of the packet body.
+//! @param[in] escape  TRUE if '$', '#', '*' and '}' should be escaped.
+//-----------------------------------------------------------------------------
+void
+RspConnection::frameOutBuf (char start,
+			    const char* data,
+			    int len,
+			    bool escape)
+{
+  unsigned char  checksum = 0;		// Computed checksum
+
+  mOutBuf.clear ();
+  mOutBuf.reserve (2 * len + 4);	// Worst case, everything escaped
+  mOutBuf += start;
+
+  for (int count = 0; count < len; count++)
+    {
+      unsigned char  ch = data[count];
+
+      // Check for escaped chars
+      if (escape
+	  && (('$' == ch) || ('#' == ch) || ('*' == ch) || ('}' == ch)))
+	{
+	  ch ^= 0x20;
+	  checksum += (unsigned char) '}';
+	  mOutBuf += '}';
+	}
+
+      checksum += ch;
+      mOutBuf += (char) ch;
+    }
+
+  mOutBuf += '#';
+  mOutBuf += Utils::hex2Char (checksum >> 4);
+  mOutBuf += Utils::hex2Char (checksum % 16);
+
+}	// frameOutBuf ()
 
-}	// putNotification ()
 
 //-----------------------------------------------------------------------------
 //! Put a single character out on the RSP connection
 
-//! Utility routine. This should only be called if the client is open, but we
-//! check for safety.
+//! Utility routine, used for acks. This should only be called if the client
+//! is open, but we check for safety.
 
 //! @param[in] c         The character to put out
 
 //! @return  TRUE if char sent OK, FALSE if not (communications failure)
 //-----------------------------------------------------------------------------
 bool RspConnection::putRspChar (char c)
+{
+  return writeAll (&c, sizeof (c));
+
+}				// putRspChar()
+
+
+//-----------------------------------------------------------------------------
+//! Write a buffer out on the RSP connection
+
+//! Utility routine. This should only be called if the client is open, but we
+//! check for safety.
+
+//! Short writes are continued from where they stopped. If the socket would
+//! block, we wait until it is writable again.
+
+//! @param[in] buf  The characters to put out
+//! @param[in] len  The number of characters to put out
+
+//! @return  TRUE if all sent OK, FALSE if not (communications failure)
+//-----------------------------------------------------------------------------
+bool
+RspConnection::writeAll (const char* buf,
+			 size_t len)
 {
   if (-1 == clientFd)
     {
-      cerr << "Warning: Attempt to write '" << c
-	<< "' to unopened RSP client: Ignored" << endl;
+      cerr << "Warning: Attempt to write " << len
+	<< " chars to unopened RSP client: Ignored" << endl;
       return false;
     }
 
-  // Write until successful (we retry after interrupts) or catastrophic
-  // failure.
-  while (true)
+  // Write until everything is out (we retry after interrupts) or
+  // catastrophic failure.
+  while (len > 0)
     {
-      switch (write (clientFd, &c, sizeof (c)))
+      ssize_t n = write (clientFd, buf, len);
+
+      if (-1 == n)
 	{
-	case -1:
 	  // Error: only allow interrupts or would block
-	  if ((EAGAIN != errno) && (EINTR != errno))
+	  if (EAGAIN == errno)
+	    {
+	      struct pollfd pfd = { clientFd, POLLOUT, 0 };
+
+	      poll (&pfd, 1, -1);
+	    }
+	  else if (EINTR != errno)
 	    {
 	      cerr << "Warning: Failed to write to RSP client: "
 		<< "Closing client connection: " << strerror (errno) << endl;
 	      return false;
 	    }
-
-	  break;
-
-	case 0:
-	  break;		// Nothing written! Try again
-
-	default:
-	  return true;		// Success, we can return
+	}
+      else
+	{
+	  buf += n;
+	  len -= n;
 	}
     }
 
-  return false;			// shouldn't get here anyway!
-}				// putRspChar()
+  return true;
+
+}	// writeAll ()
 
 
 //-----------------------------------------------------------------------------
@@ -623,6 +639,9 @@ bool RspConnection::putRspChar (char c)
 //! Utility routine. This should only be called if the client is open, but we
 //! check for safety.
 
+//! Characters come from mInBuf, which is refilled with whatever the client
+//! has sent, up to IN_BUF_SIZE, when it runs dry.
+
 //! @return  The character received or -1 on failure
 //-----------------------------------------------------------------------------
 int
@@ -635,54 +654,81 @@ RspConnection::getRspChar ()
       return -1;
     }
 
-  // Blocking read until successful (we retry after interrupts) or
-  // catastrophic failure.
-  while (true)
+  if (mInPos == mInLen)
     {
-      unsigned char c;
+      // Blocking read until successful or catastrophic failure.
+      int res = fillInBuf ();
 
-      switch (read (clientFd, &c, sizeof (c)))
+      if (res <= 0)
 	{
-	case -1:
-	  // Error: only allow interrupts
-	  if (EINTR != errno)
-	    {
-	      cerr << "Warning: Failed to read from RSP client: "
-		<< "Closing client connection: " << strerror (errno) << endl;
-	      return -1;
-	    }
-	  break;
-
-	case 0:
+	  if (-1 == res)
+	    cerr << "Warning: Failed to read from RSP client: "
+	      << "Closing client connection: " << strerror (errno) << endl;
 	  return -1;
-
-	default:
-	  return c & 0xff;	// Success, we can return (no sign extend!)
 	}
     }
 
-  return false;			// shouldn't get here anyway!
+  return mInBuf[mInPos++];	// No sign extend!
+
 }				// getRspChar()
 
 
+//-----------------------------------------------------------------------------
+//! Refill the input buffer from the RSP connection
+
+//! Must only be called when the buffer is empty. Blocks until at least one
+//! character is available, retrying after interrupts.
+
+//! @return  The number of characters read, 0 if the client closed the
+//!          connection, or -1 on failure.
+//-----------------------------------------------------------------------------
+int
+RspConnection::fillInBuf ()
+{
+  ssize_t n;
+
+  do
+    {
+      n = read (clientFd, mInBuf, IN_BUF_SIZE);
+    }
+  while (n == -1 && errno == EINTR);
+
+  mInPos = 0;
+  mInLen = (n > 0) ? n : 0;
+
+  return n;
+
+}	// fillInBuf ()
+
+
 //-----------------------------------------------------------------------------
 //! Check if there input ready on the socket.
 
+//! With a timeout, this is also how we sleep while waiting for something
+//! else to happen, since it returns early if GDB sends anything.
+
+//! @param[in] timeoutUs  How long to wait for input, in microseconds.
 //! @return  TRUE if so, FALSE otherwise.
 //-----------------------------------------------------------------------------
 bool
-RspConnection::inputReady ()
+RspConnection::inputReady (unsigned long timeoutUs)
 {
   fd_set readfds;
   int res;
-  struct timeval zero = {};
+  struct timeval timeout;
 
-  FD_ZERO (&readfds);
-  FD_SET (clientFd, &readfds);
+  // Anything already buffered counts
+  if (mInPos < mInLen)
+    return true;
 
   do
     {
-      res = select (clientFd + 1, &readfds, NULL, NULL, &zero);
+      // select may change its arguments, so set them every time round.
+      FD_ZERO (&readfds);
+      FD_SET (clientFd, &readfds);
+      timeout.tv_sec = timeoutUs / 1000000;
+      timeout.tv_usec = timeoutUs % 1000000;
+      res = select (clientFd + 1, &readfds, NULL, NULL, &timeout);
     }
   while (res == -1 && errno == EINTR);
 
@@ -699,6 +745,9 @@ RspConnection::inputReady ()
 //-----------------------------------------------------------------------------
 //! Check if there is an out-of-band BREAK command on the serial link.
 
+//! If we find the client has closed the connection, we close our end too,
+//! so callers can tell with isConnected ().
+
 //! @return  TRUE if we got a BREAK, FALSE otherwise.
 //-----------------------------------------------------------------------------
 bool
@@ -713,28 +762,23 @@ RspConnection::getBreakCommand ()
   if (!inputReady ())
     return false;
 
-  unsigned char c;
-  int n;
-
-  do
-    {
-      n = read (clientFd, &c, sizeof (c));
-    }
-  while (n == -1 && errno == EINTR);
-
-  switch (n)
-    {
-    case -1:
-      return false;		// Not necessarily serious could be temporary
+  if (mInPos == mInLen)
+    switch (fillInBuf ())
+      {
+      case -1:
+	return false;		// Not necessarily serious could be temporary
 				// unavailable resource.
-    case 0:
-      return false;		// No break character there
+      case 0:
+	rspClose ();		// Client has gone away
+	return false;
 
-    default:
-      // @todo Not sure this is really right. What other characters are we
-      //       throwing away if it is not 0x03?
-      return (c == 0x03);
-    }
+      default:
+	break;
+      }
+
+  // @todo Not sure this is really right. What other characters are we
+  //       throwing away if it is not 0x03?
+  return (mInBuf[mInPos++] == 0x03);
 }				// getBreakCommand()
 
 
@@ -52,9 +52,13 @@
 #ifndef RSP_CONNECTION__H
 #define RSP_CONNECTION__H
 
+#include <string>
+
 #include "RspPacket.h"
 #include "ServerInfo.h"
 
+using std::string;
+
 
 //! The default service to use if port number = 0 and no service specified
 #define DEFAULT_RSP_SERVICE  "atdsp-rsp"
@@ -94,7 +98,7 @@ public:
   bool isConnected ();
 
   // Public interface: get packets from the stream and put them out
-  bool inputReady ();
+  bool inputReady (unsigned long timeoutUs = 0);
   bool getPkt (RspPacket * pkt);
   bool putPkt (RspPacket * pkt);
   bool putNotification (RspPacket* pkt);
@@ -110,6 +114,19 @@ private:
   bool putRspChar (char c);
   int getRspChar ();
 
+  // Internal routines to handle whole buffers
+  void frameOutBuf (char start,
+		    const char* data,
+		    int len,
+		    bool escape);
+  bool writeAll (const char* buf,
+		 size_t len);
+  int fillInBuf ();
+
+  //! Size of the input buffer. Big enough for a full register write packet
+  //! in one read.
+  static const size_t IN_BUF_SIZE = 4096;
+
   //! Pointer to the server info
   ServerInfo *si;
 
@@ -121,6 +138,16 @@ private:
 
   //! Whether we saw a '\003' (Ctrl-C) request in between packets.
   bool mPendingBreak;
+
+  //! Outgoing packet, framed and checksummed. Reused between packets.
+  string mOutBuf;
+
+  //! Characters read from the client but not yet consumed.
+  unsigned char mInBuf[IN_BUF_SIZE];
+
+  //! Next character to consume and end of valid data in mInBuf.
+  size_t mInPos;
+  size_t mInLen;
 };				// RspConnection()
 
 #endif // RSP_CONNECTION__H
@@ -43,7 +43,8 @@ ServerInfo::ServerInfo () :
   showMemoryMapFlag (false),
   checkHwAddrFlag (false),
   haltOnAttachFlag (true),
-  multiProcessFlag (false)
+  multiProcessFlag (false),
+  sampleCtimersFlag (false)
 {
 }	// ServerInfo ()
 
@@ -396,6 +397,24 @@ ServerInfo::multiProcess () const
 }	// multiProcess ()
 
 
+//! Set the sample core timers flag
+void
+ServerInfo::sampleCtimers (const bool _sampleCtimersFlag)
+{
+  sampleCtimersFlag = _sampleCtimersFlag;
+
+}	// sampleCtimers ()
+
+
+//! Get the sample core timers flag
+bool
+ServerInfo::sampleCtimers () const
+{
+  return sampleCtimersFlag;
+
+}	// sampleCtimers ()
+
+
 // Local Variables:
 // mode: C++
 // c-file-style: "gnu"
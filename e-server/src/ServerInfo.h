@@ -76,6 +76,8 @@ public:
   bool haltOnAttach () const;
   void multiProcess (const bool _multiProcessFlag);
   bool multiProcess () const;
+  void sampleCtimers (const bool _sampleCtimersFlag);
+  bool sampleCtimers () const;
 
 private:
 
@@ -117,6 +119,7 @@ private:
   bool checkHwAddrFlag;			//!< Check HW address when used
   bool haltOnAttachFlag;		//!< Don't halt processor when attaching
   bool multiProcessFlag;		//!< Multiprocess model
+  bool sampleCtimersFlag;		//!< Use core timers for load sampling
 
 };	// ServerInfo
 
@@ -31,19 +31,50 @@
 //! reasonable value.
 TargetControl::TargetControl ()
 {
+  pthread_mutexattr_t attr;
+
   startOfBaudMeasurement ();
 
+  pthread_mutexattr_init (&attr);
+  pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&mAccessLock, &attr);
+  pthread_mutexattr_destroy (&attr);
+
 }	// TargetControl ()
 
 
 //! Destructor
-
-//! Default does nothing
 TargetControl::~TargetControl ()
 {
+  pthread_mutex_destroy (&mAccessLock);
+
 }	// ~TargetControl ()
 
 
+//! Take the target access lock
+
+//! The GDB server and the load sampler both drive the target. Each takes
+//! this lock around a whole sequence of accesses, such as handling one RSP
+//! packet or sampling all cores, so neither sees the other's sequence half
+//! done. The lock is recursive, so code holding it may call code that takes
+//! it again.
+void
+TargetControl::lock ()
+{
+  pthread_mutex_lock (&mAccessLock);
+
+}	// lock ()
+
+
+//! Release the target access lock
+void
+TargetControl::unlock ()
+{
+  pthread_mutex_unlock (&mAccessLock);
+
+}	// unlock ()
+
+
 //! Reset the platform
 
 //! Default implementation does nothing.
@@ -53,6 +84,55 @@ TargetControl::platformReset ()
 }	// platformReset ()
 
 
+//! Read the same 32-bit word from several cores
+
+//! Default implementation reads each core in turn. Targets which can batch
+//! the accesses should override this.
+
+//! @param[in]  coreIds  Relative IDs of the cores to read.
+//! @param[in]  addr     Local address to read on each core.
+//! @param[out] data     The values read, one per core, in order.
+//! @return  true if all reads succeeded, false otherwise.
+bool
+TargetControl::readMem32Multi (const vector <CoreId>& coreIds,
+			       uint32_t addr,
+			       vector <uint32_t>& data)
+{
+  data.resize (coreIds.size ());
+
+  for (size_t i = 0; i < coreIds.size (); i++)
+    if (!readMem32 (coreIds[i], addr, data[i]))
+      return false;
+
+  return true;
+
+}	// readMem32Multi ()
+
+
+//! Read many registers of one core at once
+
+//! Default implementation reads each register in turn. Targets which can
+//! snapshot the register file should override this.
+
+//! @param[in]  coreId  Relative ID of the core to read.
+//! @param[in]  addrs   Register addresses to read.
+//! @param[out] data    The values read, one per register, in order.
+//! @param[out] valid   Whether each register could be read.
+void
+TargetControl::readRegs (CoreId coreId,
+			 const vector <uint32_t>& addrs,
+			 vector <uint32_t>& data,
+			 vector <bool>& valid)
+{
+  data.resize (addrs.size ());
+  valid.resize (addrs.size ());
+
+  for (size_t i = 0; i < addrs.size (); i++)
+    valid[i] = readMem32 (coreId, addrs[i], data[i]);
+
+}	// readRegs ()
+
+
 //! Utility to start timing
 void
 TargetControl::startOfBaudMeasurement ()
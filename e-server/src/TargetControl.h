@@ -34,6 +34,7 @@
 //! @todo We would prefer to use <cinttypes.h> here, but that requires ISO C++
 //! 2011.
 #include <inttypes.h>
+#include <pthread.h>
 #include <sys/time.h>
 
 #include "CoreId.h"
@@ -244,6 +245,14 @@ public:
   virtual bool readBurst (CoreId coreId, uint32_t addr, uint8_t *buf,
 			  size_t buff_size) = 0;
 
+  // Read the same word from many cores at once
+  virtual bool readMem32Multi (const vector <CoreId>& coreIds, uint32_t addr,
+			       vector <uint32_t>& data);
+
+  // Read many registers of one core at once
+  virtual void readRegs (CoreId coreId, const vector <uint32_t>& addrs,
+			 vector <uint32_t>& data, vector <bool>& valid);
+
   // Functions to access data about the target
   virtual vector <CoreId>::iterator coreIdBegin () = 0;
   virtual vector <CoreId>::iterator coreIdEnd () = 0;
@@ -261,6 +270,10 @@ public:
   virtual void startOfBaudMeasurement ();
   virtual double endOfBaudMeasurement ();
 
+  // Serialize sequences of target accesses between threads
+  void lock ();
+  void unlock ();
+
 protected:
 
   virtual string getTargetId () = 0;
@@ -271,6 +284,9 @@ private:
   //! The start time
   struct timeval startTime;
 
+  //! Held by whoever is working on the target, see lock ()
+  pthread_mutex_t mAccessLock;
+
 };
 
 #endif	// TARGET_CONTROL__H
@@ -310,6 +310,102 @@ TargetControlHardware::readBurst (CoreId coreId,
 }	// readBurst ()
 
 
+//! Read the same 32-bit word from several cores
+
+//! All the reads are handed to e_read_v in one batch, so the HAL can do them
+//! in a single sweep. Any core outside the chip falls back to the one at a
+//! time default.
+
+//! @param[in]  coreIds  Relative IDs of the cores to read.
+//! @param[in]  addr     Local address to read on each core.
+//! @param[out] data     The values read, one per core, in order.
+//! @return  true if all reads succeeded, false otherwise.
+bool
+TargetControlHardware::readMem32Multi (const vector <CoreId>& coreIds,
+				       uint32_t addr,
+				       vector <uint32_t>& data)
+{
+  size_t n = coreIds.size ();
+  vector <e_iovec_t> iov (n);
+
+  data.resize (n);
+  if (n == 0)
+    return true;
+
+  for (size_t i = 0; i < n; i++)
+    {
+      unsigned row, col, offset;
+      uint32_t fullAddr = convertAddress (coreIds[i], addr);
+
+      if (!addrToCoords (fullAddr, row, col, offset))
+	return TargetControl::readMem32Multi (coreIds, addr, data);
+
+      iov[i].dev = &mDev;
+      iov[i].row = row;
+      iov[i].col = col;
+      iov[i].addr = offset;
+      iov[i].buf = &data[i];
+      iov[i].size = E_WORD_BYTES;
+    }
+
+  if (si->debugTargetWr ())
+    cerr << "DebugTargetWr: readMem32Multi (" << n << " cores, 0x"
+	 << intStr (addr, 16, 8) << ")" << endl;
+
+  return e_read_v (&iov[0], n) == (ssize_t) (n * E_WORD_BYTES);
+
+}	// readMem32Multi ()
+
+
+//! Read many registers of one core at once
+
+//! The whole register file is read with e_read_regs, so the HAL can fetch it
+//! a block at a time. Registers which are not part of the snapshot, and
+//! cores outside the chip, fall back to the one at a time default.
+
+//! @param[in]  coreId  Relative ID of the core to read.
+//! @param[in]  addrs   Register addresses to read.
+//! @param[out] data    The values read, one per register, in order.
+//! @param[out] valid   Whether each register could be read.
+void
+TargetControlHardware::readRegs (CoreId coreId,
+				 const vector <uint32_t>& addrs,
+				 vector <uint32_t>& data,
+				 vector <bool>& valid)
+{
+  unsigned row, col, offset;
+  e_core_regs_t regs;
+  uint32_t fullAddr = convertAddress (coreId, R0);
+
+  if (!addrToCoords (fullAddr, row, col, offset)
+      || (e_read_regs (&mDev, row, col, E_REGS_ALL, &regs) != E_OK))
+    {
+      TargetControl::readRegs (coreId, addrs, data, valid);
+      return;
+    }
+
+  if (si->debugTargetWr ())
+    cerr << "DebugTargetWr: readRegs (" << coreId << ", " << addrs.size ()
+	 << " registers)" << endl;
+
+  data.resize (addrs.size ());
+  valid.resize (addrs.size ());
+
+  for (size_t i = 0; i < addrs.size (); i++)
+    {
+      unsigned *reg = e_core_reg (&regs, addrs[i]);
+
+      if (reg)
+	{
+	  data[i] = *reg;
+	  valid[i] = true;
+	}
+      else
+	valid[i] = readMem32 (coreId, addrs[i], data[i]);
+    }
+}	// readRegs ()
+
+
 //! Burst write
 
 //! @param[in] addr     Address to write to (full or local)
@@ -73,6 +73,10 @@ public:
 			   size_t buff_size);
   virtual bool readBurst (CoreId coreId, uint32_t addr, uint8_t *buf,
 			  size_t buff_size);
+  virtual bool readMem32Multi (const vector <CoreId>& coreIds, uint32_t addr,
+			       vector <uint32_t>& data);
+  virtual void readRegs (CoreId coreId, const vector <uint32_t>& addrs,
+			 vector <uint32_t>& data, vector <bool>& valid);
 
   // Functions to access data about the target
   virtual vector <CoreId>::iterator  coreIdBegin ();
@@ -706,6 +706,29 @@ Thread::readReg (unsigned int regnum) const
 }	// readReg ()
 
 
+//-----------------------------------------------------------------------------
+//! Read the values of all Epiphany registers from hardware
+
+//! The target is asked for the whole register file in one go, which is much
+//! cheaper than reading the registers one at a time.
+
+//! @param[out] regvals  The values read, indexed by GDB register number
+//! @param[out] valid    Whether each register could be read
+//-----------------------------------------------------------------------------
+void
+Thread::readAllRegs (vector <uint32_t>& regvals,
+		     vector <bool>& valid) const
+{
+  vector <uint32_t> addrs (GdbServer::NUM_REGS);
+
+  for (unsigned int r = 0; r < GdbServer::NUM_REGS; r++)
+    addrs[r] = regAddr (r);
+
+  mTarget->readRegs (mCoreId, addrs, regvals, valid);
+
+}	// readAllRegs ()
+
+
 //-----------------------------------------------------------------------------
 //! Write the value of an Epiphany register to hardware
 
@@ -121,6 +121,8 @@ public:
   bool readReg (unsigned int regnum,
 		uint32_t& regval) const;
   uint32_t  readReg (unsigned int regnum) const;
+  void readAllRegs (vector <uint32_t>& regvals,
+		    vector <bool>& valid) const;
   bool writeReg (unsigned int regNum,
 		 uint32_t value) const;
 
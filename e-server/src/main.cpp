@@ -98,7 +98,7 @@ usage_summary (ostream& s)
     << endl;
   s << "         [-d <debug-level>] [--hal-debug <level> [--check-hw-address]"
     << endl;
-  s << "         [--dont-halt-on-attach] "
+  s << "         [--dont-halt-on-attach] [--sample-ctimers]"
     << endl;
   s << "         [-Wpl,<options>] [-Xpl <arg>]"
     << endl;
@@ -207,6 +207,16 @@ usage_full (ostream& s)
   s << "    Use this option to disable this automatic attachment."  << endl;
   s << endl;
 
+  s << "  --sample-ctimers" << endl;
+  s << endl;
+  s << "    Measure the core load reported by 'info os load' by counting"
+    << endl;
+  s << "    clock and idle cycles in CTIMER0 and CTIMER1. This is more" << endl;
+  s << "    accurate than the default sampling of the STATUS register, but"
+    << endl;
+  s << "    overwrites any timer settings made by the application." << endl;
+  s << endl;
+
   s << "  -Wpl <options>" << endl;
   s << endl;
   s << "    Pass comma-separated <options> on to the platform driver."
@@ -468,6 +478,8 @@ main (int argc, char *argv[])
 	{
 	  si->multiProcess (true);
 	}
+      else if (!strcmp (argv[n], "--sample-ctimers"))
+	si->sampleCtimers (true);
       else if (!strcmp (argv[n], "-d"))
 	{
 	  n += 1;
@@ -0,0 +1,188 @@
+/*
+  e-barrier-bench.c
+
+  Copyright (C) 2026 Adapteva, Inc.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program, see the file COPYING.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* Host side of the e-lib barrier benchmark. Loads the device program built
+ * by 'make check' in e-lib (bench/e-barrier-bench.elf) on a group and
+ * prints the cycles per barrier each kind of barrier took, as the minimum,
+ * mean and maximum over the cores. Works with EHAL_TARGET=esim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "e-hal.h"
+#include "e-loader.h"
+
+#define SHM_NAME "e_barrier_bench"
+
+/* Must match bench/e-barrier-bench.c in e-lib */
+enum { BAR_FLIPFLOP, BAR_TREE, BAR_DISS, BAR_HW, BAR_KINDS };
+
+typedef struct {
+	unsigned done;
+	unsigned iterations;
+	unsigned cycles[BAR_KINDS];
+} bench_result_t;
+
+static const char *bar_names[BAR_KINDS] = {
+	[BAR_FLIPFLOP] = "e_barrier",
+	[BAR_TREE]	   = "e_barrier_tree",
+	[BAR_DISS]	   = "e_barrier_diss",
+	[BAR_HW]	   = "e_barrier_hw",
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-r rows] [-c cols] [-t timeout-sec] "
+			"e-barrier-bench.elf\n", prog);
+}
+
+/* Wait for all cores to post their results */
+static int wait_results(e_mem_t *shm, bench_result_t *res, unsigned ncores,
+						unsigned timeout)
+{
+	struct timespec nap = { 0, 1000000 };
+	time_t deadline;
+	unsigned i;
+
+	deadline = time(NULL) + timeout;
+	for (;;) {
+		if (e_read(shm, 0, 0, 0, res, ncores * sizeof(*res)) == E_ERR)
+			return E_ERR;
+
+		for (i = 0; i < ncores && res[i].done; i++)
+			;
+		if (i == ncores)
+			return E_OK;
+
+		if (time(NULL) > deadline) {
+			fprintf(stderr, "Timed out, core %u did not finish\n", i);
+			return E_ERR;
+		}
+		nanosleep(&nap, NULL);
+	}
+}
+
+static void print_results(bench_result_t *res, unsigned ncores)
+{
+	unsigned kind, i, min, max;
+	double sum;
+
+	printf("%u cores, %u barriers each\n", ncores, res[0].iterations);
+	printf("%-16s %10s %10s %10s\n", "barrier", "min", "mean", "max");
+
+	for (kind = 0; kind < BAR_KINDS; kind++) {
+		min = ~0u;
+		max = 0;
+		sum = 0;
+		for (i = 0; i < ncores; i++) {
+			if (res[i].cycles[kind] < min)
+				min = res[i].cycles[kind];
+			if (res[i].cycles[kind] > max)
+				max = res[i].cycles[kind];
+			sum += res[i].cycles[kind];
+		}
+		printf("%-16s %10u %10.0f %10u\n", bar_names[kind], min,
+			   sum / ncores, max);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	e_platform_t platform;
+	e_epiphany_t dev;
+	e_mem_t shm;
+	bench_result_t *res;
+	unsigned rows = 0, cols = 0, timeout = 60, ncores;
+	int opt, rc = EXIT_FAILURE;
+
+	while ((opt = getopt(argc, argv, "r:c:t:h")) != -1) {
+		switch (opt) {
+		case 'r': rows = strtoul(optarg, NULL, 0); break;
+		case 'c': cols = strtoul(optarg, NULL, 0); break;
+		case 't': timeout = strtoul(optarg, NULL, 0); break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (E_OK != e_init(NULL)) {
+		fprintf(stderr, "Epiphany HAL initialization failed\n");
+		return EXIT_FAILURE;
+	}
+
+	e_get_platform_info(&platform);
+	if (!rows)
+		rows = platform.rows;
+	if (!cols)
+		cols = platform.cols;
+	ncores = rows * cols;
+
+	res = calloc(ncores, sizeof(*res));
+	if (!res) {
+		perror("calloc");
+		goto out_finalize;
+	}
+
+	if (E_OK != e_reset_system()) {
+		fprintf(stderr, "e_reset_system failed\n");
+		goto out_free;
+	}
+
+	if (E_OK != e_shm_alloc(&shm, SHM_NAME, ncores * sizeof(*res))) {
+		perror("e_shm_alloc");
+		goto out_free;
+	}
+	e_write(&shm, 0, 0, 0, res, ncores * sizeof(*res));
+
+	if (E_OK != e_open(&dev, 0, 0, rows, cols)) {
+		fprintf(stderr, "e_open failed\n");
+		goto out_release;
+	}
+
+	if (E_OK != e_load_group(argv[optind], &dev, 0, 0, rows, cols, E_TRUE)) {
+		fprintf(stderr, "Failed to load %s\n", argv[optind]);
+		goto out_close;
+	}
+
+	if (E_OK == wait_results(&shm, res, ncores, timeout)) {
+		print_results(res, ncores);
+		rc = EXIT_SUCCESS;
+	}
+
+out_close:
+	e_close(&dev);
+out_release:
+	e_shm_release(SHM_NAME);
+out_free:
+	free(res);
+out_finalize:
+	e_finalize();
+
+	return rc;
+}
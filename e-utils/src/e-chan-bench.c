@@ -0,0 +1,245 @@
+/*
+  e-chan-bench.c
+
+  Copyright (C) 2026 Adapteva, Inc.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program, see the file COPYING.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "e-hal.h"
+
+static size_t   slot_size = 64;
+static unsigned depth     = 1024;
+static unsigned batch     = 32;
+static unsigned long count = 1000000;
+static unsigned long pings = 100000;
+
+static unsigned long errors;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Spin for a while on an empty or full ring, then let the other end run
+ * in case both share a CPU */
+static void backoff(unsigned *idle)
+{
+	struct timespec nap = { 0, 1000 };
+
+	if (++*idle >= 1000)
+		nanosleep(&nap, NULL);
+}
+
+/* Each end needs its own handle, so the threads open their own */
+static void *stream_consumer(void *arg)
+{
+	e_chan_t end, *chan = &end;
+	unsigned long seq = 0;
+	unsigned n, i, idle = 0;
+	void *slots;
+
+	if (E_OK != e_chan_open(chan, (const char *) arg)) {
+		perror("e_chan_open");
+		errors = count;
+		return NULL;
+	}
+
+	while (seq < count) {
+		n = e_chan_peek(chan, &slots, batch);
+		if (!n) {
+			backoff(&idle);
+			continue;
+		}
+		idle = 0;
+		for (i = 0; i < n; i++, seq++) {
+			if (*(uint64_t *) ((uint8_t *) slots + i * slot_size) != seq)
+				errors++;
+		}
+		e_chan_consume(chan, n);
+	}
+
+	e_chan_close(chan);
+	return NULL;
+}
+
+static int stream_test(void)
+{
+	e_chan_t chan;
+	pthread_t consumer;
+	unsigned long seq = 0;
+	unsigned n, i, idle = 0;
+	uint64_t start, ns;
+	void *slots;
+
+	if (E_OK != e_chan_create(&chan, "e-chan-bench-stream", slot_size, depth)) {
+		perror("e_chan_create");
+		return -1;
+	}
+
+	start = now_ns();
+	pthread_create(&consumer, NULL, stream_consumer, "e-chan-bench-stream");
+
+	while (seq < count) {
+		n = e_chan_reserve(&chan, &slots, batch);
+		if (!n) {
+			backoff(&idle);
+			continue;
+		}
+		idle = 0;
+		if (n > count - seq)
+			n = count - seq;
+		for (i = 0; i < n; i++, seq++)
+			*(uint64_t *) ((uint8_t *) slots + i * slot_size) = seq;
+		e_chan_commit(&chan, n);
+	}
+
+	pthread_join(consumer, NULL);
+	ns = now_ns() - start;
+	e_chan_close(&chan);
+
+	printf("stream:  %lu slots of %zu bytes, depth %u, batch %u\n",
+		   count, slot_size, depth, batch);
+	printf("         %.2f Mslots/s, %.1f MB/s, %lu errors\n",
+		   count * 1e3 / ns, count * slot_size * 1e3 / ns, errors);
+
+	return errors ? -1 : 0;
+}
+
+static void *ping_echo(void *arg)
+{
+	e_chan_t chans[2];
+	uint64_t v;
+	unsigned long i;
+
+	(void) arg;
+	if (E_OK != e_chan_open(&chans[0], "e-chan-bench-ping") ||
+		E_OK != e_chan_open(&chans[1], "e-chan-bench-pong")) {
+		perror("e_chan_open");
+		return NULL;
+	}
+
+	for (i = 0; i < pings; i++) {
+		e_chan_recv(&chans[0], &v, sizeof(v), E_CHAN_FOREVER);
+		e_chan_send(&chans[1], &v, sizeof(v), E_CHAN_FOREVER);
+	}
+
+	e_chan_close(&chans[0]);
+	e_chan_close(&chans[1]);
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int ping_test(void)
+{
+	e_chan_t chans[2];
+	pthread_t echo;
+	uint64_t *rtt, v, start;
+	double total = 0;
+	unsigned long i;
+
+	rtt = malloc(pings * sizeof(*rtt));
+	if (!rtt ||
+		E_OK != e_chan_create(&chans[0], "e-chan-bench-ping", 8, 2) ||
+		E_OK != e_chan_create(&chans[1], "e-chan-bench-pong", 8, 2)) {
+		perror("e_chan_create");
+		return -1;
+	}
+
+	pthread_create(&echo, NULL, ping_echo, NULL);
+
+	for (i = 0; i < pings; i++) {
+		start = now_ns();
+		e_chan_send(&chans[0], &i, sizeof(i), E_CHAN_FOREVER);
+		e_chan_recv(&chans[1], &v, sizeof(v), E_CHAN_FOREVER);
+		rtt[i] = now_ns() - start;
+		total += rtt[i];
+		if (v != i)
+			errors++;
+	}
+
+	pthread_join(echo, NULL);
+	e_chan_close(&chans[0]);
+	e_chan_close(&chans[1]);
+
+	qsort(rtt, pings, sizeof(*rtt), cmp_u64);
+	printf("latency: %lu round trips\n", pings);
+	printf("         avg %.0f ns, p50 %llu ns, p99 %llu ns, max %llu ns\n",
+		   total / pings, (unsigned long long) rtt[pings / 2],
+		   (unsigned long long) rtt[pings * 99 / 100],
+		   (unsigned long long) rtt[pings - 1]);
+	free(rtt);
+
+	return errors ? -1 : 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-s slot-size] [-d depth] [-b batch] "
+			"[-n slots] [-p round-trips]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "s:d:b:n:p:h")) != -1) {
+		switch (opt) {
+		case 's': slot_size = strtoul(optarg, NULL, 0); break;
+		case 'd': depth = strtoul(optarg, NULL, 0); break;
+		case 'b': batch = strtoul(optarg, NULL, 0); break;
+		case 'n': count = strtoul(optarg, NULL, 0); break;
+		case 'p': pings = strtoul(optarg, NULL, 0); break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (slot_size < sizeof(uint64_t) || !batch || !pings) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	slot_size = (slot_size + 7) & ~(size_t) 7;
+
+	if (E_OK != e_init(NULL)) {
+		fprintf(stderr, "Epiphany HAL initialization failed\n");
+		return EXIT_FAILURE;
+	}
+
+	if (stream_test() || ping_test())
+		rc = EXIT_FAILURE;
+
+	e_finalize();
+
+	return rc;
+}
@@ -0,0 +1,380 @@
+/*
+  e-copy-check.c
+
+  Copyright (C) 2026 Adapteva, Inc.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program, see the file COPYING.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* Checks e_read() and e_write() of core SRAM and external memory for every
+ * pair of host and device alignments and every size up to MAX_SIZE, which
+ * covers all head, body and tail combinations of the host copy engine.
+ *
+ * Then times both for every alignment pair on blocks of -s bytes and
+ * reports the throughput next to that of the copy loop e-hal used before
+ * (old_memcpy() below) on the same mapping. The e_read() and e_write()
+ * figures include the call overhead, so small blocks favour the old loop.
+ *
+ * External memory is tested in a scratch shared memory region, so nothing
+ * the cores use is overwritten. With EHAL_TARGET=mem it runs without
+ * hardware. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "e-hal.h"
+
+#define MAX_SIZE  64
+#define GUARD     8
+#define WINDOW    (GUARD + 8 + MAX_SIZE + GUARD)
+#define SHM_NAME  "e-copy-check"
+
+static off_t    base    = 0x4000;
+static size_t   bench_size  = 4096;
+static unsigned bench_iters = 0;	/* 0: about 4 MB per measurement */
+static int      verbose = 0;
+
+static unsigned long checks, failures;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The host copy loop of e-hal before the head, body and tail engine. It
+ * picks one access width for the whole buffer from the relative alignment
+ * of both pointers. */
+static void *old_memcpy(void *__restrict__ dst, const void *__restrict__ src,
+						size_t size)
+{
+	size_t n, aligned_n;
+	uint8_t *d;
+	const uint8_t *s;
+
+	n = size;
+	d = (uint8_t *) dst;
+	s = (const uint8_t *) src;
+
+	if (!(((uintptr_t) d ^ (uintptr_t) s) & 3)) {
+		/* dst and src are evenly WORD (un-)aligned */
+
+		/* Align by WORD */
+		if (n && (((uintptr_t) d) & 1)) {
+			*d++ = *s++; n--;
+		}
+		if (((uintptr_t) d) & 2) {
+			if (n > 1) {
+				*((uint16_t *) d) = *((const uint16_t *) s);
+				d+=2; s+=2; n-=2;
+			} else if (n==1) {
+				*d++ = *s++; n--;
+			}
+		}
+
+		aligned_n = n & (~3);
+		memcpy((void *) d, (void *) s, aligned_n);
+		d += aligned_n; s += aligned_n; n -= aligned_n;
+
+		/* Copy remainder in largest possible chunks */
+		switch (n) {
+		case 2:
+			*((uint16_t *) d) = *((const uint16_t *) s);
+			d+=2; s+=2; n-=2;
+			break;
+		case 3:
+			*((uint16_t *) d) = *((const uint16_t *) s);
+			d+=2; s+=2; n-=2;
+			/* fall through */
+		case 1:
+			*d++ = *s++; n--;
+		}
+	} else if (!(((uintptr_t) d ^ (uintptr_t) s) & 1)) {
+		/* dst and src are evenly half-WORD (un-)aligned */
+
+		/* Align by half-WORD */
+		if (n && ((uintptr_t) d) & 1) {
+			*d++ = *s++; n--;
+		}
+
+		while (n > 1) {
+			*((uint16_t *) d) = *((const uint16_t *) s);
+			d+=2; s+=2; n-=2;
+		}
+
+		/* Copy remaining byte */
+		if (n) {
+			*d++ = *s++; n--;
+		}
+	} else {
+		/* Resort to single byte copying */
+		while (n) {
+			*d++ = *s++; n--;
+		}
+	}
+
+	assert(n == 0);
+
+	return dst;
+}
+
+static void fill(uint8_t *buf, size_t size, unsigned seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = (uint8_t) (seed * 131 + i * 7 + 1);
+}
+
+static void fail(const char *what, const char *op, unsigned dev_align,
+				 unsigned host_align, size_t size)
+{
+	failures++;
+	if (verbose || failures <= 10)
+		printf("FAIL: %s: %s of %zu bytes, device offset %u, host offset %u\n",
+			   what, op, size, dev_align, host_align);
+}
+
+/* Write and read back size bytes at base + GUARD + dev_align from a host
+ * buffer at host_align, checking that nothing around them changed. */
+static void check_one(void *dev, unsigned row, unsigned col, const char *what,
+					  unsigned dev_align, unsigned host_align, size_t size)
+{
+	uint64_t hostbuf[(MAX_SIZE + 2 * GUARD) / 8 + 2];
+	uint8_t  model[WINDOW], back[WINDOW], *host;
+	off_t    at = GUARD + dev_align;
+	size_t   i;
+
+	host = (uint8_t *) hostbuf + GUARD + host_align;
+
+	/* Write */
+	fill(model, WINDOW, size + dev_align);
+	fill(host, size, size * 8 + host_align + 1000);
+	if (e_write(dev, row, col, base, model, WINDOW) != WINDOW ||
+		e_write(dev, row, col, base + at, host, size) != (ssize_t) size) {
+		fail(what, "e_write", dev_align, host_align, size);
+		return;
+	}
+	memcpy(&model[at], host, size);
+
+	checks++;
+	if (e_read(dev, row, col, base, back, WINDOW) != WINDOW ||
+		memcmp(back, model, WINDOW))
+		fail(what, "e_write", dev_align, host_align, size);
+
+	/* Read */
+	memset(hostbuf, 0x5a, sizeof(hostbuf));
+	checks++;
+	if (e_read(dev, row, col, base + at, host, size) != (ssize_t) size ||
+		memcmp(host, &model[at], size)) {
+		fail(what, "e_read", dev_align, host_align, size);
+		return;
+	}
+	for (i = 0; i < GUARD; i++) {
+		if (host[-1 - (ssize_t) i] != 0x5a || host[size + i] != 0x5a) {
+			fail(what, "e_read (overrun)", dev_align, host_align, size);
+			return;
+		}
+	}
+}
+
+static int check(void *dev, unsigned row, unsigned col, const char *what)
+{
+	unsigned long before = failures;
+	unsigned dev_align, host_align;
+	size_t size;
+
+	checks = 0;
+	for (dev_align = 0; dev_align < 8; dev_align++)
+		for (host_align = 0; host_align < 8; host_align++)
+			for (size = 0; size < MAX_SIZE; size++)
+				check_one(dev, row, col, what, dev_align, host_align, size);
+
+	printf("%s: %lu checks, %lu failures\n", what, checks, failures - before);
+
+	return failures == before ? 0 : -1;
+}
+
+static double mb_per_s(uint64_t bytes, uint64_t ns)
+{
+	return ns ? bytes * 1e3 / ns : 0.0;
+}
+
+/* Time e_write() and e_read() of bench_size bytes against old_memcpy() on
+ * mapped, the host view of offset base of dev, for every alignment pair */
+static int bench(void *dev, unsigned row, unsigned col, uint8_t *mapped,
+				 const char *what)
+{
+	uint8_t  *hostbuf, *host, *dst;
+	unsigned  dev_align, host_align, i, iters;
+	uint64_t  t0, t_write, t_read, t_old_write, t_old_read, bytes;
+	double    sum_new = 0, sum_old = 0;
+
+	hostbuf = malloc(bench_size + 16);
+	if (!hostbuf)
+		return -1;
+	fill(hostbuf, bench_size + 16, 1);
+
+	iters = bench_iters ? bench_iters : (4 << 20) / bench_size + 1;
+	bytes = (uint64_t) iters * bench_size;
+
+	printf("%s: %zu byte blocks, %u iterations, MB/s\n", what, bench_size, iters);
+	printf("  dev host     e_write   old write      e_read    old read\n");
+
+	for (dev_align = 0; dev_align < 8; dev_align++) {
+		for (host_align = 0; host_align < 8; host_align++) {
+			host = hostbuf + host_align;
+			dst  = mapped + dev_align;
+
+			t0 = now_ns();
+			for (i = 0; i < iters; i++)
+				if (e_write(dev, row, col, base + dev_align, host, bench_size)
+					!= (ssize_t) bench_size)
+					goto fail;
+			t_write = now_ns() - t0;
+
+			t0 = now_ns();
+			for (i = 0; i < iters; i++)
+				old_memcpy(dst, host, bench_size);
+			t_old_write = now_ns() - t0;
+
+			t0 = now_ns();
+			for (i = 0; i < iters; i++)
+				if (e_read(dev, row, col, base + dev_align, host, bench_size)
+					!= (ssize_t) bench_size)
+					goto fail;
+			t_read = now_ns() - t0;
+
+			t0 = now_ns();
+			for (i = 0; i < iters; i++)
+				old_memcpy(host, dst, bench_size);
+			t_old_read = now_ns() - t0;
+
+			printf("  %3u %4u  %10.1f  %10.1f  %10.1f  %10.1f\n",
+				   dev_align, host_align,
+				   mb_per_s(bytes, t_write), mb_per_s(bytes, t_old_write),
+				   mb_per_s(bytes, t_read), mb_per_s(bytes, t_old_read));
+
+			sum_new += mb_per_s(bytes, t_write) + mb_per_s(bytes, t_read);
+			sum_old += mb_per_s(bytes, t_old_write) + mb_per_s(bytes, t_old_read);
+		}
+	}
+
+	printf("%s: mean %.1f MB/s, old loop %.1f MB/s\n", what,
+		   sum_new / 128, sum_old / 128);
+	free(hostbuf);
+
+	return 0;
+
+fail:
+	printf("FAIL: %s: copy of %zu bytes failed\n", what, bench_size);
+	free(hostbuf);
+
+	return -1;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-a address] [-s bench-size] [-i iterations] "
+			"[-v]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	e_platform_t platform;
+	e_epiphany_t dev;
+	e_mem_t      emem;
+	size_t       span;
+	unsigned     rows, row;
+	char         what[32];
+	int          opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "a:s:i:vh")) != -1) {
+		switch (opt) {
+		case 'a': base = strtoul(optarg, NULL, 0); break;
+		case 's': bench_size = strtoul(optarg, NULL, 0); break;
+		case 'i': bench_iters = strtoul(optarg, NULL, 0); break;
+		case 'v': verbose = 1; break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (!bench_size) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Bytes used past base */
+	span = (bench_size + 8 > WINDOW) ? bench_size + 8 : WINDOW;
+
+	if (E_OK != e_init(NULL)) {
+		fprintf(stderr, "Epiphany HAL initialization failed\n");
+		return EXIT_FAILURE;
+	}
+
+	if (E_OK != e_get_platform_info(&platform)) {
+		fprintf(stderr, "Failed to get Epiphany platform info\n");
+		e_finalize();
+		return EXIT_FAILURE;
+	}
+
+	/* Rows 1 and 2 of the E64G401 are read without bursting */
+	rows = platform.rows < 3 ? platform.rows : 3;
+	if (E_OK != e_open(&dev, 0, 0, rows, 1)) {
+		fprintf(stderr, "Failed to open Epiphany workgroup\n");
+		e_finalize();
+		return EXIT_FAILURE;
+	}
+
+	for (row = 0; row < rows; row++) {
+		snprintf(what, sizeof(what), "core (%u,0)", row);
+		if (check(&dev, row, 0, what))
+			rc = EXIT_FAILURE;
+	}
+
+	if (base + span > dev.core[0][0].mems.map_size) {
+		fprintf(stderr, "Benchmark blocks don't fit in core SRAM\n");
+		rc = EXIT_FAILURE;
+	} else if (bench(&dev, 0, 0, (uint8_t *) dev.core[0][0].mems.base + base,
+					 "core (0,0)")) {
+		rc = EXIT_FAILURE;
+	}
+
+	e_close(&dev);
+
+	if (E_OK != e_shm_alloc(&emem, SHM_NAME, base + span)) {
+		fprintf(stderr, "Failed to allocate shared memory region\n");
+		rc = EXIT_FAILURE;
+	} else {
+		if (check(&emem, 0, 0, "external memory"))
+			rc = EXIT_FAILURE;
+		if (bench(&emem, 0, 0, (uint8_t *) emem.base + base, "external memory"))
+			rc = EXIT_FAILURE;
+		e_shm_release(SHM_NAME);
+	}
+
+	e_finalize();
+
+	return rc;
+}
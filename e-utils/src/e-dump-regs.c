@@ -97,39 +97,31 @@ void print_header()
 	printf("%-40s\n", tmp);
 }
 
-void dump_gprs(e_epiphany_t *dev)
+void dump_gprs(e_core_regs_t *regs)
 {
 	uint32_t i;
-	uint32_t regs[64];
-
-	memset(regs, 0x13, sizeof(regs));
-
-	for (i = 0; i <= E_REG_R63 - E_REG_R0; i += 4)
-		e_read(dev, 0, 0, E_REG_R0 + i, &regs[i / 4], 4);
 
 	for (i = 0; i < 64; i++)
-		printf("r%-2d%9s\t0x%08x\n", i, " ", regs[i]);
+		printf("r%-2d%9s\t0x%08x\n", i, " ", regs->gpr[i]);
 }
 
-void dump_scrs(e_epiphany_t *dev)
+void dump_scrs(e_core_regs_t *regs)
 {
 	uint32_t i;
-	uint32_t regs[1 + (E_REG_RMESHROUTE - E_REG_CONFIG) / 4];
-
-	memset(regs, 0x13, sizeof(regs));
+	unsigned *reg;
 
-	for (i = 0; i <= E_REG_RMESHROUTE - E_REG_CONFIG; i += 4)
-		e_read(dev, 0, 0, E_REG_CONFIG + i, &regs[i / 4], 4);
-
-	for (i = 0; i <= E_REG_RMESHROUTE - E_REG_CONFIG; i += 4)
-		if (scr_names[i])
-			printf("%-12s\t0x%08x\n", scr_names[i], regs[i / 4]);
+	for (i = 0; i <= E_REG_RMESHROUTE - E_REG_CONFIG; i += 4) {
+		reg = e_core_reg(regs, E_REG_CONFIG + i);
+		if (scr_names[i] && reg)
+			printf("%-12s\t0x%08x\n", scr_names[i], *reg);
+	}
 }
 
 int main(int argc, char *argv[])
 {
 	bool scr_only = false;
 	e_epiphany_t dev;
+	e_core_regs_t regs;
 	e_platform_t platform;
 	int row, col, arg = 1;
 
@@ -150,12 +142,15 @@ int main(int argc, char *argv[])
 	e_get_platform_info(&platform);
 	e_open(&dev, row, col, 1, 1);
 
+	memset(&regs, 0x13, sizeof(regs));
+	e_read_regs(&dev, 0, 0, scr_only ? E_REGS_SCR : E_REGS_ALL, &regs);
+
 	print_header();
 
 	if (!scr_only)
-		dump_gprs(&dev);
+		dump_gprs(&regs);
 
-	dump_scrs(&dev);
+	dump_scrs(&regs);
 
 	e_close(&dev);
 	e_finalize();
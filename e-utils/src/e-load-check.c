@@ -0,0 +1,191 @@
+/*
+  e-load-check.c
+
+  Copyright (C) 2026 Adapteva, Inc.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program, see the file COPYING.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* Checks diff loading (EHAL_LOAD_DIFF). An executable is loaded to a
+ * workgroup twice, which sets up the shadow and measures a warm load. After
+ * closing and reopening the workgroup, another load of the unchanged image
+ * must write no more than the warm load did, i.e. only the writable
+ * segments, and leave SRAM as the warm load did. Finally SRAM is overwritten
+ * with e_write() and the next load must restore it.
+ * With EHAL_TARGET=mem it runs without hardware. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "e-hal.h"
+#include "e-loader.h"
+
+static unsigned rows = 1, cols = 1;
+static size_t   sram_size;
+
+/* Bytes written to core SRAM since the last call */
+static uint64_t written()
+{
+	e_op_stats_t stats;
+	uint64_t     bytes = 0;
+	int          target;
+
+	for (target = 0; target < E_TARGET_NUM; target++)
+		if (e_get_op_stats(target, E_OP_T_WRITE_BUF, &stats) == E_OK)
+			bytes += stats.bytes;
+	e_reset_stats();
+
+	return bytes;
+}
+
+static int load(const char *executable, e_epiphany_t *dev, const char *what,
+				uint64_t *bytes)
+{
+	written();
+	if (E_OK != e_load_group(executable, dev, 0, 0, rows, cols, E_FALSE)) {
+		fprintf(stderr, "%s: failed to load %s\n", what, executable);
+		return -1;
+	}
+	*bytes = written();
+	printf("%s: wrote %llu of %llu SRAM bytes\n", what, (unsigned long long) *bytes,
+		   (unsigned long long) sram_size * rows * cols);
+
+	return 0;
+}
+
+static int snapshot(e_epiphany_t *dev, uint8_t *buf)
+{
+	unsigned row, col;
+
+	for (row = 0; row < rows; row++)
+		for (col = 0; col < cols; col++, buf += sram_size)
+			if (e_read(dev, row, col, 0, buf, sram_size) != (ssize_t) sram_size)
+				return -1;
+
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-r rows] [-c cols] executable\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	e_epiphany_t dev;
+	const char  *executable;
+	uint8_t     *warm = NULL, *back = NULL, *junk = NULL;
+	uint64_t     cold_bytes, warm_bytes, bytes;
+	unsigned     row, col;
+	int          opt, rc = EXIT_FAILURE;
+
+	while ((opt = getopt(argc, argv, "r:c:h")) != -1) {
+		switch (opt) {
+		case 'r': rows = strtoul(optarg, NULL, 0); break;
+		case 'c': cols = strtoul(optarg, NULL, 0); break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	executable = argv[optind];
+
+	setenv("EHAL_LOAD_DIFF", "1", 1);
+	/* Written bytes are taken from the operation statistics */
+	if (!getenv("EHAL_STATS")) {
+		setenv("EHAL_STATS", "1", 1);
+		setenv("EHAL_STATS_FILE", "/dev/null", 1);
+	}
+
+	if (E_OK != e_init(NULL)) {
+		fprintf(stderr, "Epiphany HAL initialization failed\n");
+		return EXIT_FAILURE;
+	}
+
+	e_reset_system();
+
+	if (E_OK != e_open(&dev, 0, 0, rows, cols)) {
+		fprintf(stderr, "Failed to open Epiphany workgroup\n");
+		goto out;
+	}
+	sram_size = dev.core[0][0].mems.map_size;
+
+	warm = malloc(sram_size * rows * cols);
+	back = malloc(sram_size * rows * cols);
+	junk = malloc(sram_size);
+	if (!warm || !back || !junk) {
+		fprintf(stderr, "Out of memory\n");
+		goto close;
+	}
+	memset(junk, 0xa5, sram_size);
+
+	if (load(executable, &dev, "cold load", &cold_bytes) ||
+		load(executable, &dev, "warm load", &warm_bytes) ||
+		snapshot(&dev, warm)) {
+		e_close(&dev);
+		goto out;
+	}
+	e_close(&dev);
+
+	if (E_OK != e_open(&dev, 0, 0, rows, cols)) {
+		fprintf(stderr, "Failed to reopen Epiphany workgroup\n");
+		goto out;
+	}
+	if (load(executable, &dev, "load after reopen", &bytes) || snapshot(&dev, back))
+		goto close;
+	if (warm_bytes >= cold_bytes) {
+		printf("FAIL: warm load skipped nothing, is %s diff loaded?\n", executable);
+		goto close;
+	}
+	if (bytes > warm_bytes) {
+		printf("FAIL: load after reopen wrote %llu bytes, warm load %llu\n",
+			   (unsigned long long) bytes, (unsigned long long) warm_bytes);
+		goto close;
+	}
+	if (memcmp(back, warm, sram_size * rows * cols)) {
+		printf("FAIL: SRAM differs after load after reopen\n");
+		goto close;
+	}
+
+	for (row = 0; row < rows; row++)
+		for (col = 0; col < cols; col++)
+			e_write(&dev, row, col, 0, junk, sram_size);
+	if (load(executable, &dev, "load after e_write", &bytes) || snapshot(&dev, back))
+		goto close;
+	if (memcmp(back, warm, sram_size * rows * cols)) {
+		printf("FAIL: SRAM differs after load after e_write\n");
+		goto close;
+	}
+
+	printf("PASS\n");
+	rc = EXIT_SUCCESS;
+
+close:
+	e_close(&dev);
+out:
+	free(warm);
+	free(back);
+	free(junk);
+	e_finalize();
+
+	return rc;
+}